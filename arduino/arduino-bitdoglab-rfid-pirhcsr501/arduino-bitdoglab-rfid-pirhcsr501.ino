@@ -2,39 +2,152 @@
  Access Control System (PIR Activated RFID)
  Implements a timeout to keep the RFID reader active after motion stops.
  Sends data to BitDogLab via Serial
+ The PIR is handled by a pin-change interrupt and the RFID reader by a
+ millis()-based cooperative scheduler, so loop() never blocks on delay().
 *******************************************************************************/
 
 // RFID Libraries
 #include <MFRC522.h>
 #include <SPI.h>
+#include <UidFrame.h> // arduino/libraries/UidFrame, shared with arduino-uart-rfid
 
 // --- Configuration Constants ---
 // Timeout duration in milliseconds (e.g., 5000ms = 5 seconds)
 const unsigned long RFID_ACTIVE_TIMEOUT = 5000; 
 
+// Scheduler periods in milliseconds
+const unsigned long RFID_POLL_INTERVAL = 20;    // Card presence check (~50 reads/s max)
+const unsigned long STATS_INTERVAL = 10000;     // Loop frequency / latency report
+
+// --- Serial link to the BitDogLab hub ---
+// Starts at BASE_BAUD; the hub may negotiate one of SUPPORTED_BAUDS (exact at 16 MHz
+// for 250000/500000). Without BAUD_PING/BAUD_KEEP from the hub we drop back to BASE_BAUD.
+const unsigned long BASE_BAUD = 9600;
+const unsigned long SUPPORTED_BAUDS[] = { 500000, 250000, 115200 };
+const unsigned long PING_TIMEOUT = 1000;      // Switch -> first BAUD_PING
+const unsigned long KEEPALIVE_TIMEOUT = 6000; // Between BAUD_KEEPs once confirmed
+
+unsigned long linkBaud = BASE_BAUD;
+bool linkConfirmed = false;   // BAUD_PING received at linkBaud
+unsigned long linkLastRx = 0; // millis() of the switch or the last PING/KEEP
+char rxLine[24];              // Line being received from the hub
+byte rxLen = 0;
+
 // --- RFID Configuration (SPI) ---
 #define RST_PIN 9   // Reset Pin
 #define SS_PIN 10   // Slave Select Pin
 MFRC522 rfid(SS_PIN, RST_PIN);
 
-String content; 
+// --- UID frame ("RFID_UID:" + hex UID + CRLF) built in a fixed buffer ---
+char uidFrame[UID_FRAME_SIZE];
 
 // --- PIR HC-SR501 Configuration ---
-const int PIR_PIN = 2; // PIR sensor OUT pin connected to Digital Pin 2
+const int PIR_PIN = 2; // PIR sensor OUT pin connected to Digital Pin 2 (INT0)
+
+// State written by the PIR interrupt
+volatile bool pirEdgePending = false;   // A level change has not been handled yet
+volatile int pirLevel = LOW;            // Level seen by the last interrupt
+volatile unsigned long pirEdgeMicros = 0; // When that change happened
 
 // State variables
 unsigned long lastMotionTime = 0; // Timestamp of the last time motion was detected
 int currentPIRState = LOW; 
 bool rfidActive = false; 
 
+// --- Cooperative scheduler ---
+typedef struct {
+  unsigned long interval; // Period in ms
+  unsigned long lastRun;  // millis() of the previous run
+  void (*run)();
+} Task;
+
+void pollRFID();
+void checkRFIDTimeout();
+void reportStats();
+
+Task tasks[] = {
+  { RFID_POLL_INTERVAL, 0, pollRFID },
+  { 100, 0, checkRFIDTimeout },
+  { STATS_INTERVAL, 0, reportStats },
+};
+const byte NUM_TASKS = sizeof(tasks) / sizeof(tasks[0]);
+
+// --- Measurements (reset at every report) ---
+unsigned long loopCount = 0;
+unsigned long pirLatencyMax = 0;  // Edge -> PIR_STATUS sent, in us
+unsigned long rfidLatencyMax = 0; // Card detected -> RFID_UID sent, in us
+
+// Changes the serial rate after the pending output has been sent
+void setLinkBaud(unsigned long baud) {
+  Serial.flush();
+  Serial.begin(baud);
+  linkBaud = baud;
+  linkConfirmed = false;
+  linkLastRx = millis();
+}
+
+// Baud negotiation commands from the hub (other lines are ignored)
+void handleHubLine(const char* line) {
+  if (strncmp(line, "BAUD_REQ:", 9) == 0) {
+    unsigned long rate = strtoul(line + 9, NULL, 10);
+    bool supported = false;
+    for (byte i = 0; i < sizeof(SUPPORTED_BAUDS) / sizeof(SUPPORTED_BAUDS[0]); i++) {
+      if (SUPPORTED_BAUDS[i] == rate) {
+        supported = true;
+      }
+    }
+    Serial.print(supported ? "BAUD_ACK:" : "BAUD_NAK:");
+    Serial.println(rate);
+    if (supported) {
+      setLinkBaud(rate);
+    }
+  } else if (strcmp(line, "BAUD_PING") == 0) {
+    Serial.println("BAUD_PONG");
+    linkConfirmed = true;
+    linkLastRx = millis();
+  } else if (strcmp(line, "BAUD_KEEP") == 0) {
+    linkLastRx = millis();
+  }
+}
+
+// Reads hub commands and falls back to BASE_BAUD when the hub goes quiet
+void serviceLink() {
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      rxLine[rxLen] = '\0';
+      if (rxLen > 0) {
+        handleHubLine(rxLine);
+      }
+      rxLen = 0;
+    } else if (rxLen < sizeof(rxLine) - 1) {
+      rxLine[rxLen++] = c;
+    }
+  }
+
+  if (linkBaud != BASE_BAUD) {
+    unsigned long timeout = linkConfirmed ? KEEPALIVE_TIMEOUT : PING_TIMEOUT;
+    if (millis() - linkLastRx > timeout) {
+      setLinkBaud(BASE_BAUD);
+    }
+  }
+}
+
+void onPIRChange() {
+  pirLevel = digitalRead(PIR_PIN);
+  pirEdgeMicros = micros();
+  pirEdgePending = true;
+}
+
 void setup() {
-  Serial.begin(9600); // Initialize serial communication
+  Serial.begin(BASE_BAUD); // Initialize serial communication
 
   // --- Initialize SPI Communication ---
   SPI.begin();
 
   // --- PIR Initialization ---
   pinMode(PIR_PIN, INPUT); // Set the PIR sensor pin as input
+  attachInterrupt(digitalPinToInterrupt(PIR_PIN), onPIRChange, CHANGE);
 
   // Initially, RFID is assumed to be down
   
@@ -42,55 +155,75 @@ void setup() {
   Serial.println("RFID Reader is in low-power mode, waiting for motion.");
 }
 
-void loop() {
-  
-  // 1. PIR READING (MOTION CHECK)
-  currentPIRState = digitalRead(PIR_PIN);
-
-  // --- Logic for Motion Detection and Activation ---
-  if (currentPIRState == HIGH) {
-    
-    // Update the time of the last motion detected (resets the timeout counter)
-    lastMotionTime = millis(); 
-    
-    // a) Motion detected: Activate RFID reader if it's not already active
-    if (!rfidActive) {
-      rfid.PCD_Init(); // Power up and initialize the RFID reader
-      rfidActive = true;
-      Serial.println("PIR_STATUS:MOTION_DETECTED_RFID_ACTIVATED");
-    }
+// Handles a PIR level change captured by the interrupt
+void handlePIR() {
+  noInterrupts();
+  bool pending = pirEdgePending;
+  int level = pirLevel;
+  unsigned long edgeMicros = pirEdgeMicros;
+  pirEdgePending = false;
+  interrupts();
 
-    // Log continuous movement status (optional based on your requirement)
-    // We only log if it's the start of a movement sequence for a cleaner log
-    static int lastPIRLogState = LOW;
-    if (currentPIRState != lastPIRLogState) {
-       Serial.println("PIR_STATUS:MOTION_DETECTED"); 
-    }
-    lastPIRLogState = currentPIRState;
-    
-  } 
-
-  // 2. RFID READING (Only possible when rfidActive is true)
-  if (rfidActive && rfid.PICC_IsNewCardPresent() && rfid.PICC_ReadCardSerial()) {
-    
-    // --- Logic for reading and converting the UID ---
-    content = "";
-    for (byte i = 0; i < rfid.uid.size; i++) {
-      if (rfid.uid.uidByte[i] < 0x10) {
-        content += "0";
-      }
-      content += String(rfid.uid.uidByte[i], HEX);
+  if (!pending) {
+    // Still moving: keep extending the RFID timeout while the output is high
+    if (currentPIRState == HIGH) {
+      lastMotionTime = millis();
     }
-    
-    // Send the UID 
-    Serial.print("RFID_UID:");
-    Serial.println(content);
+    return;
+  }
+
+  int previousState = currentPIRState;
+  currentPIRState = level;
+  if (currentPIRState != HIGH) {
+    return;
+  }
+
+  // Update the time of the last motion detected (resets the timeout counter)
+  lastMotionTime = millis();
+
+  // a) Motion detected: Activate RFID reader if it's not already active
+  if (!rfidActive) {
+    rfid.PCD_Init(); // Power up and initialize the RFID reader
+    rfidActive = true;
+    Serial.println("PIR_STATUS:MOTION_DETECTED_RFID_ACTIVATED");
+  }
+
+  // We only log if it's the start of a movement sequence for a cleaner log
+  if (previousState != HIGH) {
+    Serial.println("PIR_STATUS:MOTION_DETECTED");
+  }
+
+  unsigned long latency = micros() - edgeMicros;
+  if (latency > pirLatencyMax) {
+    pirLatencyMax = latency;
+  }
+}
+
+// RFID READING (Only possible when rfidActive is true)
+void pollRFID() {
+  if (!rfidActive || !rfid.PICC_IsNewCardPresent()) {
+    return;
+  }
+  unsigned long detectedMicros = micros();
+  if (!rfid.PICC_ReadCardSerial()) {
+    return;
+  }
 
-    // Halt the PICC 
-    rfid.PICC_HaltA();
+  // Send the UID as one frame (no heap allocation)
+  byte len = encodeUidFrame(uidFrame, rfid.uid.uidByte, rfid.uid.size);
+  Serial.write((const uint8_t*)uidFrame, len);
+
+  unsigned long latency = micros() - detectedMicros;
+  if (latency > rfidLatencyMax) {
+    rfidLatencyMax = latency;
   }
 
-  // 3. RFID SLEEP MANAGEMENT (TIMEOUT LOGIC)
+  // Halt the PICC 
+  rfid.PICC_HaltA();
+}
+
+// RFID SLEEP MANAGEMENT (TIMEOUT LOGIC)
+void checkRFIDTimeout() {
   // Check if the RFID is active AND if the timeout has expired (time elapsed since last motion > timeout)
   if (rfidActive && (millis() - lastMotionTime > RFID_ACTIVE_TIMEOUT)) {
       
@@ -99,7 +232,42 @@ void loop() {
       
       Serial.println("PIR_STATUS:NO_MOTION_RFID_SLEEP");
   }
+}
+
+// Reports loop frequency and worst detection-to-transmit latencies
+void reportStats() {
+  static unsigned long lastReport = 0;
+  unsigned long now = millis();
+  unsigned long elapsed = now - lastReport;
+  lastReport = now;
+
+  Serial.print("STATS:LOOP_HZ=");
+  Serial.print(elapsed ? loopCount * 1000UL / elapsed : 0);
+  Serial.print(",PIR_LAT_US=");
+  Serial.print(pirLatencyMax);
+  Serial.print(",RFID_LAT_US=");
+  Serial.println(rfidLatencyMax);
+
+  loopCount = 0;
+  pirLatencyMax = 0;
+  rfidLatencyMax = 0;
+}
 
-  // Short delay to maintain responsiveness
-  delay(100); 
-}
\ No newline at end of file
+void loop() {
+  loopCount++;
+
+  // 1. PIR (interrupt-captured edges are handled as soon as loop() sees them)
+  handlePIR();
+
+  // 2. Hub commands (baud negotiation / keepalive)
+  serviceLink();
+
+  // 3. Run every task whose period has elapsed; no fixed delay
+  unsigned long now = millis();
+  for (byte i = 0; i < NUM_TASKS; i++) {
+    if (now - tasks[i].lastRun >= tasks[i].interval) {
+      tasks[i].lastRun = now;
+      tasks[i].run();
+    }
+  }
+}
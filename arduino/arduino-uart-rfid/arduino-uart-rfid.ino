@@ -5,6 +5,7 @@
 // Bibliotecas do RFID (SPI)
 #include <MFRC522.h>
 #include <SPI.h>
+#include <UidFrame.h> // arduino/libraries/UidFrame, compartilhado com o outro sketch RFID
 
 // Bibliotecas do BMP280 (I2C)
 #include <Wire.h>
@@ -16,7 +17,8 @@
 #define PINO_SDA 10
 MFRC522 rfid(PINO_SDA, PINO_RST);
 
-String content; // Variável para armazenar o UID lido
+// Quadro do UID ("RFID_UID:" + UID em hex + CRLF) montado em buffer fixo
+char uidFrame[UID_FRAME_SIZE];
 
 // --- Configuração BMP280 (I2C) ---
 Adafruit_BMP280 bmp; // Cria o objeto BMP280 (usa o endereço I2C padrão)
@@ -50,17 +52,9 @@ void setup() {
 void loop() {
   // 1. LEITURA E ENVIO DO RFID
   if (rfid.PICC_IsNewCardPresent() && rfid.PICC_ReadCardSerial()) {
-    content = "";
-    for (byte i = 0; i < rfid.uid.size; i++) {
-      if (rfid.uid.uidByte[i] < 0x10) {
-        content += "0";
-      }
-      content += String(rfid.uid.uidByte[i], HEX);
-    }
-    
-    // Envia o UID (com prefixo para identificação na BitDogLab)
-    Serial.print("RFID_UID:");
-    Serial.println(content);
+    // Envia o UID em um único quadro (com prefixo para identificação na BitDogLab)
+    byte len = encodeUidFrame(uidFrame, rfid.uid.uidByte, rfid.uid.size);
+    Serial.write((const uint8_t*)uidFrame, len);
 
     rfid.PICC_HaltA();
   }
@@ -0,0 +1,37 @@
+/*******************************************************************************
+ UidFrame - "RFID_UID:<hex>\r\n" frame sent by the RFID sketches to BitDogLab
+ Shared by arduino-bitdoglab-rfid-pirhcsr501 and arduino-uart-rfid: with the
+ sketchbook location set to this repo's arduino/ folder, the IDE finds it in
+ arduino/libraries/. Plain C, so tools/uid_frame_test.c builds it on the host.
+*******************************************************************************/
+
+#ifndef UID_FRAME_H
+#define UID_FRAME_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define UID_FRAME_PREFIX "RFID_UID:"
+#define UID_FRAME_PREFIX_LEN (sizeof(UID_FRAME_PREFIX) - 1)
+#define UID_FRAME_MAX_UID 10 // MIFARE UIDs are 4, 7 or 10 bytes
+#define UID_FRAME_SIZE (UID_FRAME_PREFIX_LEN + 2 * UID_FRAME_MAX_UID + 2)
+
+// Encodes a UID as lowercase hex with CRLF (as println produced) into frame,
+// UID_FRAME_SIZE bytes; UIDs over 10 bytes are cut. Returns the frame length.
+static inline uint8_t encodeUidFrame(char* frame, const uint8_t* uid, uint8_t size) {
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+  if (size > UID_FRAME_MAX_UID) {
+    size = UID_FRAME_MAX_UID;
+  }
+  memcpy(frame, UID_FRAME_PREFIX, UID_FRAME_PREFIX_LEN);
+  uint8_t n = UID_FRAME_PREFIX_LEN;
+  for (uint8_t i = 0; i < size; i++) {
+    frame[n++] = HEX_DIGITS[uid[i] >> 4];
+    frame[n++] = HEX_DIGITS[uid[i] & 0x0F];
+  }
+  frame[n++] = '\r';
+  frame[n++] = '\n';
+  return n;
+}
+
+#endif // UID_FRAME_H
@@ -1051,6 +1051,213 @@ static void clear_share (	/* Clear all lock entries of the volume */
 /*-----------------------------------------------------------------------*/
 /* Move/Flush disk access window in the filesystem object                */
 /*-----------------------------------------------------------------------*/
+#if !FF_FS_READONLY
+static void fat2_mirror (
+	FATFS* fs,			/* Filesystem object */
+	const BYTE* buf,	/* Contents of the 1st FAT sector just written */
+	LBA_t sect			/* Sector LBA in the 1st FAT */
+)
+{
+#if FF_FAT2_DEFER
+	DWORD rng[FF_FAT2_RANGES + 1][2], ofs, gap, best;
+	UINT i, j, n, a, b;
+
+
+	(void)buf;
+	if (fs->n_fats != 2) return;
+	ofs = (DWORD)(sect - fs->fatbase);
+	n = fs->fat2_n;
+	for (i = 0; i < n; i++) {	/* Grow a range that touches the sector */
+		if (ofs + 1 >= fs->fat2_ofs[i][0] && ofs <= fs->fat2_ofs[i][1]) {
+			if (ofs < fs->fat2_ofs[i][0]) fs->fat2_ofs[i][0] = ofs;
+			if (ofs >= fs->fat2_ofs[i][1]) fs->fat2_ofs[i][1] = ofs + 1;
+			return;
+		}
+	}
+	memcpy(rng, fs->fat2_ofs, sizeof fs->fat2_ofs);
+	rng[n][0] = ofs; rng[n][1] = ofs + 1;
+	n++;
+	if (n > FF_FAT2_RANGES) {	/* Full: merge the two ranges with the smallest gap */
+		best = 0xFFFFFFFF; a = 0; b = 1;
+		for (i = 0; i < n; i++) {
+			for (j = i + 1; j < n; j++) {
+				gap = (rng[i][0] < rng[j][0]) ? rng[j][0] - rng[i][1] : rng[i][0] - rng[j][1];
+				if (gap < best) {
+					best = gap; a = i; b = j;
+				}
+			}
+		}
+		if (rng[b][0] < rng[a][0]) rng[a][0] = rng[b][0];
+		if (rng[b][1] > rng[a][1]) rng[a][1] = rng[b][1];
+		rng[b][0] = rng[n - 1][0]; rng[b][1] = rng[n - 1][1];
+		n--;
+	}
+	memcpy(fs->fat2_ofs, rng, sizeof fs->fat2_ofs);
+	fs->fat2_n = (BYTE)n;
+#else
+	if (fs->n_fats == 2) disk_write(fs->pdrv, buf, sect + fs->fsize, 1);
+#endif
+}
+
+#if FF_FAT2_DEFER
+static FRESULT fat2_flush (	/* Copy the recorded 1st FAT ranges to the 2nd FAT (the window must be clean) */
+	FATFS* fs			/* Filesystem object */
+)
+{
+	FRESULT res = FR_OK;
+	BYTE *buf;
+	UINT i, szb, n;
+	DWORD ofs;
+
+
+	if (fs->fat2_n == 0) return FR_OK;
+#if FF_USE_LFN == 3		/* Multi-sector runs through a temporary buffer */
+	for (szb = MAX_MALLOC, buf = 0; szb > SS(fs) && (buf = ff_memalloc(szb)) == 0; szb /= 2) ;
+	if (szb > SS(fs)) {
+		szb /= SS(fs);		/* Bytes -> Sectors */
+	} else
+#endif
+	{
+		buf = fs->win; szb = 1;		/* Use window buffer */
+		fs->winsect = (LBA_t)0 - 1;
+	}
+	for (i = 0; i < fs->fat2_n && res == FR_OK; i++) {
+		for (ofs = fs->fat2_ofs[i][0]; ofs < fs->fat2_ofs[i][1]; ofs += n) {
+			n = (fs->fat2_ofs[i][1] - ofs < szb) ? fs->fat2_ofs[i][1] - ofs : szb;
+			if (disk_read(fs->pdrv, buf, fs->fatbase + ofs, n) != RES_OK
+				|| disk_write(fs->pdrv, buf, fs->fatbase + fs->fsize + ofs, n) != RES_OK) {
+				res = FR_DISK_ERR;
+				break;
+			}
+		}
+	}
+	if (buf != fs->win) ff_memfree(buf);
+	if (res == FR_OK) fs->fat2_n = 0;
+	return res;
+}
+#endif
+#endif
+
+#if FF_WIN_CACHE_WAYS
+#define WC_LINES	(FF_WIN_CACHE_SETS * FF_WIN_CACHE_WAYS)
+
+/* The cache lines hold recently used sectors other than the one in fs->win[]. The
+/  window itself stays at a fixed address because directory objects keep pointers
+/  into it, so switching sectors copies the window out to a line and the new sector
+/  in from a line (or from the disk). */
+
+static void wc_drop (	/* Forget cached copies of sectors sect..sect+n-1 (dirty ones are discarded) */
+	FATFS* fs,			/* Filesystem object */
+	LBA_t sect,			/* First sector */
+	LBA_t n				/* Number of sectors */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < WC_LINES; i++) {
+		if (fs->wc_sect[i] - sect < n) {
+			fs->wc_sect[i] = (LBA_t)0 - 1;
+			fs->wc_dirty[i] = 0;
+		}
+	}
+}
+
+#if !FF_FS_READONLY
+static FRESULT wc_write (	/* Returns FR_OK or FR_DISK_ERR */
+	FATFS* fs,			/* Filesystem object */
+	const BYTE* buf,	/* Sector data */
+	LBA_t sect			/* Sector LBA */
+)
+{
+	if (disk_write(fs->pdrv, buf, sect, 1) != RES_OK) return FR_DISK_ERR;
+	if (sect - fs->fatbase < fs->fsize) {	/* Is it in the 1st FAT? */
+		fat2_mirror(fs, buf, sect);		/* Reflect it to 2nd FAT if needed */
+	}
+	return FR_OK;
+}
+
+static FRESULT wc_flush (	/* Write back the window and all dirty lines: FAT sectors first, each group in ascending order */
+	FATFS* fs			/* Filesystem object */
+)
+{
+	UINT i, line, fat;
+	LBA_t sect, best;
+
+
+	for (fat = 2; fat-- > 0; ) {
+		for (;;) {
+			line = WC_LINES + 1; best = 0;
+			for (i = 0; i <= WC_LINES; i++) {	/* Index WC_LINES is the window */
+				if (i < WC_LINES ? !fs->wc_dirty[i] : !fs->wflag) continue;
+				sect = (i < WC_LINES) ? fs->wc_sect[i] : fs->winsect;
+				if ((sect - fs->fatbase < fs->fsize) != fat) continue;
+				if (line > WC_LINES || sect < best) {
+					line = i; best = sect;
+				}
+			}
+			if (line > WC_LINES) break;
+			if (wc_write(fs, (line < WC_LINES) ? fs->wc_buf[line] : fs->win, best) != FR_OK) return FR_DISK_ERR;
+			if (line < WC_LINES) {
+				fs->wc_dirty[line] = 0;
+			} else {
+				fs->wflag = 0;
+			}
+		}
+	}
+	return FR_OK;
+}
+#endif
+
+static FRESULT wc_switch (	/* Returns FR_OK or FR_DISK_ERR */
+	FATFS* fs,		/* Filesystem object */
+	LBA_t sect		/* Sector LBA to make appearance in the fs->win[] */
+)
+{
+	UINT i, set, line;
+
+
+	if (fs->winsect != (LBA_t)0 - 1) {	/* Park the window sector in the LRU (or an empty) line of its set */
+		set = (UINT)(fs->winsect % FF_WIN_CACHE_SETS) * FF_WIN_CACHE_WAYS;
+		line = set;
+		for (i = set; i < set + FF_WIN_CACHE_WAYS; i++) {
+			if (fs->wc_sect[i] == (LBA_t)0 - 1) {
+				line = i;
+				break;
+			}
+			if (fs->wc_used[i] < fs->wc_used[line]) line = i;
+		}
+#if !FF_FS_READONLY
+		if (fs->wc_dirty[line]) {	/* Evict the victim */
+			if (wc_write(fs, fs->wc_buf[line], fs->wc_sect[line]) != FR_OK) return FR_DISK_ERR;
+		}
+#endif
+		memcpy(fs->wc_buf[line], fs->win, SS(fs));
+		fs->wc_sect[line] = fs->winsect;
+		fs->wc_dirty[line] = fs->wflag;
+		fs->wc_used[line] = ++fs->wc_tick;
+		fs->winsect = (LBA_t)0 - 1;
+		fs->wflag = 0;
+	}
+
+	set = (UINT)(sect % FF_WIN_CACHE_SETS) * FF_WIN_CACHE_WAYS;
+	for (i = set; i < set + FF_WIN_CACHE_WAYS; i++) {
+		if (fs->wc_sect[i] == sect) {	/* Hit: the line moves into the window */
+			memcpy(fs->win, fs->wc_buf[i], SS(fs));
+			fs->wflag = fs->wc_dirty[i];
+			fs->wc_sect[i] = (LBA_t)0 - 1;
+			fs->wc_dirty[i] = 0;
+			fs->winsect = sect;
+			return FR_OK;
+		}
+	}
+	if (disk_read(fs->pdrv, fs->win, sect, 1) != RES_OK) return FR_DISK_ERR;	/* Window stays invalid on error */
+	fs->winsect = sect;
+	return FR_OK;
+}
+#endif	/* FF_WIN_CACHE_WAYS */
+
+
 #if !FF_FS_READONLY
 static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 	FATFS* fs			/* Filesystem object */
@@ -1063,7 +1270,7 @@ static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 		if (disk_write(fs->pdrv, fs->win, fs->winsect, 1) == RES_OK) {	/* Write it back into the volume */
 			fs->wflag = 0;	/* Clear window dirty flag */
 			if (fs->winsect - fs->fatbase < fs->fsize) {	/* Is it in the 1st FAT? */
-				if (fs->n_fats == 2) disk_write(fs->pdrv, fs->win, fs->winsect + fs->fsize, 1);	/* Reflect it to 2nd FAT if needed */
+				fat2_mirror(fs, fs->win, fs->winsect);	/* Reflect it to 2nd FAT if needed */
 			}
 		} else {
 			res = FR_DISK_ERR;
@@ -1083,6 +1290,9 @@ static FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERR */
 
 
 	if (sect != fs->winsect) {	/* Window offset changed? */
+#if FF_WIN_CACHE_WAYS
+		res = wc_switch(fs, sect);	/* Park the window in the cache, then load from the cache or the disk */
+#else
 #if !FF_FS_READONLY
 		res = sync_window(fs);		/* Flush the window */
 #endif
@@ -1093,6 +1303,7 @@ static FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERR */
 			}
 			fs->winsect = sect;
 		}
+#endif
 	}
 	return res;
 }
@@ -1112,11 +1323,21 @@ static FRESULT sync_fs (	/* Returns FR_OK or FR_DISK_ERR */
 	FRESULT res;
 
 
+#if FF_WIN_CACHE_WAYS
+	res = wc_flush(fs);
+#else
 	res = sync_window(fs);
+#endif
+#if FF_FAT2_DEFER
+	if (res == FR_OK) res = fat2_flush(fs);
+#endif
 	if (res == FR_OK) {
 		if (fs->fs_type == FS_FAT32 && fs->fsi_flag == 1) {	/* FAT32: Update FSInfo sector if needed */
+#if FF_WIN_CACHE_WAYS
+			wc_drop(fs, fs->volbase + 1, 1);	/* The window takes over the FSInfo sector */
+#endif
 			/* Create FSInfo structure */
-			memset(fs->win, 0, sizeof fs->win);
+			memset(fs->win, 0, SS(fs));
 			st_word(fs->win + BS_55AA, 0xAA55);					/* Boot signature */
 			st_dword(fs->win + FSI_LeadSig, 0x41615252);		/* Leading signature */
 			st_dword(fs->win + FSI_StrucSig, 0x61417272);		/* Structure signature */
@@ -1231,6 +1452,45 @@ static DWORD get_fat (		/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x7FFFFFF
 
 
 
+#if !FF_FS_READONLY && FF_FAT_FREEMAP
+/*-----------------------------------------------------------------------*/
+/* FAT32 free map - Groups of clusters known to have no free cluster     */
+/*-----------------------------------------------------------------------*/
+
+static int fmap_full (	/* 1:Group of the cluster has no free cluster, 0:Unknown */
+	FATFS* fs,		/* Filesystem object */
+	DWORD clst		/* Cluster# in the group */
+)
+{
+	DWORD g = clst / fs->fmap_clst;
+
+
+	return (fs->fmap[g / 8] >> (g % 8)) & 1;
+}
+
+static void fmap_set (
+	FATFS* fs,		/* Filesystem object */
+	DWORD clst,		/* Cluster# in the group */
+	int full		/* 1:Whole group is in use, 0:Group may have a free cluster */
+)
+{
+	DWORD g;
+
+
+	if (fs->fmap_clst == 0) return;
+	g = clst / fs->fmap_clst;
+	if (full) {
+		fs->fmap[g / 8] |= (BYTE)(1 << (g % 8));
+	} else {
+		fs->fmap[g / 8] &= (BYTE)~(1 << (g % 8));
+	}
+}
+
+#endif
+
+
+
+
 #if !FF_FS_READONLY
 /*-----------------------------------------------------------------------*/
 /* FAT access - Change value of an FAT entry                             */
@@ -1281,6 +1541,9 @@ static FRESULT put_fat (	/* FR_OK(0):succeeded, !=0:error */
 			}
 			st_dword(fs->win + clst * 4 % SS(fs), val);
 			fs->wflag = 1;
+#if FF_FAT_FREEMAP
+			if ((val & 0x0FFFFFFF) == 0) fmap_set(fs, clst, 0);	/* Freed: the group may have a free cluster */
+#endif
 			break;
 		}
 	}
@@ -1529,6 +1792,10 @@ static DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:D
 	DWORD cs, ncl, scl;
 	FRESULT res;
 	FATFS *fs = obj->fs;
+#if FF_FAT_FREEMAP
+	DWORD gend;
+	int gfull;
+#endif
 
 
 	if (clst == 0) {	/* Create a new chain */
@@ -1585,15 +1852,35 @@ static DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:D
 		}
 		if (ncl == 0) {	/* The new cluster cannot be contiguous and find another fragment */
 			ncl = scl;	/* Start cluster */
+#if FF_FAT_FREEMAP
+			gfull = 0;	/* Current free map group has been scanned from its top and is all in use */
+#endif
 			for (;;) {
 				ncl++;							/* Next cluster */
 				if (ncl >= fs->n_fatent) {		/* Check wrap-around */
 					ncl = 2;
 					if (ncl > scl) return 0;	/* No free cluster found? */
 				}
+#if FF_FAT_FREEMAP
+				if (fs->fmap_clst && (ncl % fs->fmap_clst == 0 || ncl == 2)) {	/* Top of a group? */
+					if (fmap_full(fs, ncl)) {	/* Skip a group known to be in use */
+						gend = ncl - ncl % fs->fmap_clst + fs->fmap_clst - 1;
+						if (gend >= fs->n_fatent) gend = fs->n_fatent - 1;
+						if (scl >= ncl && scl <= gend) return 0;	/* No free cluster found? */
+						ncl = gend;
+						continue;
+					}
+					gfull = 1;
+				}
+#endif
 				cs = get_fat(obj, ncl);			/* Get the cluster status */
 				if (cs == 0) break;				/* Found a free cluster? */
 				if (cs == 1 || cs == 0xFFFFFFFF) return cs;	/* Test for error */
+#if FF_FAT_FREEMAP
+				if (gfull && (ncl % fs->fmap_clst == fs->fmap_clst - 1 || ncl == fs->n_fatent - 1)) {
+					fmap_set(fs, ncl, 1);		/* Whole group is in use */
+				}
+#endif
 				if (ncl == scl) return 0;		/* No free cluster found? */
 			}
 		}
@@ -1667,8 +1954,11 @@ static FRESULT dir_clear (	/* Returns FR_OK or FR_DISK_ERR */
 
 	if (sync_window(fs) != FR_OK) return FR_DISK_ERR;	/* Flush disk access window */
 	sect = clst2sect(fs, clst);		/* Top of the cluster */
+#if FF_WIN_CACHE_WAYS
+	wc_drop(fs, sect, fs->csize);	/* Cached copies of the cluster would be stale */
+#endif
 	fs->winsect = sect;				/* Set window to top of the cluster */
-	memset(fs->win, 0, sizeof fs->win);	/* Clear window buffer */
+	memset(fs->win, 0, SS(fs));	/* Clear window buffer */
 #if FF_USE_LFN == 3		/* Quick table clear by using multi-secter write */
 	/* Allocate a temporary buffer */
 	for (szb = ((DWORD)fs->csize * SS(fs) >= MAX_MALLOC) ? MAX_MALLOC : fs->csize * SS(fs), ibuf = 0; szb > SS(fs) && (ibuf = ff_memalloc(szb)) == 0; szb /= 2) ;
@@ -2377,6 +2667,83 @@ static FRESULT dir_read (
 
 
 
+#if FF_DIR_CACHE
+/*-----------------------------------------------------------------------*/
+/* Directory lookup cache - Where a name was last found in a directory   */
+/*-----------------------------------------------------------------------*/
+
+static void dc_clear (
+	FATFS* fs		/* Filesystem object */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < FF_DIR_CACHE; i++) fs->dc[i].dclst = 0xFFFFFFFF;
+}
+
+static FFDCENT* dc_find (	/* Cache entry of the name, NULL:not cached */
+	DIR* dp					/* Directory object with the name to find */
+)
+{
+	FATFS *fs = dp->obj.fs;
+	FFDCENT *ent;
+	UINT i;
+#if FF_USE_LFN
+	UINT n;
+#endif
+
+
+	for (i = 0; i < FF_DIR_CACHE; i++) {
+		ent = &fs->dc[i];
+		if (ent->dclst != dp->obj.sclust || memcmp(ent->fn, dp->fn, 12)) continue;
+#if FF_USE_LFN
+		for (n = 0; ent->name[n] == fs->lfnbuf[n]; n++) {	/* Compare the name as given */
+			if (ent->name[n] == 0) break;
+		}
+		if (ent->name[n] != fs->lfnbuf[n]) continue;
+#endif
+		ent->used = ++fs->dc_tick;
+		return ent;
+	}
+	return 0;
+}
+
+static void dc_store (
+	DIR* dp					/* Directory object pointing the entry found */
+)
+{
+	FATFS *fs = dp->obj.fs;
+	FFDCENT *ent;
+	UINT i;
+#if FF_USE_LFN
+	UINT n;
+
+
+	for (n = 0; fs->lfnbuf[n]; n++) {
+		if (n == FF_DIR_CACHE_NAME) return;		/* Too long to be cached */
+	}
+#endif
+	ent = &fs->dc[0];
+	for (i = 1; i < FF_DIR_CACHE && ent->dclst != 0xFFFFFFFF; i++) {	/* Empty or least recently used entry */
+		if (fs->dc[i].dclst == 0xFFFFFFFF || fs->dc[i].used < ent->used) ent = &fs->dc[i];
+	}
+	ent->dclst = dp->obj.sclust;
+	ent->used = ++fs->dc_tick;
+	ent->dptr = dp->dptr;
+	ent->clust = dp->clust;
+	ent->sect = dp->sect;
+	memcpy(ent->fn, dp->fn, 12);
+#if FF_USE_LFN
+	ent->blk_ofs = dp->blk_ofs;
+	memcpy(ent->name, fs->lfnbuf, (n + 1) * sizeof (WCHAR));
+#endif
+}
+
+#endif	/* FF_DIR_CACHE */
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
@@ -2391,6 +2758,9 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 #if FF_USE_LFN
 	BYTE a, ord, sum;
 #endif
+#if FF_DIR_CACHE
+	FFDCENT *ent;
+#endif
 
 	res = dir_sdi(dp, 0);			/* Rewind directory object */
 	if (res != FR_OK) return res;
@@ -2415,6 +2785,24 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 	}
 #endif
 	/* On the FAT/FAT32 volume */
+#if FF_DIR_CACHE
+	ent = (dp->fn[NSFLAG] & NS_NOLFN) ? 0 : dc_find(dp);
+	if (ent) {		/* Found before: go to the entry without scanning the directory */
+		res = move_window(fs, ent->sect);
+		if (res != FR_OK) return res;
+		c = fs->win[ent->dptr % SS(fs)];
+		if (c != 0 && c != DDEM) {
+			dp->dptr = ent->dptr; dp->clust = ent->clust; dp->sect = ent->sect;
+			dp->dir = fs->win + ent->dptr % SS(fs);
+			dp->obj.attr = dp->dir[DIR_Attr] & AM_MASK;
+#if FF_USE_LFN
+			dp->blk_ofs = ent->blk_ofs;
+#endif
+			return FR_OK;
+		}
+		ent->dclst = 0xFFFFFFFF;	/* Stale entry */
+	}
+#endif
 #if FF_USE_LFN
 	ord = sum = 0xFF; dp->blk_ofs = 0xFFFFFFFF;	/* Reset LFN sequence */
 #endif
@@ -2450,6 +2838,9 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 #endif
 		res = dir_next(dp, 0);	/* Next entry */
 	} while (res == FR_OK);
+#if FF_DIR_CACHE
+	if (res == FR_OK && !(dp->fn[NSFLAG] & NS_NOLFN)) dc_store(dp);
+#endif
 
 	return res;
 }
@@ -2541,6 +2932,9 @@ static FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too
 #else	/* Non LFN configuration */
 	res = dir_alloc(dp, 1);		/* Allocate an entry for SFN */
 
+#endif
+#if FF_DIR_CACHE
+	dc_clear(fs);	/* A directory has changed */
 #endif
 
 	/* Set SFN entry */
@@ -2601,6 +2995,9 @@ static FRESULT dir_remove (	/* FR_OK:Succeeded, FR_DISK_ERR:A disk error */
 		fs->wflag = 1;
 	}
 #endif
+#if FF_DIR_CACHE
+	dc_clear(fs);	/* Cached locations may point to the removed entries */
+#endif
 
 	return res;
 }
@@ -3298,6 +3695,12 @@ static UINT check_fs (	/* 0:FAT/FAT32 VBR, 1:exFAT VBR, 2:Not FAT and valid BS,
 
 
 	fs->wflag = 0; fs->winsect = (LBA_t)0 - 1;		/* Invaidate window */
+#if FF_FAT2_DEFER
+	fs->fat2_n = 0;
+#endif
+#if FF_WIN_CACHE_WAYS
+	wc_drop(fs, 0, (LBA_t)0 - 1);		/* and the cached sectors */
+#endif
 	if (move_window(fs, sect) != FR_OK) return 4;	/* Load the boot sector */
 	sign = ld_word(fs->win + BS_55AA);
 #if FF_FS_EXFAT
@@ -3587,6 +3990,16 @@ static FRESULT mount_volume (	/* FR_OK(0): successful, !=0: an error occurred */
 	}
 
 	fs->fs_type = (BYTE)fmt;/* FAT sub-type (the filesystem object gets valid) */
+#if !FF_FS_READONLY && FF_FAT_FREEMAP
+	fs->fmap_clst = 0;		/* Free map: FAT32 only, as many FAT sectors per bit as needed */
+	if (fmt == FS_FAT32) {
+		fs->fmap_clst = (fs->fsize + FF_FAT_FREEMAP * 8 - 1) / (FF_FAT_FREEMAP * 8) * (SS(fs) / 4);
+		memset(fs->fmap, 0, sizeof fs->fmap);
+	}
+#endif
+#if FF_DIR_CACHE
+	dc_clear(fs);			/* Directory lookup cache starts empty */
+#endif
 	fs->id = ++Fsid;		/* Volume mount ID */
 #if FF_USE_LFN == 1
 	fs->lfnbuf = LfnBuf;	/* Static LFN working buffer */
@@ -4075,7 +4488,26 @@ FRESULT f_write (
 			cc = btw / SS(fs);				/* When remaining bytes >= sector size, */
 			if (cc > 0) {					/* Write maximum contiguous sectors directly */
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
+					wcnt = cc - (fs->csize - csect);	/* Sectors left for the following clusters */
 					cc = fs->csize - csect;
+					while (wcnt > 0		/* Extend the span while the next cluster follows physically */
+#if FF_FS_EXFAT
+						&& fs->fs_type != FS_EXFAT	/* Not on exFAT: get_fat() of a contiguous file knows its chain only up to objsize */
+#endif
+#if FF_USE_FASTSEEK
+						&& !fp->cltbl
+#endif
+					) {
+						clst = create_chain(&fp->obj, fp->clust);	/* Follow or stretch cluster chain on the FAT */
+						if (clst == 1) ABORT(fs, FR_INT_ERR);
+						if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+						if (clst != fp->clust + 1) break;	/* Not contiguous (or disk full): the next turn gets it */
+						fp->clust = clst;
+						if (wcnt < fs->csize) {
+							cc += wcnt; break;
+						}
+						cc += fs->csize; wcnt -= fs->csize;
+					}
 				}
 				if (disk_write(fs->pdrv, wbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
 #if FF_FS_MINIMIZE <= 2
@@ -4825,6 +5257,9 @@ FRESULT f_getfree (
 	LBA_t sect;
 	UINT i;
 	FFOBJID obj;
+#if FF_FAT_FREEMAP
+	DWORD gfree = 0;
+#endif
 
 
 	/* Get logical drive */
@@ -4884,7 +5319,16 @@ FRESULT f_getfree (
 							if (ld_word(fs->win + i) == 0) nfree++;
 							i += 2;
 						} else {
+#if FF_FAT_FREEMAP
+							stat = fs->n_fatent - clst;		/* Cluster# of this entry */
+							if (fs->fmap_clst && stat % fs->fmap_clst == 0) gfree = nfree;	/* Free count before the group */
+#endif
 							if ((ld_dword(fs->win + i) & 0x0FFFFFFF) == 0) nfree++;
+#if FF_FAT_FREEMAP
+							if (fs->fmap_clst && (stat % fs->fmap_clst == fs->fmap_clst - 1 || clst == 1)) {
+								fmap_set(fs, stat, nfree == gfree);	/* Record a group without a free cluster in the free map */
+							}
+#endif
 							i += 4;
 						}
 						i %= SS(fs);
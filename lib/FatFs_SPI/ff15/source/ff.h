@@ -83,6 +83,10 @@ typedef DWORD FSIZE_t;
 typedef DWORD LBA_t;
 #endif
 
+#if FF_WIN_CACHE_WAYS && FF_FS_TINY
+#error Window cache (FF_WIN_CACHE_WAYS) cannot be used with FF_FS_TINY
+#endif
+
 
 
 /* Type of path name strings on FatFs API (TCHAR) */
@@ -127,6 +131,26 @@ extern const char* VolumeStr[FF_VOLUMES];	/* User defied volume ID */
 
 
 
+#if FF_DIR_CACHE
+/* Directory lookup cache entry */
+
+typedef struct {
+	DWORD	dclst;			/* Start cluster of the directory (0xFFFFFFFF:empty entry) */
+	DWORD	used;			/* LRU stamp */
+	DWORD	dptr;			/* Offset of the SFN entry in the directory */
+	DWORD	clust;			/* Cluster holding the SFN entry */
+	LBA_t	sect;			/* Sector holding the SFN entry */
+#if FF_USE_LFN
+	DWORD	blk_ofs;		/* Offset of the entry block (0xFFFFFFFF:no LFN) */
+	WCHAR	name[FF_DIR_CACHE_NAME + 1];	/* Name looked up (as given, null-terminated) */
+#endif
+	BYTE	fn[12];			/* SFN of the name looked up {body[8],ext[3],status[1]} */
+} FFDCENT;
+
+#endif
+
+
+
 /* Filesystem object structure (FATFS) */
 
 typedef struct {
@@ -136,6 +160,14 @@ typedef struct {
 	BYTE	n_fats;			/* Number of FATs (1 or 2) */
 	BYTE	wflag;			/* win[] status (b0:dirty) */
 	BYTE	fsi_flag;		/* FSINFO status (b7:disabled, b0:dirty) */
+#if FF_FAT_FREEMAP
+	DWORD	fmap_clst;		/* Clusters per free map bit (0:map not used on this volume) */
+	BYTE	fmap[FF_FAT_FREEMAP];	/* FAT32 free map (bit set: no free cluster in the group) */
+#endif
+#if FF_FAT2_DEFER
+	BYTE	fat2_n;			/* Number of 1st FAT ranges waiting to be mirrored */
+	DWORD	fat2_ofs[FF_FAT2_RANGES][2];	/* Those ranges [start, end) in sectors from fatbase */
+#endif
 	WORD	id;				/* Volume mount ID */
 	WORD	n_rootdir;		/* Number of root directory entries (FAT12/16) */
 	WORD	csize;			/* Cluster size [sectors] */
@@ -171,6 +203,17 @@ typedef struct {
 #endif
 	LBA_t	winsect;		/* Current sector appearing in the win[] */
 	BYTE	win[FF_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
+#if FF_WIN_CACHE_WAYS
+	DWORD	wc_tick;		/* LRU clock of the window cache */
+	LBA_t	wc_sect[FF_WIN_CACHE_SETS * FF_WIN_CACHE_WAYS];	/* Sector held by each line (-1:empty, never winsect) */
+	DWORD	wc_used[FF_WIN_CACHE_SETS * FF_WIN_CACHE_WAYS];	/* LRU stamp of each line */
+	BYTE	wc_dirty[FF_WIN_CACHE_SETS * FF_WIN_CACHE_WAYS];	/* Dirty flag of each line */
+	BYTE	wc_buf[FF_WIN_CACHE_SETS * FF_WIN_CACHE_WAYS][FF_MAX_SS];	/* Cache lines */
+#endif
+#if FF_DIR_CACHE
+	DWORD	dc_tick;		/* LRU clock of the directory lookup cache */
+	FFDCENT	dc[FF_DIR_CACHE];	/* Directory lookup cache */
+#endif
 } FATFS;
 
 
@@ -38,7 +38,7 @@
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_EXPAND	0
+#define FF_USE_EXPAND	1
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
@@ -57,8 +57,12 @@
 
 
 #define FF_USE_STRFUNC	1
-#define FF_PRINT_LLI	1
-#define FF_PRINT_FLOAT	1
+#ifndef FF_PRINT_LLI
+#define FF_PRINT_LLI	0
+#endif
+#ifndef FF_PRINT_FLOAT
+#define FF_PRINT_FLOAT	0
+#endif
 #define FF_STRF_ENCODE	3
 /* FF_USE_STRFUNC switches string functions, f_gets(), f_putc(), f_puts() and
 /  f_printf().
@@ -69,6 +73,10 @@
 /
 /  FF_PRINT_LLI = 1 makes f_printf() support long long argument and FF_PRINT_FLOAT = 1/2
 /  makes f_printf() support floating point argument. These features want C99 or later.
+/  Both are off by default: nothing here formats floats or long long through
+/  f_printf() (sensor values are fixed point, see lib_logger/log_fixed.h), and
+/  enabling them pulls soft-float code into the image. They can be switched
+/  back on from the build, e.g. -DFF_PRINT_FLOAT=1.
 /  When FF_LFN_UNICODE >= 1 with LFN enabled, string functions convert the character
 /  encoding in it. FF_STRF_ENCODE selects assumption of character encoding ON THE FILE
 /  to be read/written via those functions.
@@ -231,6 +239,62 @@
 /  buffer in the filesystem object (FATFS) is used for the file data transfer. */
 
 
+#ifndef FF_WIN_CACHE_WAYS
+#define FF_WIN_CACHE_WAYS	4
+#endif
+#ifndef FF_WIN_CACHE_SETS
+#define FF_WIN_CACHE_SETS	2
+#endif
+/* These options configure a set-associative cache of FAT/directory/FSInfo sectors
+/  behind the disk access window, so that alternating between them (as every file
+/  append does) does not write back and re-read the window on each switch. A sector
+/  goes to set (LBA % FF_WIN_CACHE_SETS) and evicts the least recently used of its
+/  FF_WIN_CACHE_WAYS lines. Dirty lines are written on eviction and by sync_fs(), FAT
+/  sectors first. Each line takes FF_MAX_SS bytes in the filesystem object.
+/  FF_WIN_CACHE_WAYS = 0 restores the single sector window. The cache cannot be used
+/  with the tiny configuration (FF_FS_TINY = 1), which passes file data through the
+/  window. */
+
+
+#ifndef FF_FAT2_DEFER
+#define FF_FAT2_DEFER	0
+#endif
+#define FF_FAT2_RANGES	4
+/* This option switches when the 2nd FAT is updated. (0:Each FAT sector write-back or
+/  1:Deferred to sync_fs())
+/  0 writes every dirty FAT sector twice, once per FAT. 1 only records which sectors
+/  of the 1st FAT changed, in up to FF_FAT2_RANGES sector ranges (the two closest are
+/  merged when full), and sync_fs() (f_sync, f_close, f_mkdir ...) copies them to the
+/  2nd FAT in multi-sector runs. The 2nd FAT is stale after a power cut between those
+/  points; tools/fat_check.c compares both FATs of a card image, and
+/  tools/ff_host/fat2_powercut runs this option through random power cuts. */
+
+
+#ifndef FF_FAT_FREEMAP
+#define FF_FAT_FREEMAP	1024
+#endif
+/* This option sets the size in bytes of an in-RAM map of the FAT32 allocation
+/  table (0:Disable). Each bit covers a group of FAT sectors and is set once a scan
+/  has seen every cluster of the group in use, so later free-cluster searches in
+/  create_chain() skip the group without reading it. Freeing a cluster clears its
+/  bit. The map starts empty at mount and fills in as create_chain() and f_getfree()
+/  walk the FAT. 1024 bytes keep one bit per FAT sector up to 8192 FAT sectors
+/  (a 32 GB card with 32 KB clusters); larger FATs share a bit between sectors. */
+
+
+#ifndef FF_DIR_CACHE
+#define FF_DIR_CACHE	8
+#endif
+#define FF_DIR_CACHE_NAME	24
+/* This option sets the number of entries of the directory lookup cache (0:Disable).
+/  Each entry remembers where a name was found in a FAT12/16/32 directory (directory
+/  start cluster and name -> sector and offset of the entry), so that opening the same
+/  path again reads the entry sector instead of scanning the directory from its top.
+/  Names longer than FF_DIR_CACHE_NAME characters and exFAT volumes are not cached.
+/  The whole cache is dropped when an entry is created or removed (f_open with
+/  FA_CREATE_*, f_mkdir, f_unlink, f_rename) and at mount. */
+
+
 #define FF_FS_EXFAT		1
 /* This option switches support for exFAT filesystem. (0:Disable or 1:Enable)
 /  To enable exFAT, also LFN needs to be enabled. (FF_USE_LFN >= 1)
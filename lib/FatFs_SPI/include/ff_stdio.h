@@ -13,7 +13,9 @@ specific language governing permissions and limitations under the License.
 */
 // For compatibility with FreeRTOS+FAT API
 #include <errno.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 //
@@ -22,9 +24,7 @@ specific language governing permissions and limitations under the License.
 #include "my_debug.h"
 
 #define BaseType_t int
-#define FF_FILE FIL
 
-#define ff_rewind f_rewind
 #define pvPortMalloc malloc
 #define vPortFree free
 #define ffconfigMAX_FILENAME 250
@@ -37,8 +37,23 @@ specific language governing permissions and limitations under the License.
 #define FF_SEEK_END 2
 #define pdFALSE 0
 #define pdTRUE 1
-#define ff_filelength f_size
-#define ff_feof f_eof
+
+// Stream: a FatFs file plus an optional user buffer (see ff_setvbuf). The
+// buffer holds either bytes not yet written or bytes read ahead, never both.
+typedef struct {
+    FIL fil;
+    char *buf;      // Stream buffer, NULL when unbuffered
+    size_t size;    // Size of buf
+    size_t pos;     // Writing: bytes buffered. Reading: next unread byte
+    size_t len;     // Reading: valid bytes in buf
+    uint8_t mode;   // _IOFBF, _IOLBF or _IONBF
+    uint8_t state;  // FF_STREAM_IDLE, FF_STREAM_WRITING or FF_STREAM_READING
+    bool own_buf;   // buf was allocated by ff_setvbuf
+} FF_FILE;
+
+#define FF_STREAM_IDLE 0
+#define FF_STREAM_WRITING 1
+#define FF_STREAM_READING 2
 
 typedef struct FF_STAT {
     uint32_t st_size; /* Size of the object in number of bytes. */
@@ -69,9 +84,23 @@ int ff_rmdir(const char *pcDirectory);
 int ff_remove(const char *pcPath);
 long ff_ftell(FF_FILE *pxStream);
 int ff_fseek(FF_FILE *pxStream, int iOffset, int iWhence);
+// Writes out pending data, drops any read-ahead and moves to the start of the
+// file. Returns 0, or -1 with errno set.
+int ff_rewind(FF_FILE *pxStream);
 int ff_findfirst(const char *pcDirectory, FF_FindData_t *pxFindData);
 int ff_findnext( FF_FindData_t *pxFindData );
 FF_FILE *ff_truncate( const char * pcFileName, long lTruncateSize );
 int ff_seteof( FF_FILE *pxStream );
 int ff_rename( const char *pcOldName, const char *pcNewName, int bDeleteIfExists );
-char *ff_fgets(char *pcBuffer, size_t xCount, FF_FILE *pxStream);
\ No newline at end of file
+char *ff_fgets(char *pcBuffer, size_t xCount, FF_FILE *pxStream);
+/**
+ * Sets the buffering of a stream like setvbuf(): _IOFBF writes the buffer
+ * when it is full, _IOLBF also after each '\n', _IONBF (the default of
+ * ff_fopen) passes every call straight to FatFs. pcBuffer may be NULL to have
+ * xSize bytes allocated. Transfers of at least xSize bytes bypass the buffer.
+ * Pending data is flushed first. Returns 0, or -1 with errno set.
+ */
+int ff_setvbuf(FF_FILE *pxStream, char *pcBuffer, int iMode, size_t xSize);
+int ff_fflush(FF_FILE *pxStream);
+long ff_filelength(FF_FILE *pxStream);
+int ff_feof(FF_FILE *pxStream);
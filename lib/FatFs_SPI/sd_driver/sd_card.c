@@ -164,6 +164,7 @@ specific language governing permissions and limitations under the License.
 #include <string.h>
 //
 #include "pico/mutex.h"
+#include "pico/time.h"
 //
 #include "hw_config.h"  // Hardware Configuration of the SPI and SD Card "objects"
 #include "my_debug.h"
@@ -326,9 +327,8 @@ static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
         }
     }
     // send a command
-    for (int i = 0; i < PACKET_SIZE; i++) {
-        sd_spi_write(pSD, cmdPacket[i]);
-    }
+    bool ok = sd_spi_transfer(pSD, (const uint8_t *)cmdPacket, NULL, PACKET_SIZE);
+    myASSERT(ok);
     // The received byte immediataly following CMD12 is a stuff byte,
     // it should be discarded before receive the response of the CMD12.
     if (CMD12_STOP_TRANSMISSION == cmd) {
@@ -346,21 +346,61 @@ static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
     return response;
 }
 
+#ifndef SD_WAIT_CHUNK_MAX
+#define SD_WAIT_CHUNK_MAX 64 /*!< Most bytes clocked per transfer while polling */
+#endif
+
+/* Timeout for the polling loops below. A hardware alarm sets the flag, so the
+ * loops don't read the timer on every pass. If no alarm is free, the timer is
+ * read instead. */
+typedef struct {
+    volatile bool expired;
+    alarm_id_t alarm;
+    absolute_time_t until;
+} sd_timeout_t;
+
+static int64_t sd_timeout_cb(alarm_id_t id, void *user_data) {
+    (void)id;
+    ((sd_timeout_t *)user_data)->expired = true;
+    return 0;  // Don't reschedule
+}
+static void sd_timeout_start(sd_timeout_t *t, uint32_t timeout_ms) {
+    t->expired = false;
+    t->until = make_timeout_time_ms(timeout_ms);
+    t->alarm = add_alarm_at(t->until, sd_timeout_cb, t, true);
+}
+static bool sd_timeout_expired(sd_timeout_t *t) {
+    if (t->alarm >= 0) return t->expired;  // 0: already fired
+    return 0 >= absolute_time_diff_us(get_absolute_time(), t->until);
+}
+static void sd_timeout_stop(sd_timeout_t *t) {
+    if (t->alarm > 0 && !t->expired) cancel_alarm(t->alarm);
+}
+
 static bool sd_wait_ready(sd_card_t *pSD, int timeout) {
-    char resp;
+    // Usually the card is ready already
+    if (sd_spi_write(pSD, 0xFF) != 0x00) return true;
+    if (timeout <= 0) return false;
 
     // Keep sending dummy clocks with DI held high until the card releases the
-    // DO line
-    absolute_time_t timeout_time = make_timeout_time_ms(timeout);
+    // DO line. DO stays high once released, so only the last byte of each
+    // transfer matters. Longer waits get longer transfers.
+    uint8_t buf[SD_WAIT_CHUNK_MAX];
+    size_t chunk = 4;
+    bool ready = false;
+    sd_timeout_t t;
+    sd_timeout_start(&t, timeout);
     do {
-        resp = sd_spi_write(pSD, 0xFF);
-    } while (resp == 0x00 &&
-             0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
+        sd_spi_transfer(pSD, NULL, buf, chunk);
+        ready = buf[chunk - 1] != 0x00;
+        if (chunk < sizeof buf) chunk *= 2;
+    } while (!ready && !sd_timeout_expired(&t));
+    sd_timeout_stop(&t);
 
-    if (resp == 0x00) DBG_PRINTF("%s failed\r\n", __FUNCTION__);
+    if (!ready) DBG_PRINTF("%s failed\r\n", __FUNCTION__);
 
     // Return success/failure
-    return (resp > 0x00);
+    return ready;
 }
 
 // An SD card can only do one thing at a time.
@@ -373,9 +413,32 @@ static void sd_unlock(sd_card_t *pSD) {
     mutex_exit(&pSD->mutex);
 }
 
+// States of the asynchronous request in progress (sd_card_t.async_state)
+enum {
+    ASYNC_IDLE,    // No request in progress
+    ASYNC_CMD,     // Waiting for the card to be ready for the write command
+    ASYNC_DATA,    // Ready to send the next block
+    ASYNC_BUSY,    // Waiting for the card to program a block
+    ASYNC_STOP,    // Waiting for the card after the Stop Tran token
+    ASYNC_STATUS,  // Ready to read the status (CMD13)
+};
+
+// Polls, then sleeps until the card is due to be looked at again
+static void async_poll_sleep(sd_card_t *pSD) {
+    if (sd_async_poll(pSD) && ASYNC_IDLE != pSD->async_state) {
+        sleep_until(pSD->async_next);
+    }
+}
+
 // Locks the SD card and acquires its SPI
 static void sd_acquire(sd_card_t *pSD) {
-    sd_lock(pSD);
+    for (;;) {
+        sd_lock(pSD);
+        if (ASYNC_IDLE == pSD->async_state) break;
+        // An asynchronous write has the card in the middle of a transaction
+        sd_unlock(pSD);
+        async_poll_sleep(pSD);
+    }
     sd_spi_acquire(pSD);
 }
 static void sd_release(sd_card_t *pSD) {
@@ -759,19 +822,34 @@ uint64_t sd_sectors(sd_card_t *pSD) {
     return sectors;
 }
 
-// SPI function to wait till chip is ready and sends start token
-static bool sd_wait_token(sd_card_t *pSD, uint8_t token) {
+/* SPI function to wait till chip is ready and sends start token.
+ * Polls several bytes per transfer; the bytes after the token are the start
+ * of the data block, so up to length of them are copied to data.
+ * Returns the number copied, or -1 on timeout. */
+static int sd_wait_token(sd_card_t *pSD, uint8_t token, uint8_t *data,
+                         uint32_t length) {
     TRACE_PRINTF("%s(0x%02hhx)\r\n", __FUNCTION__, token);
 
-    const uint32_t timeout = SD_COMMAND_TIMEOUT;  // Wait for start token
-    absolute_time_t timeout_time = make_timeout_time_ms(timeout);
+    uint8_t buf[SD_WAIT_CHUNK_MAX];
+    // Never clock in more than the data block: its CRC comes after it
+    size_t max = length + 1 < sizeof buf ? length + 1 : sizeof buf;
+    size_t chunk = 1;
+    int got = -1;
+    sd_timeout_t t;
+    sd_timeout_start(&t, SD_COMMAND_TIMEOUT);  // Wait for start token
     do {
-        if (token == sd_spi_write(pSD, SPI_FILL_CHAR)) {
-            return true;
+        sd_spi_transfer(pSD, NULL, buf, chunk);
+        uint8_t *tok = memchr(buf, token, chunk);
+        if (tok) {
+            got = chunk - (tok + 1 - buf);
+            memcpy(data, tok + 1, got);
+            break;
         }
-    } while (0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
-    DBG_PRINTF("sd_wait_token: timeout\r\n");
-    return false;
+        if (chunk < max) chunk = chunk * 2 < max ? chunk * 2 : max;
+    } while (!sd_timeout_expired(&t));
+    sd_timeout_stop(&t);
+    if (got < 0) DBG_PRINTF("sd_wait_token: timeout\r\n");
+    return got;
 }
 
 #define SPI_START_BLOCK \
@@ -781,12 +859,13 @@ static int sd_read_bytes(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
     uint16_t crc;
 
     // read until start byte (0xFE)
-    if (false == sd_wait_token(pSD, SPI_START_BLOCK)) {
+    int got = sd_wait_token(pSD, SPI_START_BLOCK, buffer, length);
+    if (got < 0) {
         DBG_PRINTF("%s:%d Read timeout\r\n", __FILE__, __LINE__);
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
     // read data
-    for (uint32_t i = 0; i < length; i++) {
+    for (uint32_t i = got; i < length; i++) {
         buffer[i] = sd_spi_write(pSD, SPI_FILL_CHAR);
     }
     // Read the CRC16 checksum for the data block
@@ -813,18 +892,21 @@ static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
     uint16_t crc;
 
     // read until start byte (0xFE)
-    if (false == sd_wait_token(pSD, SPI_START_BLOCK)) {
+    int got = sd_wait_token(pSD, SPI_START_BLOCK, buffer, length);
+    if (got < 0) {
         DBG_PRINTF("%s:%d Read timeout\r\n", __FILE__, __LINE__);
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
-    // read data
-    // bool spi_transfer(const uint8_t *tx, uint8_t *rx, size_t length)
-    if (!sd_spi_transfer(pSD, NULL, buffer, length)) {
+    // read the rest of the data and the CRC16 checksum in one DMA program
+    uint8_t crc_bytes[2];
+    spi_seg_t segs[] = {
+        {NULL, buffer + got, length - got},
+        {NULL, crc_bytes, sizeof crc_bytes},
+    };
+    if (!sd_spi_transfer_chain(pSD, segs, count_of(segs))) {
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
-    // Read the CRC16 checksum for the data block
-    crc = (sd_spi_write(pSD, SPI_FILL_CHAR) << 8);
-    crc |= sd_spi_write(pSD, SPI_FILL_CHAR);
+    crc = (crc_bytes[0] << 8) | crc_bytes[1];
 
 #if SD_CRC_ENABLED
     if (crc_on) {
@@ -898,37 +980,69 @@ int sd_read_blocks(sd_card_t *pSD, uint8_t *buffer, uint64_t ulSectorNumber,
     return status;
 }
 
-static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
-                              uint8_t token, uint32_t length) {
+// Sends one data block and returns the data response; the card is busy after
+static uint8_t sd_send_block(sd_card_t *pSD, const uint8_t *buffer,
+                             uint8_t token, uint32_t length) {
     uint16_t crc = (~0);
     uint8_t response = 0xFF;
 
-    // indicate start of block
-    sd_spi_write(pSD, token);
-
-    // write the data
-    bool ret = sd_spi_transfer(pSD, buffer, NULL, length);
-    myASSERT(ret);
-
 #if SD_CRC_ENABLED
     if (crc_on) {
         // Compute CRC
         crc = crc16((void *)buffer, length);
     }
 #endif
+    const uint8_t crc_bytes[2] = {crc >> 8, crc};
+
+    // start token, data, checksum CRC16 and the data response token, as one
+    // DMA program
+    spi_seg_t segs[] = {
+        {&token, NULL, 1},
+        {buffer, NULL, length},
+        {crc_bytes, NULL, sizeof crc_bytes},
+        {NULL, &response, 1},
+    };
+    bool ret = sd_spi_transfer_chain(pSD, segs, count_of(segs));
+    myASSERT(ret);
 
-    // write the checksum CRC16
-    sd_spi_write(pSD, crc >> 8);
-    sd_spi_write(pSD, crc);
+    return (response & SPI_DATA_RESPONSE_MASK);
+}
 
-    // check the response token
-    response = sd_spi_write(pSD, SPI_FILL_CHAR);
+static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
+                              uint8_t token, uint32_t length) {
+    uint8_t response = sd_send_block(pSD, buffer, token, length);
 
     // Wait for last block to be written
     if (false == sd_wait_ready(pSD, SD_COMMAND_TIMEOUT)) {
         DBG_PRINTF("%s:%d: Card not ready yet\r\n", __FILE__, __LINE__);
     }
-    return (response & SPI_DATA_RESPONSE_MASK);
+    return response;
+}
+
+// Sends the write command (CMD24, or ACMD23 and CMD25) for blockCnt blocks
+static int sd_write_cmd(sd_card_t *pSD, uint64_t ulSectorNumber,
+                        uint32_t blockCnt) {
+    uint64_t addr;
+
+    // SDSC Card (CCS=0) uses byte unit address
+    // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
+    if (SDCARD_V2HC == pSD->card_type) {
+        addr = ulSectorNumber;
+    } else {
+        addr = ulSectorNumber * _block_size;
+    }
+    if (blockCnt == 1) {
+        // Single block write command
+        return sd_cmd(pSD, CMD24_WRITE_BLOCK, addr, false, 0);
+    }
+    // Pre-erase setting prior to multiple block write operation
+    sd_cmd(pSD, ACMD23_SET_WR_BLK_ERASE_COUNT, blockCnt, 1, 0);
+
+    // Some SD cards want to be deselected between every bus transaction:
+    sd_spi_deselect_pulse(pSD);
+
+    // Multiple block write command
+    return sd_cmd(pSD, CMD25_WRITE_MULTIPLE_BLOCK, addr, false, 0);
 }
 
 /** Program blocks to a block device
@@ -953,24 +1067,15 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
         return SD_BLOCK_DEVICE_ERROR_PARAMETER;
 
-    int status = SD_BLOCK_DEVICE_ERROR_NONE;
+    int status;
     uint8_t response;
-    uint64_t addr;
 
-    // SDSC Card (CCS=0) uses byte unit address
-    // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
-    if (SDCARD_V2HC == pSD->card_type) {
-        addr = ulSectorNumber;
-    } else {
-        addr = ulSectorNumber * _block_size;
-    }
     // Send command to perform write operation
+    if (SD_BLOCK_DEVICE_ERROR_NONE !=
+        (status = sd_write_cmd(pSD, ulSectorNumber, blockCnt))) {
+        return status;
+    }
     if (blockCnt == 1) {
-        // Single block write command
-        if (SD_BLOCK_DEVICE_ERROR_NONE !=
-            (status = sd_cmd(pSD, CMD24_WRITE_BLOCK, addr, false, 0))) {
-            return status;
-        }
         // Write data
         response = sd_write_block(pSD, buffer, SPI_START_BLOCK, _block_size);
 
@@ -980,17 +1085,6 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
             status = SD_BLOCK_DEVICE_ERROR_WRITE;
         }
     } else {
-        // Pre-erase setting prior to multiple block write operation
-        sd_cmd(pSD, ACMD23_SET_WR_BLK_ERASE_COUNT, blockCnt, 1, 0);
-
-        // Some SD cards want to be deselected between every bus transaction:
-        sd_spi_deselect_pulse(pSD);
-
-        // Multiple block write command
-        if (SD_BLOCK_DEVICE_ERROR_NONE !=
-            (status = sd_cmd(pSD, CMD25_WRITE_MULTIPLE_BLOCK, addr, false, 0))) {
-            return status;
-        }
         // Write the data: one block at a time
         do {
             response = sd_write_block(pSD, buffer, SPI_START_BLK_MUL_WRITE, _block_size);
@@ -1024,6 +1118,164 @@ int sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     return status;
 }
 
+#ifndef SD_ASYNC_POLL_MIN_US
+#define SD_ASYNC_POLL_MIN_US 50 /*!< First busy poll interval */
+#endif
+#ifndef SD_ASYNC_POLL_MAX_US
+#define SD_ASYNC_POLL_MAX_US 1000 /*!< Longest busy poll interval */
+#endif
+
+// Starts waiting for the card to release DO
+static void async_wait_begin(sd_card_t *pSD) {
+    pSD->async_deadline = make_timeout_time_ms(SD_COMMAND_TIMEOUT);
+    pSD->async_interval_us = SD_ASYNC_POLL_MIN_US;
+}
+
+// Clocks one byte; false while the card is busy, with the next poll scheduled
+static bool async_wait_done(sd_card_t *pSD) {
+    if (sd_spi_write(pSD, SPI_FILL_CHAR) != 0x00) return true;
+    absolute_time_t now = get_absolute_time();
+    if (0 >= absolute_time_diff_us(now, pSD->async_deadline)) {
+        // Carry on, as the callers of sd_wait_ready() do
+        DBG_PRINTF("%s: Card not ready yet\r\n", __FUNCTION__);
+        return true;
+    }
+    pSD->async_next = delayed_by_us(now, pSD->async_interval_us);
+    if (pSD->async_interval_us < SD_ASYNC_POLL_MAX_US) {
+        pSD->async_interval_us *= 2;
+    }
+    return false;
+}
+
+// Ends the request in progress and returns it
+static sd_async_req_t *async_complete(sd_card_t *pSD, int status) {
+    sd_async_req_t *req = pSD->async_q[pSD->async_head];
+    req->status = status;
+    pSD->async_head = (pSD->async_head + 1) % SD_ASYNC_QUEUE_LEN;
+    --pSD->async_count;
+    pSD->async_state = ASYNC_IDLE;
+    return req;
+}
+
+// Carries the request in progress as far as the card allows.
+// Returns the request if it is done, else NULL.
+static sd_async_req_t *async_step(sd_card_t *pSD) {
+    sd_async_req_t *req = pSD->async_q[pSD->async_head];
+    int status;
+    for (;;) {
+        switch (pSD->async_state) {
+            case ASYNC_IDLE:
+                if (0 == req->count || req->sector + req->count > pSD->sectors)
+                    return async_complete(pSD, SD_BLOCK_DEVICE_ERROR_PARAMETER);
+                if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+                    return async_complete(pSD, SD_BLOCK_DEVICE_ERROR_PARAMETER);
+                if (!req->write) {
+                    return async_complete(
+                        pSD, in_sd_read_blocks(pSD, req->buffer, req->sector,
+                                               req->count));
+                }
+                pSD->async_block = 0;
+                pSD->async_status = SD_BLOCK_DEVICE_ERROR_NONE;
+                async_wait_begin(pSD);
+                pSD->async_state = ASYNC_CMD;
+                break;
+            case ASYNC_CMD:
+                if (!async_wait_done(pSD)) return NULL;
+                status = sd_write_cmd(pSD, req->sector, req->count);
+                if (SD_BLOCK_DEVICE_ERROR_NONE != status)
+                    return async_complete(pSD, status);
+                pSD->async_state = ASYNC_DATA;
+                break;
+            case ASYNC_DATA: {
+                uint8_t response = sd_send_block(
+                    pSD, req->buffer + pSD->async_block * _block_size,
+                    req->count > 1 ? SPI_START_BLK_MUL_WRITE : SPI_START_BLOCK,
+                    _block_size);
+                if (response != SPI_DATA_ACCEPTED) {
+                    DBG_PRINTF("Async Block Write failed: 0x%x\r\n", response);
+                    pSD->async_status = SD_BLOCK_DEVICE_ERROR_WRITE;
+                }
+                ++pSD->async_block;
+                async_wait_begin(pSD);
+                pSD->async_state = ASYNC_BUSY;
+                break;
+            }
+            case ASYNC_BUSY:
+                if (!async_wait_done(pSD)) return NULL;
+                if (SD_BLOCK_DEVICE_ERROR_NONE == pSD->async_status &&
+                    pSD->async_block < req->count) {
+                    pSD->async_state = ASYNC_DATA;
+                } else if (req->count > 1) {
+                    sd_spi_write(pSD, SPI_STOP_TRAN);
+                    // Busy starts after one more byte
+                    sd_spi_write(pSD, SPI_FILL_CHAR);
+                    async_wait_begin(pSD);
+                    pSD->async_state = ASYNC_STOP;
+                } else {
+                    pSD->async_state = ASYNC_STATUS;
+                }
+                break;
+            case ASYNC_STOP:
+                if (!async_wait_done(pSD)) return NULL;
+                pSD->async_state = ASYNC_STATUS;
+                break;
+            case ASYNC_STATUS: {
+                uint32_t stat = 0;
+                // Some SD cards want to be deselected between every bus transaction:
+                sd_spi_deselect_pulse(pSD);
+                status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+                if (SD_BLOCK_DEVICE_ERROR_NONE != pSD->async_status)
+                    status = pSD->async_status;
+                return async_complete(pSD, status);
+            }
+            default:
+                myASSERT(false);
+                return NULL;
+        }
+    }
+}
+
+int sd_async_submit(sd_card_t *pSD, sd_async_req_t *req) {
+    if (!mutex_is_initialized(&pSD->mutex)) return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    sd_lock(pSD);
+    if (SD_ASYNC_QUEUE_LEN == pSD->async_count) {
+        sd_unlock(pSD);
+        return SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK;
+    }
+    req->status = SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK;
+    pSD->async_q[(pSD->async_head + pSD->async_count) % SD_ASYNC_QUEUE_LEN] = req;
+    ++pSD->async_count;
+    sd_unlock(pSD);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+bool sd_async_poll(sd_card_t *pSD) {
+    if (!pSD->async_count) return false;
+    if (ASYNC_IDLE != pSD->async_state &&
+        0 < absolute_time_diff_us(get_absolute_time(), pSD->async_next)) {
+        return true;  // The card is still busy
+    }
+    // If the card is in use, try again next time
+    if (!mutex_try_enter(&pSD->mutex, NULL)) return true;
+    sd_async_req_t *done = NULL;
+    if (pSD->async_count) {
+        sd_spi_acquire(pSD);
+        done = async_step(pSD);
+        sd_spi_release(pSD);
+    }
+    bool pending = pSD->async_count;
+    sd_unlock(pSD);
+    if (done && done->callback) done->callback(done);
+    return pending;
+}
+
+int sd_async_wait(sd_card_t *pSD, sd_async_req_t *req) {
+    while (SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK == req->status) {
+        async_poll_sleep(pSD);
+    }
+    return req->status;
+}
+
 static int sd_init_medium(sd_card_t *pSD) {
     int32_t status = SD_BLOCK_DEVICE_ERROR_NONE;
     uint32_t response, arg;
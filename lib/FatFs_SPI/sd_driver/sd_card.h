@@ -32,6 +32,23 @@ extern "C" {
 
 typedef struct sd_card_t sd_card_t;
 
+// Asynchronous block I/O request (see sd_async_submit)
+typedef struct sd_async_req_t sd_async_req_t;
+typedef void (*sd_async_cb_t)(sd_async_req_t *req);
+struct sd_async_req_t {
+    bool write;              // true: buffer -> card, false: card -> buffer
+    uint8_t *buffer;         // count * 512 bytes; leave alone until done
+    uint64_t sector;         // First block (LBA)
+    uint32_t count;          // Number of blocks
+    sd_async_cb_t callback;  // Called when the request is done, or NULL
+    void *ctx;               // For the caller
+    volatile int status;     // SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK while pending
+};
+
+#ifndef SD_ASYNC_QUEUE_LEN
+#define SD_ASYNC_QUEUE_LEN 4  // Requests that can be queued per card
+#endif
+
 // "Class" representing SD Cards
 struct sd_card_t {
     const char *pcName;
@@ -55,6 +72,17 @@ struct sd_card_t {
     FATFS fatfs;
     bool mounted;
 
+    // Asynchronous request queue, driven by sd_async_poll()
+    sd_async_req_t *async_q[SD_ASYNC_QUEUE_LEN];
+    uint8_t async_head;              // Index of the request in progress
+    uint8_t async_count;             // Queued requests, including that one
+    uint8_t async_state;             // Step of the request in progress
+    uint32_t async_block;            // Blocks of it sent so far
+    int async_status;                // First error of it
+    absolute_time_t async_deadline;  // Timeout of the current busy wait
+    absolute_time_t async_next;      // Next time to look at the card
+    uint32_t async_interval_us;      // Current busy poll interval
+
     int (*init)(sd_card_t *sd_card_p);
     int (*write_blocks)(sd_card_t *sd_card_p, const uint8_t *buffer,
                     uint64_t ulSectorNumber, uint32_t blockCnt);
@@ -91,6 +119,32 @@ bool sd_card_detect(sd_card_t *pSD);
 uint64_t sd_sectors(sd_card_t *pSD);
 
 bool sd_init_driver();
+
+/* Asynchronous block I/O
+
+sd_write_blocks() and sd_read_blocks() keep the card and its SPI locked while
+the card programs a block, which can take 100+ ms on some cards. A request
+queued with sd_async_submit() is instead carried forward by sd_async_poll() one
+step at a time: each call sends or receives what the card is ready for and
+returns, and while the card is busy it only clocks one byte per poll interval
+(which grows from SD_ASYNC_POLL_MIN_US to SD_ASYNC_POLL_MAX_US). The locks are
+held only during a step, so the card can be polled from either core and other
+cards on the same SPI keep working.
+
+Reads are done in one step: the start token must not be lost to the fill
+byte clocked when the card is selected again.
+
+The callback runs from sd_async_poll(), with no locks held, so it may submit
+the next request. sd_write_blocks() and sd_read_blocks() finish a request that
+is in progress before starting (and so may run its callback) but do not wait
+for the rest of the queue.
+*/
+// Queues req; returns SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK if the queue is full
+int sd_async_submit(sd_card_t *pSD, sd_async_req_t *req);
+// Does whatever the card is ready for; returns true while requests are queued
+bool sd_async_poll(sd_card_t *pSD);
+// Polls until req is done and returns its status
+int sd_async_wait(sd_card_t *pSD, sd_async_req_t *req);
 bool sd_card_detect(sd_card_t *sd_card_p);
 
 #ifdef __cplusplus
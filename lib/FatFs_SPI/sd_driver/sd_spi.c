@@ -91,6 +91,11 @@ bool sd_spi_transfer(sd_card_t *pSD, const uint8_t *tx, uint8_t *rx,
     return spi_transfer(pSD->spi, tx, rx, length);
 }
 
+bool sd_spi_transfer_chain(sd_card_t *pSD, const spi_seg_t *segs,
+                           size_t count) {
+    return spi_transfer_chain(pSD->spi, segs, count);
+}
+
 uint8_t sd_spi_write(sd_card_t *pSD, const uint8_t value) {
     // TRACE_PRINTF("%s\n", __FUNCTION__);
     uint8_t received = SPI_FILL_CHAR;
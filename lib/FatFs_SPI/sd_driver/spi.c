@@ -54,47 +54,11 @@ void set_spi_dma_irq_channel(bool useChannel1, bool shared) {
     irqShared = shared;
 }
 
-// SPI Transfer: Read & Write (simultaneously) on SPI bus
-//   If the data that will be received is not important, pass NULL as rx.
-//   If the data that will be transmitted is not important,
-//     pass NULL as tx and then the SPI_FILL_CHAR is sent out as each data
-//     element.
-bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
-    // assert(512 == length || 1 == length);
-    assert(tx || rx);
-    // assert(!(tx && rx));
-
-    // tx write increment is already false
-    if (tx) {
-        channel_config_set_read_increment(&spi_p->tx_dma_cfg, true);
-    } else {
-        static const uint8_t dummy = SPI_FILL_CHAR;
-        tx = &dummy;
-        channel_config_set_read_increment(&spi_p->tx_dma_cfg, false);
-    }
-
-    // rx read increment is already false
-    if (rx) {
-        channel_config_set_write_increment(&spi_p->rx_dma_cfg, true);
-    } else {
-        static uint8_t dummy = 0xA5;
-        rx = &dummy;
-        channel_config_set_write_increment(&spi_p->rx_dma_cfg, false);
-    }
-
-    dma_channel_configure(spi_p->tx_dma, &spi_p->tx_dma_cfg,
-                          &spi_get_hw(spi_p->hw_inst)->dr,  // write address
-                          tx,                              // read address
-                          length,  // element count (each element is of
-                                   // size transfer_data_size)
-                          false);  // start
-    dma_channel_configure(spi_p->rx_dma, &spi_p->rx_dma_cfg,
-                          rx,                              // write address
-                          &spi_get_hw(spi_p->hw_inst)->dr,  // read address
-                          length,  // element count (each element is of
-                                   // size transfer_data_size)
-                          false);  // start
+static const uint8_t fill_char = SPI_FILL_CHAR;  // Source when tx is NULL
+static uint8_t drop_char;                         // Sink when rx is NULL
 
+// Starts the channels in mask and waits for the rx_dma IRQ
+static bool spi_run(spi_t *spi_p, uint32_t mask) {
     switch (spi_p->DMA_IRQ_num) {
         case DMA_IRQ_0:
             assert(!dma_channel_get_irq0_status(spi_p->rx_dma));
@@ -109,7 +73,7 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
 
     // start them exactly simultaneously to avoid races (in extreme cases
     // the FIFO could overflow)
-    dma_start_channel_mask((1u << spi_p->tx_dma) | (1u << spi_p->rx_dma));
+    dma_start_channel_mask(mask);
 
     /* Wait until master completes transfer or time out has occured. */
     uint32_t timeOut = 1000; /* Timeout 1 sec */
@@ -131,6 +95,106 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     return true;
 }
 
+// SPI Transfer: Read & Write (simultaneously) on SPI bus
+//   If the data that will be received is not important, pass NULL as rx.
+//   If the data that will be transmitted is not important,
+//     pass NULL as tx and then the SPI_FILL_CHAR is sent out as each data
+//     element.
+bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
+    // assert(512 == length || 1 == length);
+    assert(tx || rx);
+    // assert(!(tx && rx));
+
+    // The configurations were built by my_spi_init() and the data register
+    // ends of both channels are already set, so this is six register writes
+    dma_channel_set_config(spi_p->tx_dma,
+                           tx ? &spi_p->tx_dma_cfg : &spi_p->tx_fill_cfg,
+                           false);
+    dma_channel_set_read_addr(spi_p->tx_dma, tx ? tx : &fill_char, false);
+    dma_channel_set_trans_count(spi_p->tx_dma, length, false);
+    dma_channel_set_config(spi_p->rx_dma,
+                           rx ? &spi_p->rx_dma_cfg : &spi_p->rx_drop_cfg,
+                           false);
+    dma_channel_set_write_addr(spi_p->rx_dma, rx ? rx : &drop_char, false);
+    dma_channel_set_trans_count(spi_p->rx_dma, length, false);
+
+    return spi_run(spi_p, (1u << spi_p->tx_dma) | (1u << spi_p->rx_dma));
+}
+
+// Control word for one segment of a chain: when the segment is done the data
+// channel triggers its control channel, which loads the next control block.
+// IRQ_QUIET keeps the segments quiet; the null trigger at the end of the
+// rx_cbs list raises the IRQ instead.
+static inline uint32_t chain_ctrl(dma_channel_config c, uint ctrl_dma) {
+    channel_config_set_chain_to(&c, ctrl_dma);
+    channel_config_set_irq_quiet(&c, true);
+    return c.ctrl;
+}
+
+bool spi_transfer_chain(spi_t *spi_p, const spi_seg_t *segs, size_t count) {
+    if (!spi_p->chain_dma || count > SPI_CHAIN_MAX) {
+        for (size_t i = 0; i < count; ++i) {
+            if (segs[i].length &&
+                !spi_transfer(spi_p, segs[i].tx, segs[i].rx, segs[i].length))
+                return false;
+        }
+        return true;
+    }
+    uint32_t dr = (uintptr_t)&spi_get_hw(spi_p->hw_inst)->dr;
+    spi_dma_cb_t *tx_cb = spi_p->tx_cbs;
+    spi_dma_cb_t *rx_cb = spi_p->rx_cbs;
+    for (size_t i = 0; i < count; ++i) {
+        const spi_seg_t *seg = &segs[i];
+        assert(seg->tx || seg->rx);
+        if (!seg->length) continue;  // A zero count would never finish
+        tx_cb->ctrl = chain_ctrl(seg->tx ? spi_p->tx_dma_cfg : spi_p->tx_fill_cfg,
+                                 spi_p->tx_ctrl_dma);
+        tx_cb->write_addr = dr;
+        tx_cb->transfer_count = seg->length;
+        tx_cb->read_addr = (uintptr_t)(seg->tx ? seg->tx : &fill_char);
+        ++tx_cb;
+        rx_cb->ctrl = chain_ctrl(seg->rx ? spi_p->rx_dma_cfg : spi_p->rx_drop_cfg,
+                                 spi_p->rx_ctrl_dma);
+        rx_cb->write_addr = (uintptr_t)(seg->rx ? seg->rx : &drop_char);
+        rx_cb->transfer_count = seg->length;
+        rx_cb->read_addr = dr;
+        ++rx_cb;
+    }
+    if (tx_cb == spi_p->tx_cbs) return true;
+    // Null triggers: the channels stop, and rx_dma raises its IRQ
+    tx_cb->ctrl = chain_ctrl(spi_p->tx_fill_cfg, spi_p->tx_ctrl_dma);
+    tx_cb->write_addr = dr;
+    tx_cb->transfer_count = 0;
+    tx_cb->read_addr = 0;
+    rx_cb->ctrl = chain_ctrl(spi_p->rx_drop_cfg, spi_p->rx_ctrl_dma);
+    rx_cb->write_addr = (uintptr_t)&drop_char;
+    rx_cb->transfer_count = 0;
+    rx_cb->read_addr = 0;
+
+    dma_channel_set_read_addr(spi_p->tx_ctrl_dma, spi_p->tx_cbs, false);
+    dma_channel_set_read_addr(spi_p->rx_ctrl_dma, spi_p->rx_cbs, false);
+    bool ok = spi_run(spi_p,
+                      (1u << spi_p->tx_ctrl_dma) | (1u << spi_p->rx_ctrl_dma));
+    // The null trigger cleared the read address spi_transfer() relies on
+    dma_channel_set_read_addr(spi_p->rx_dma, &spi_get_hw(spi_p->hw_inst)->dr,
+                              false);
+    return ok;
+}
+
+// Control channel for data_dma: copies one spi_dma_cb_t (four words) into
+// the al3 registers of data_dma per trigger. The write address wraps on those
+// 16 bytes and the count is reloaded on each trigger, so only the read
+// address has to be set to start a chain.
+static void spi_ctrl_dma_init(uint ctrl_dma, uint data_dma) {
+    dma_channel_config c = dma_channel_get_default_config(ctrl_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, 4);  // 1 << 4 bytes
+    dma_channel_configure(ctrl_dma, &c, &dma_hw->ch[data_dma].al3_ctrl, NULL,
+                          sizeof(spi_dma_cb_t) / sizeof(uint32_t), false);
+}
+
 void spi_lock(spi_t *spi_p) {
     assert(mutex_is_initialized(&spi_p->mutex));
     mutex_enter_blocking(&spi_p->mutex);
@@ -209,6 +273,36 @@ bool my_spi_init(spi_t *spi_p) {
                                                        ? DREQ_SPI1_RX
                                                        : DREQ_SPI0_RX);
         channel_config_set_read_increment(&spi_p->rx_dma_cfg, false);
+        channel_config_set_write_increment(&spi_p->rx_dma_cfg, true);
+
+        // The same, but sending one fill byte over and over, and receiving
+        // into one byte that is thrown away
+        spi_p->tx_fill_cfg = spi_p->tx_dma_cfg;
+        channel_config_set_read_increment(&spi_p->tx_fill_cfg, false);
+        spi_p->rx_drop_cfg = spi_p->rx_dma_cfg;
+        channel_config_set_write_increment(&spi_p->rx_drop_cfg, false);
+
+        // The data register ends never change
+        dma_channel_set_write_addr(spi_p->tx_dma,
+                                   &spi_get_hw(spi_p->hw_inst)->dr, false);
+        dma_channel_set_read_addr(spi_p->rx_dma,
+                                  &spi_get_hw(spi_p->hw_inst)->dr, false);
+
+        // Chaining needs two more channels; without them
+        // spi_transfer_chain() runs one segment at a time
+        int tx_ctrl_dma = dma_claim_unused_channel(false);
+        int rx_ctrl_dma = dma_claim_unused_channel(false);
+        if (tx_ctrl_dma >= 0 && rx_ctrl_dma >= 0) {
+            spi_p->tx_ctrl_dma = tx_ctrl_dma;
+            spi_p->rx_ctrl_dma = rx_ctrl_dma;
+            spi_ctrl_dma_init(spi_p->tx_ctrl_dma, spi_p->tx_dma);
+            spi_ctrl_dma_init(spi_p->rx_ctrl_dma, spi_p->rx_dma);
+            spi_p->chain_dma = true;
+        } else {
+            if (tx_ctrl_dma >= 0) dma_channel_unclaim(tx_ctrl_dma);
+            if (rx_ctrl_dma >= 0) dma_channel_unclaim(rx_ctrl_dma);
+            spi_p->chain_dma = false;
+        }
 
         /* Theory: we only need an interrupt on rx complete,
         since if rx is complete, tx must also be complete. */
@@ -27,6 +27,28 @@ specific language governing permissions and limitations under the License.
 
 #define SPI_FILL_CHAR (0xFF)
 
+#ifndef SPI_CHAIN_MAX
+#define SPI_CHAIN_MAX 4  // Most segments in one spi_transfer_chain()
+#endif
+
+// One segment of spi_transfer_chain(): length bytes are sent from tx (or
+// SPI_FILL_CHAR if tx is NULL) while as many are received into rx (or
+// discarded if rx is NULL)
+typedef struct {
+    const uint8_t *tx;
+    uint8_t *rx;
+    size_t length;
+} spi_seg_t;
+
+// DMA control block: written by a control channel to the al3 registers of a
+// data channel (CTRL, WRITE_ADDR, TRANS_COUNT, READ_ADDR_TRIG)
+typedef struct {
+    uint32_t ctrl;
+    uint32_t write_addr;
+    uint32_t transfer_count;
+    uint32_t read_addr;
+} spi_dma_cb_t;
+
 // "Class" representing SPIs
 typedef struct {
     // SPI HW
@@ -47,8 +69,18 @@ typedef struct {
     // State variables:
     uint tx_dma;
     uint rx_dma;
-    dma_channel_config tx_dma_cfg;
-    dma_channel_config rx_dma_cfg;
+    // Built once by my_spi_init(), for each direction and mode:
+    dma_channel_config tx_dma_cfg;   // Send from a buffer
+    dma_channel_config rx_dma_cfg;   // Receive into a buffer
+    dma_channel_config tx_fill_cfg;  // Send SPI_FILL_CHAR
+    dma_channel_config rx_drop_cfg;  // Discard what is received
+    // Control channels that load tx_cbs and rx_cbs into tx_dma and rx_dma,
+    // if two free channels were found
+    bool chain_dma;
+    uint tx_ctrl_dma;
+    uint rx_ctrl_dma;
+    spi_dma_cb_t tx_cbs[SPI_CHAIN_MAX + 1];  // Segments and a null trigger
+    spi_dma_cb_t rx_cbs[SPI_CHAIN_MAX + 1];
     irq_handler_t dma_isr; // Ignored: no longer used
     bool initialized;  
     semaphore_t sem;
@@ -60,6 +92,10 @@ extern "C" {
 #endif
   
 bool __not_in_flash_func(spi_transfer)(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length);  
+// Runs the segments back to back as one DMA program, without the CPU in
+// between; falls back to one spi_transfer() per segment without control
+// channels or with more than SPI_CHAIN_MAX segments
+bool __not_in_flash_func(spi_transfer_chain)(spi_t *pSPI, const spi_seg_t *segs, size_t count);
 void spi_lock(spi_t *pSPI);
 void spi_unlock(spi_t *pSPI);
 bool my_spi_init(spi_t *pSPI);
@@ -16,6 +16,7 @@ specific language governing permissions and limitations under the License.
 #include <errno.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -86,6 +87,38 @@ int fresult2errno(FRESULT fr) {
     }
 }
 
+// Writes out buffered data, or gives back read-ahead data by moving the file
+// position back to the logical stream position
+static FRESULT stream_flush(FF_FILE *pxStream) {
+    FRESULT fr = FR_OK;
+    if (FF_STREAM_WRITING == pxStream->state && pxStream->pos) {
+        UINT bw = 0;
+        fr = f_write(&pxStream->fil, pxStream->buf, pxStream->pos, &bw);
+        if (FR_OK == fr && bw != pxStream->pos) fr = FR_DENIED;  // Disk full
+    } else if (FF_STREAM_READING == pxStream->state && pxStream->pos < pxStream->len) {
+        fr = f_lseek(&pxStream->fil,
+                     f_tell(&pxStream->fil) - (pxStream->len - pxStream->pos));
+    }
+    pxStream->pos = 0;
+    pxStream->len = 0;
+    pxStream->state = FF_STREAM_IDLE;
+    return fr;
+}
+// Reads the next buffer full; false at end of file or on error
+static bool stream_fill(FF_FILE *pxStream, FRESULT *pfr) {
+    UINT br = 0;
+    *pfr = f_read(&pxStream->fil, pxStream->buf, pxStream->size, &br);
+    pxStream->pos = 0;
+    pxStream->len = br;
+    pxStream->state = br ? FF_STREAM_READING : FF_STREAM_IDLE;
+    return br > 0;
+}
+// Switches a buffered stream to the given direction
+static FRESULT stream_turn(FF_FILE *pxStream, uint8_t state) {
+    if (pxStream->state == state || FF_STREAM_IDLE == pxStream->state)
+        return FR_OK;
+    return stream_flush(pxStream);
+}
 FF_FILE *ff_fopen(const char *pcFile, const char *pcMode) {
     TRACE_PRINTF("%s\n", __func__);
     // FRESULT f_open (FIL* fp, const TCHAR* path, BYTE mode);
@@ -94,12 +127,13 @@ FF_FILE *ff_fopen(const char *pcFile, const char *pcMode) {
     //  const TCHAR* path, /* [IN] File name */
     //  BYTE mode          /* [IN] Mode flags */
     //);
-    FIL *fp = malloc(sizeof(FIL));
+    FF_FILE *fp = calloc(1, sizeof(FF_FILE));
     if (!fp) {
         errno = ENOMEM;
         return NULL;
     }
-    FRESULT fr = f_open(fp, pcFile, posix2mode(pcMode));
+    fp->mode = _IONBF;
+    FRESULT fr = f_open(&fp->fil, pcFile, posix2mode(pcMode));
     errno = fresult2errno(fr);
     if (FR_OK != fr) {
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
@@ -113,10 +147,13 @@ int ff_fclose(FF_FILE *pxStream) {
     // FRESULT f_close (
     //  FIL* fp     /* [IN] Pointer to the file object */
     //);
-    FRESULT fr = f_close(pxStream);
+    FRESULT fr = stream_flush(pxStream);
+    FRESULT fr2 = f_close(&pxStream->fil);
+    if (FR_OK == fr) fr = fr2;
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
+    if (pxStream->own_buf) free(pxStream->buf);
     free(pxStream);
     if (FR_OK == fr)
         return 0;
@@ -152,12 +189,36 @@ size_t ff_fwrite(const void *pvBuffer, size_t xSize, size_t xItems,
     //  UINT* bw          /* [OUT] Pointer to the variable to return number of
     //  bytes written */
     //);
-    UINT bw = 0;
-    FRESULT fr = f_write(pxStream, pvBuffer, xSize * xItems, &bw);
+    const char *src = pvBuffer;
+    size_t btw = xSize * xItems;
+    size_t done = 0;
+    FRESULT fr = FR_OK;
+    if (_IONBF != pxStream->mode) {
+        fr = stream_turn(pxStream, FF_STREAM_WRITING);
+        if (FR_OK == fr && pxStream->pos + btw > pxStream->size)
+            fr = stream_flush(pxStream);  // Does not fit behind pending data
+        if (FR_OK == fr && btw < pxStream->size) {
+            memcpy(pxStream->buf + pxStream->pos, src, btw);
+            pxStream->pos += btw;
+            pxStream->state = FF_STREAM_WRITING;
+            done = btw;
+            if (pxStream->pos == pxStream->size ||
+                (_IOLBF == pxStream->mode && memchr(src, '\n', btw))) {
+                fr = stream_flush(pxStream);
+                if (FR_OK != fr) done = 0;
+            }
+            btw = 0;
+        }
+    }
+    if (FR_OK == fr && btw) {  // Unbuffered, or large enough to bypass the buffer
+        UINT bw = 0;
+        fr = f_write(&pxStream->fil, src, btw, &bw);
+        done = bw;
+    }
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
-    return bw / xSize;
+    return done / xSize;
 }
 size_t ff_fread(void *pvBuffer, size_t xSize, size_t xItems,
                 FF_FILE *pxStream) {
@@ -168,12 +229,33 @@ size_t ff_fread(void *pvBuffer, size_t xSize, size_t xItems,
     //  UINT btr,    /* [IN] Number of bytes to read */
     //  UINT* br     /* [OUT] Number of bytes read */
     //);
-    UINT br = 0;
-    FRESULT fr = f_read(pxStream, pvBuffer, xSize * xItems, &br);
+    char *dst = pvBuffer;
+    size_t btr = xSize * xItems;
+    size_t done = 0;
+    FRESULT fr = FR_OK;
+    if (_IONBF != pxStream->mode) {
+        fr = stream_turn(pxStream, FF_STREAM_READING);
+        while (FR_OK == fr && done < btr) {
+            if (pxStream->pos == pxStream->len) {
+                if (btr - done >= pxStream->size) break;  // Bypass the buffer
+                if (!stream_fill(pxStream, &fr)) break;
+            }
+            size_t n = pxStream->len - pxStream->pos;
+            if (n > btr - done) n = btr - done;
+            memcpy(dst + done, pxStream->buf + pxStream->pos, n);
+            pxStream->pos += n;
+            done += n;
+        }
+    }
+    if (FR_OK == fr && done < btr) {
+        UINT br = 0;
+        fr = f_read(&pxStream->fil, dst + done, btr - done, &br);
+        done += br;
+    }
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
-    return br / xSize;
+    return done / xSize;
 }
 int ff_chdir(const char *pcDirectoryName) {
     TRACE_PRINTF("%s\n", __func__);
@@ -237,17 +319,25 @@ int ff_fputc(int iChar, FF_FILE *pxStream) {
     //  UINT* bw          /* [OUT] Pointer to the variable to return number of
     //  bytes written */
     //);
-    UINT bw = 0;
-    uint8_t buff[1];
-    buff[0] = iChar;
-    FRESULT fr = f_write(pxStream, buff, 1, &bw);
-    if (FR_OK != fr)
-        TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
-    errno = fresult2errno(fr);
+    if (_IONBF != pxStream->mode && FF_STREAM_READING != pxStream->state) {
+        // Buffered: a byte store, FatFs is only called when the buffer is
+        // written out
+        pxStream->buf[pxStream->pos++] = iChar;
+        pxStream->state = FF_STREAM_WRITING;
+        if (pxStream->pos < pxStream->size &&
+            !(_IOLBF == pxStream->mode && '\n' == (char)iChar)) {
+            errno = 0;
+            return iChar;
+        }
+        FRESULT fr = stream_flush(pxStream);
+        errno = fresult2errno(fr);
+        return FR_OK == fr ? iChar : -1;
+    }
+    size_t n = ff_fwrite(&(char){iChar}, 1, 1, pxStream);
     // On success the byte written to the file is returned. If any other value
     // is returned then the byte was not written to the file and the task's
     // errno will be set to indicate the reason.
-    if (1 == bw)
+    if (1 == n)
         return iChar;
     else {
         return -1;
@@ -261,16 +351,14 @@ int ff_fgetc(FF_FILE *pxStream) {
     //  UINT btr,    /* [IN] Number of bytes to read */
     //  UINT* br     /* [OUT] Number of bytes read */
     //);
+    if (FF_STREAM_READING == pxStream->state && pxStream->pos < pxStream->len)
+        return (uint8_t)pxStream->buf[pxStream->pos++];
     uint8_t buff[1] = {0};
-    UINT br;
-    FRESULT fr = f_read(pxStream, buff, 1, &br);
-    if (FR_OK != fr)
-        TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
-    errno = fresult2errno(fr);
+    size_t n = ff_fread(buff, 1, 1, pxStream);
     // On success the byte read from the file system is returned. If a byte
     // could not be read from the file because the read position is already at
     // the end of the file then FF_EOF is returned.
-    if (1 == br)
+    if (1 == n)
         return buff[0];
     else
         return FF_EOF;
@@ -304,25 +392,30 @@ long ff_ftell(FF_FILE *pxStream) {
     // FSIZE_t f_tell (
     //  FIL* fp   /* [IN] File object */
     //);
-    FSIZE_t pos = f_tell(pxStream);
+    FSIZE_t pos = f_tell(&pxStream->fil);
+    if (FF_STREAM_WRITING == pxStream->state) pos += pxStream->pos;
+    if (FF_STREAM_READING == pxStream->state) pos -= pxStream->len - pxStream->pos;
     myASSERT(pos < LONG_MAX);
     return pos;
 }
 int ff_fseek(FF_FILE *pxStream, int iOffset, int iWhence) {
     TRACE_PRINTF("%s\n", __func__);
-    FRESULT fr = -1;
+    FRESULT fr = stream_flush(pxStream);
+    errno = fresult2errno(fr);
+    if (FR_OK != fr) return -1;
+    FIL *fp = &pxStream->fil;
     switch (iWhence) {
         case FF_SEEK_CUR:  // The current file position.
-            if ((int)f_tell(pxStream) + iOffset < 0) return -1;
-            fr = f_lseek(pxStream, f_tell(pxStream) + iOffset);
+            if ((int)f_tell(fp) + iOffset < 0) return -1;
+            fr = f_lseek(fp, f_tell(fp) + iOffset);
             break;
         case FF_SEEK_END:  // The end of the file.
-            if ((int)f_size(pxStream) + iOffset < 0) return -1;
-            fr = f_lseek(pxStream, f_size(pxStream) + iOffset);
+            if ((int)f_size(fp) + iOffset < 0) return -1;
+            fr = f_lseek(fp, f_size(fp) + iOffset);
             break;
         case FF_SEEK_SET:  // The beginning of the file.
             if (iOffset < 0) return -1;
-            fr = f_lseek(pxStream, iOffset);
+            fr = f_lseek(fp, iOffset);
             break;
         default:
             myASSERT(!"Bad iWhence");
@@ -333,6 +426,23 @@ int ff_fseek(FF_FILE *pxStream, int iOffset, int iWhence) {
     else
         return -1;
 }
+int ff_rewind(FF_FILE *pxStream) {
+    TRACE_PRINTF("%s\n", __func__);
+    // Unlike ff_fseek(), read-ahead is simply dropped: giving it back first
+    // could cost a sector read for a position that is left at once
+    FRESULT fr = FR_OK;
+    if (FF_STREAM_WRITING == pxStream->state) fr = stream_flush(pxStream);
+    pxStream->pos = 0;
+    pxStream->len = 0;
+    pxStream->state = FF_STREAM_IDLE;
+    FRESULT fr2 = f_lseek(&pxStream->fil, 0);
+    if (FR_OK == fr) fr = fr2;
+    errno = fresult2errno(fr);
+    if (FR_OK == fr)
+        return 0;
+    else
+        return -1;
+}
 int ff_findfirst(const char *pcDirectory, FF_FindData_t *pxFindData) {
     TRACE_PRINTF("%s(%s)\n", __func__, pcDirectory);
     // FRESULT f_findfirst (
@@ -389,11 +499,13 @@ int ff_findnext(FF_FindData_t *pxFindData) {
 }
 FF_FILE *ff_truncate(const char *pcFileName, long lTruncateSize) {
     TRACE_PRINTF("%s\n", __func__);
-    FIL *fp = malloc(sizeof(FIL));
-    if (!fp) {
+    FF_FILE *pxStream = calloc(1, sizeof(FF_FILE));
+    if (!pxStream) {
         errno = ENOMEM;
         return NULL;
     }
+    pxStream->mode = _IONBF;
+    FIL *fp = &pxStream->fil;
     FRESULT fr = f_open(fp, pcFileName, FA_OPEN_APPEND | FA_WRITE);
     if (FR_OK != fr)
         printf("%s: f_open error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
@@ -419,13 +531,14 @@ FF_FILE *ff_truncate(const char *pcFileName, long lTruncateSize) {
                fr);
     errno = fresult2errno(fr);
     if (FR_OK == fr)
-        return fp;
+        return pxStream;
     else
         return NULL;
 }
 int ff_seteof(FF_FILE *pxStream) {
     TRACE_PRINTF("%s\n", __func__);
-    FRESULT fr = f_truncate(pxStream);
+    FRESULT fr = stream_flush(pxStream);
+    if (FR_OK == fr) fr = f_truncate(&pxStream->fil);
     errno = fresult2errno(fr);
     if (FR_OK == fr)
         return 0;
@@ -449,15 +562,129 @@ int ff_rename(const char *pcOldName, const char *pcNewName,
     else
         return -1;
 }
+// First '\n' in p[0..n), or NULL; compares 4 bytes per step
+static const char *find_eol(const char *p, size_t n) {
+    const char *end = p + n;
+    while (p < end && ((uintptr_t)p & 3)) {
+        if (*p == '\n') return p;
+        p++;
+    }
+    while (end - p >= 4) {
+        uint32_t v;
+        memcpy(&v, p, 4);  // Aligned here, compiles to a single load
+        v ^= 0x0A0A0A0Au;  // Bytes equal to '\n' become zero
+        if ((v - 0x01010101u) & ~v & 0x80808080u) break;
+        p += 4;
+    }
+    while (p < end) {
+        if (*p == '\n') return p;
+        p++;
+    }
+    return NULL;
+}
 char *ff_fgets(char *pcBuffer, size_t xCount, FF_FILE *pxStream) {
     TRACE_PRINTF("%s\n", __func__);
-    TCHAR *p = f_gets(pcBuffer, xCount, pxStream);
+    // Reads in chunks that end at a sector boundary instead of f_gets()'s one
+    // f_read() per byte. Buffered, the bytes read past the newline stay in the
+    // stream buffer. Unbuffered, they are given back with an f_lseek(), which
+    // costs no disk access only while the sector is in the FIL buffer: a
+    // chunk is kept under a full sector, because f_read() copies a whole
+    // sector straight to the caller without loading it there.
+    if (!xCount) return NULL;
+    FIL *fp = &pxStream->fil;
+    FRESULT fr = FR_OK;
+    size_t n = 0;
+    if (_IONBF != pxStream->mode) {
+        fr = stream_turn(pxStream, FF_STREAM_READING);
+        while (FR_OK == fr && n + 1 < xCount) {
+            if (pxStream->pos == pxStream->len && !stream_fill(pxStream, &fr)) break;
+            const char *src = pxStream->buf + pxStream->pos;
+            size_t avail = pxStream->len - pxStream->pos;
+            if (avail > xCount - 1 - n) avail = xCount - 1 - n;
+            const char *eol = find_eol(src, avail);
+            size_t take = eol ? (size_t)(eol - src) + 1 : avail;
+            memcpy(pcBuffer + n, src, take);
+            pxStream->pos += take;
+            n += take;
+            if (eol) break;
+        }
+    } else {
+        while (n + 1 < xCount) {
+            UINT chunk = FF_MIN_SS - (UINT)(f_tell(fp) % FF_MIN_SS);
+            if (chunk == FF_MIN_SS) chunk--;
+            if (chunk > xCount - 1 - n) chunk = xCount - 1 - n;
+            UINT br = 0;
+            fr = f_read(fp, pcBuffer + n, chunk, &br);
+            if (FR_OK != fr || !br) break;
+            const char *eol = find_eol(pcBuffer + n, br);
+            if (eol) {
+                UINT used = eol - (pcBuffer + n) + 1;
+                if (used < br) fr = f_lseek(fp, f_tell(fp) - (br - used));
+                n += used;
+                break;
+            }
+            n += br;
+        }
+    }
+    pcBuffer[n] = 0;
+    if (FR_OK != fr)
+        TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     // On success a pointer to pcBuffer is returned. If there is a read error
     // then NULL is returned and the task's errno is set to indicate the reason.
-    if (p == pcBuffer)
+    if (n && FR_OK == fr)
         return pcBuffer;
     else {
-        errno = EIO;
+        errno = FR_OK == fr ? EIO : fresult2errno(fr);
         return NULL;
     }
-}
\ No newline at end of file
+}
+int ff_setvbuf(FF_FILE *pxStream, char *pcBuffer, int iMode, size_t xSize) {
+    TRACE_PRINTF("%s\n", __func__);
+    if ((_IOFBF != iMode && _IOLBF != iMode && _IONBF != iMode) ||
+        (_IONBF != iMode && !xSize)) {
+        errno = EINVAL;
+        return -1;
+    }
+    FRESULT fr = stream_flush(pxStream);
+    errno = fresult2errno(fr);
+    if (FR_OK != fr) return -1;
+    if (pxStream->own_buf) free(pxStream->buf);
+    pxStream->buf = NULL;
+    pxStream->size = 0;
+    pxStream->own_buf = false;
+    pxStream->mode = _IONBF;
+    if (_IONBF == iMode) return 0;
+    if (!pcBuffer) {
+        pcBuffer = malloc(xSize);
+        if (!pcBuffer) {
+            errno = ENOMEM;
+            return -1;
+        }
+        pxStream->own_buf = true;
+    }
+    pxStream->buf = pcBuffer;
+    pxStream->size = xSize;
+    pxStream->mode = iMode;
+    return 0;
+}
+int ff_fflush(FF_FILE *pxStream) {
+    TRACE_PRINTF("%s\n", __func__);
+    FRESULT fr = FR_OK;
+    if (FF_STREAM_WRITING == pxStream->state) fr = stream_flush(pxStream);
+    errno = fresult2errno(fr);
+    if (FR_OK == fr)
+        return 0;
+    else
+        return FF_EOF;
+}
+long ff_filelength(FF_FILE *pxStream) {
+    FSIZE_t size = f_size(&pxStream->fil);
+    FSIZE_t end = f_tell(&pxStream->fil);
+    if (FF_STREAM_WRITING == pxStream->state) end += pxStream->pos;
+    return end > size ? end : size;
+}
+int ff_feof(FF_FILE *pxStream) {
+    if (FF_STREAM_READING == pxStream->state && pxStream->pos < pxStream->len)
+        return 0;
+    return f_eof(&pxStream->fil);
+}
@@ -0,0 +1,84 @@
+#include "door.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+
+bool door_init(door_t* d, uint8_t id, const door_config_t* cfg) {
+    memset(d, 0, sizeof(*d));
+    d->id = id;
+    d->policy = &cfg->policy;
+    uid_cache_init(&d->recent, cfg->policy.repeat_window_ms);
+
+    if (cfg->uart) {
+        uart_link_init(&d->link, cfg->uart, cfg->tx_pin, cfg->rx_pin);
+        return true;
+    }
+    return uart_link_init_pio(&d->link, cfg->pio, cfg->tx_pin, cfg->rx_pin);
+}
+
+bool door_authorized(const door_t* d, const char* uid) {
+    for (uint8_t i = 0; i < d->policy->num_authorized; i++) {
+        if (strcmp(uid, d->policy->authorized_uids[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void queue_push(door_queue_t* q, door_t* d) {
+    uint16_t waiting = (uint16_t)(q->head - q->tail);
+    if (waiting >= DOOR_QUEUE_LEN) {
+        d->dropped++;
+        return;
+    }
+    door_event_t* ev = &q->events[q->head & (DOOR_QUEUE_LEN - 1)];
+    ev->door = d->id;
+    ev->queued_us = time_us_32();
+    memcpy(ev->line, d->line, d->line_len + 1);
+    q->head++;
+    d->lines++;
+    if (waiting + 1 > q->high_water) {
+        q->high_water = (uint8_t)(waiting + 1);
+    }
+}
+
+void door_poll(door_t* d, door_queue_t* q) {
+    char c;
+    for (int n = 0; n < DOOR_POLL_BUDGET && uart_link_getc(&d->link, &c); n++) {
+        if (c != '\n' && c != '\r') {
+            if (d->line_len < DOOR_LINE_MAX - 1) {
+                d->line[d->line_len++] = c;
+            }
+            continue;
+        }
+        if (d->line_len == 0) {
+            continue;
+        }
+        d->line[d->line_len] = '\0';
+        // Baud negotiation replies are handled by the link itself
+        if (!uart_link_handle_line(&d->link, d->line)) {
+            queue_push(q, d);
+        }
+        d->line_len = 0;
+    }
+
+    // Baud negotiation timers and error-rate fallback
+    uart_link_poll(&d->link);
+}
+
+void door_queue_init(door_queue_t* q) {
+    memset(q, 0, sizeof(*q));
+}
+
+bool door_queue_pop(door_queue_t* q, door_event_t* ev) {
+    if (q->tail == q->head) {
+        return false;
+    }
+    *ev = q->events[q->tail & (DOOR_QUEUE_LEN - 1)];
+    q->tail++;
+    uint32_t wait_us = time_us_32() - ev->queued_us;
+    if (wait_us > q->max_wait_us) {
+        q->max_wait_us = wait_us;
+    }
+    return true;
+}
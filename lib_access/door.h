@@ -0,0 +1,103 @@
+#ifndef __DOOR_H__
+#define __DOOR_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "uart_link.h"
+#include "uid_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ One door = one Arduino reader front-end on its own link (uart0, uart1 or a
+ PIO soft UART) with its own access policy.
+
+ The link's RX interrupt fills the link ring buffer; door_poll() turns the
+ buffered bytes into lines and pushes them, tagged with the door id, into the
+ event queue shared by all doors. The main loop pops events in arrival order,
+ so one busy door cannot starve the others and a slow handler (SD write) only
+ delays events, it does not lose bytes.
+
+ Door ids start at 1; 0 is the hub itself in the binary log.
+*/
+
+#define DOOR_MAX          8
+#define DOOR_NAME_LEN     8
+#define DOOR_LINE_MAX     50
+#define DOOR_QUEUE_LEN    32  // Events shared by all doors (power of two)
+#define DOOR_POLL_BUDGET  64  // Bytes taken from one link per door_poll() call
+
+typedef struct {
+    char name[DOOR_NAME_LEN];           // Shown on the display and in text logs
+    const char* const* authorized_uids;
+    uint8_t num_authorized;
+    uint32_t repeat_window_ms;          // Duplicate-read suppression window
+    uint32_t hold_ms;                   // LED time after a decision
+} door_policy_t;
+
+typedef struct {
+    door_policy_t policy;
+    uart_inst_t* uart;                  // Hardware UART, or NULL for a PIO link
+    PIO pio;                            // PIO block of a soft UART link
+    uint8_t tx_pin;                     // UART_LINK_NO_PIN: receive-only PIO link
+    uint8_t rx_pin;
+} door_config_t;
+
+typedef struct {
+    uint8_t id;
+    const door_policy_t* policy;
+    uart_link_t link;
+    uid_cache_t recent;                 // Recently decided UIDs at this door
+    char line[DOOR_LINE_MAX];
+    uint8_t line_len;
+
+    uint32_t lines;                     // Lines queued
+    uint32_t dropped;                   // Lines lost because the queue was full
+} door_t;
+
+typedef struct {
+    uint8_t door;                       // door_t.id
+    uint32_t queued_us;                 // time_us_32() when the line was complete
+    char line[DOOR_LINE_MAX];
+} door_event_t;
+
+typedef struct {
+    door_event_t events[DOOR_QUEUE_LEN];
+    uint16_t head;
+    uint16_t tail;
+    uint8_t high_water;                 // Most events ever waiting
+    uint32_t max_wait_us;               // Longest queued -> popped delay
+} door_queue_t;
+
+/**
+ * @brief Sets up a door and its link from cfg.
+ * @return false if the link could not be created (no free PIO state machine).
+ */
+bool door_init(door_t* d, uint8_t id, const door_config_t* cfg);
+
+/**
+ * @brief Checks uid against the door's policy.
+ */
+bool door_authorized(const door_t* d, const char* uid);
+
+/**
+ * @brief Moves complete lines from the door's link into q; runs the link timers.
+ */
+void door_poll(door_t* d, door_queue_t* q);
+
+void door_queue_init(door_queue_t* q);
+
+/**
+ * @brief Takes the oldest event from q.
+ * @return false if the queue is empty.
+ */
+bool door_queue_pop(door_queue_t* q, door_event_t* ev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DOOR_H__
@@ -0,0 +1,70 @@
+#include "uid_cache.h"
+
+#include <string.h>
+
+void uid_cache_init(uid_cache_t* c, uint32_t window_ms) {
+    memset(c, 0, sizeof(*c));
+    c->window_ms = window_ms;
+}
+
+// last_seen_ms may lie ahead of now_ms while the decision is still being shown
+static bool expired(const uid_cache_t* c, const uid_cache_entry_t* e, uint64_t now_ms) {
+    return now_ms > e->last_seen_ms && now_ms - e->last_seen_ms > c->window_ms;
+}
+
+static void release(uid_cache_entry_t* e, uid_cache_report_t report, void* ctx) {
+    if (e->used && e->repeats > 0 && report) {
+        report(e, ctx);
+    }
+    e->used = false;
+}
+
+uid_cache_entry_t* uid_cache_lookup(uid_cache_t* c, const char* uid, uint64_t now_ms) {
+    for (int i = 0; i < UID_CACHE_SIZE; i++) {
+        uid_cache_entry_t* e = &c->entries[i];
+        if (e->used && !expired(c, e, now_ms) && strcmp(e->uid, uid) == 0) {
+            e->repeats++;
+            if (now_ms > e->last_seen_ms) {
+                e->last_seen_ms = now_ms;
+            }
+            return e;
+        }
+    }
+    return NULL;
+}
+
+void uid_cache_insert(uid_cache_t* c, const char* uid, bool granted, uint64_t now_ms,
+                      uid_cache_report_t report, void* ctx) {
+    // Same UID after its window, a free slot, or the least recently seen one
+    uid_cache_entry_t* slot = &c->entries[0];
+    for (int i = 0; i < UID_CACHE_SIZE; i++) {
+        uid_cache_entry_t* e = &c->entries[i];
+        if (e->used && strcmp(e->uid, uid) == 0) {
+            slot = e;
+            break;
+        }
+        if (!e->used) {
+            if (slot->used) slot = e;
+        } else if (slot->used && e->last_seen_ms < slot->last_seen_ms) {
+            slot = e;
+        }
+    }
+    release(slot, report, ctx);
+
+    strncpy(slot->uid, uid, sizeof(slot->uid) - 1);
+    slot->uid[sizeof(slot->uid) - 1] = '\0';
+    slot->used = true;
+    slot->granted = granted;
+    slot->repeats = 0;
+    slot->first_ms = now_ms;
+    slot->last_seen_ms = now_ms;
+}
+
+void uid_cache_sweep(uid_cache_t* c, uint64_t now_ms, uid_cache_report_t report, void* ctx) {
+    for (int i = 0; i < UID_CACHE_SIZE; i++) {
+        uid_cache_entry_t* e = &c->entries[i];
+        if (e->used && expired(c, e, now_ms)) {
+            release(e, report, ctx);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef __UID_CACHE_H__
+#define __UID_CACHE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Small LRU of recently decided UIDs. A read of the same UID within window_ms
+ of its previous read is a repeat (e.g. a badge resting on the reader): the
+ caller skips the decision, LED, display and log write, and the entry only
+ counts it. The window slides with every repeat; once it expires the entry
+ is reported once through uid_cache_sweep() with its repeat count.
+*/
+
+#define UID_CACHE_SIZE    8
+#define UID_CACHE_UID_LEN 21 // 10-byte UID in hex plus terminator
+
+typedef struct {
+    char uid[UID_CACHE_UID_LEN];
+    bool used;
+    bool granted;            // Decision taken on the first read
+    uint32_t repeats;        // Reads collapsed into that decision
+    uint64_t first_ms;       // Time of the decision
+    uint64_t last_seen_ms;   // Time of the latest read
+} uid_cache_entry_t;
+
+typedef struct {
+    uid_cache_entry_t entries[UID_CACHE_SIZE];
+    uint32_t window_ms;
+} uid_cache_t;
+
+// Called for an entry whose window expired after at least one repeat
+typedef void (*uid_cache_report_t)(const uid_cache_entry_t* entry, void* ctx);
+
+void uid_cache_init(uid_cache_t* c, uint32_t window_ms);
+
+/**
+ * @brief Looks uid up; a hit within the window counts a repeat and extends it.
+ * @return The entry on a repeat, NULL if a fresh decision is needed.
+ */
+uid_cache_entry_t* uid_cache_lookup(uid_cache_t* c, const char* uid, uint64_t now_ms);
+
+/**
+ * @brief Stores a fresh decision, replacing the least recently seen entry.
+ */
+void uid_cache_insert(uid_cache_t* c, const char* uid, bool granted, uint64_t now_ms,
+                      uid_cache_report_t report, void* ctx);
+
+/**
+ * @brief Reports and frees entries whose window has expired.
+ */
+void uid_cache_sweep(uid_cache_t* c, uint64_t now_ms, uid_cache_report_t report, void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UID_CACHE_H__
@@ -0,0 +1,276 @@
+#include "uart_link.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "uart_link.pio.h"
+
+// Rates offered to the sketch, highest first
+static const uint32_t link_offers[] = { 500000, 250000, 115200 };
+#define NUM_OFFERS (sizeof(link_offers) / sizeof(link_offers[0]))
+
+// Links served by the RX interrupt handlers
+static uart_link_t* link_registry[UART_LINK_MAX_LINKS];
+static uint8_t num_links;
+
+// Program offsets per PIO block, -1 until loaded
+static int rx_offset[NUM_PIOS] = { -1, -1 };
+static int tx_offset[NUM_PIOS] = { -1, -1 };
+
+static uint64_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static void send_line(uart_link_t* l, const char* cmd, uint32_t arg) {
+    char line[32];
+    if (arg) {
+        snprintf(line, sizeof(line), "%s:%lu\n", cmd, (unsigned long)arg);
+    } else {
+        snprintf(line, sizeof(line), "%s\n", cmd);
+    }
+    if (l->uart) {
+        uart_puts(l->uart, line);
+    } else {
+        for (const char* p = line; *p; p++) {
+            pio_sm_put_blocking(l->pio, l->sm_tx, (uint8_t)*p);
+        }
+    }
+}
+
+static void set_baud(uart_link_t* l, uint32_t baud) {
+    if (l->uart) {
+        uart_tx_wait_blocking(l->uart); // Let the last frame leave at the old rate
+        uart_set_baudrate(l->uart, baud);
+    } else {
+        // Same for the TX state machine: wait until it stalls on an empty FIFO
+        uint32_t stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + l->sm_tx);
+        l->pio->fdebug = stall;
+        while (!(l->pio->fdebug & stall)) {
+            tight_loop_contents();
+        }
+        uint32_t div_int;
+        uint8_t div_frac;
+        uart_link_pio_clkdiv(baud, &div_int, &div_frac);
+        pio_sm_set_clkdiv_int_frac8(l->pio, l->sm_rx, div_int, div_frac);
+        pio_sm_set_clkdiv_int_frac8(l->pio, l->sm_tx, div_int, div_frac);
+    }
+    l->baud = baud;
+}
+
+static void ring_put(uart_link_t* l, uint8_t c) {
+    uint16_t head = l->rx_head;
+    if ((uint16_t)(head - l->rx_tail) >= UART_LINK_RING_SIZE) {
+        l->ring_overflows++;
+        return;
+    }
+    l->rx_ring[head & (UART_LINK_RING_SIZE - 1)] = c;
+    l->rx_head = head + 1;
+}
+
+static void drain_uart(uart_link_t* l) {
+    uart_hw_t* hw = uart_get_hw(l->uart);
+
+    // Overrun is only reported in RSR (sticky): count and clear it
+    if (hw->rsr & UART_UARTRSR_OE_BITS) {
+        l->overrun_errors++;
+        hw->rsr = UART_UARTRSR_OE_BITS;
+    }
+    while (uart_is_readable(l->uart)) {
+        // DR carries the error flags of this very character in bits 8..11
+        uint32_t dr = hw->dr;
+        l->rx_bytes++;
+        if (dr & (UART_UARTDR_FE_BITS | UART_UARTDR_BE_BITS | UART_UARTDR_PE_BITS)) {
+            if (dr & UART_UARTDR_FE_BITS) l->framing_errors++;
+            if (dr & UART_UARTDR_BE_BITS) l->break_errors++;
+            if (dr & UART_UARTDR_PE_BITS) l->parity_errors++;
+            l->window_errors++;
+            continue;
+        }
+        ring_put(l, (uint8_t)(dr & 0xFF));
+    }
+}
+
+static void drain_pio(uart_link_t* l) {
+    // The RX program flags a bad stop bit on IRQ sm (framing error or break)
+    if (pio_interrupt_get(l->pio, l->sm_rx)) {
+        pio_interrupt_clear(l->pio, l->sm_rx);
+        l->framing_errors++;
+        l->window_errors++;
+    }
+    while (!pio_sm_is_rx_fifo_empty(l->pio, l->sm_rx)) {
+        l->rx_bytes++;
+        ring_put(l, (uint8_t)(pio_sm_get(l->pio, l->sm_rx) >> 24));
+    }
+}
+
+// Shared by UART0/UART1 and PIO0/PIO1 IRQ 0: few links, so just drain them all
+static void link_rx_irq(void) {
+    for (uint8_t i = 0; i < num_links; i++) {
+        uart_link_t* l = link_registry[i];
+        if (l->uart) {
+            drain_uart(l);
+        } else {
+            drain_pio(l);
+        }
+    }
+}
+
+static void register_link(uart_link_t* l, uint irq_num) {
+    if (num_links < UART_LINK_MAX_LINKS) {
+        link_registry[num_links++] = l;
+    }
+    if (irq_get_exclusive_handler(irq_num) != link_rx_irq) {
+        irq_set_exclusive_handler(irq_num, link_rx_irq);
+    }
+    irq_set_enabled(irq_num, true);
+}
+
+// Returns to the base rate; the next offer starts from `offer` after `delay_ms`
+static void fall_back(uart_link_t* l, uint8_t offer, uint32_t delay_ms) {
+    if (l->baud != UART_LINK_BASE_BAUD) {
+        set_baud(l, UART_LINK_BASE_BAUD);
+        l->fallbacks++;
+    }
+    l->state = UART_LINK_IDLE;
+    l->offer = offer < NUM_OFFERS ? offer : 0;
+    l->deadline_ms = now_ms() + (offer < NUM_OFFERS ? delay_ms : UART_LINK_RETRY_MS);
+}
+
+void uart_link_init(uart_link_t* l, uart_inst_t* uart, uint32_t tx_pin, uint32_t rx_pin) {
+    memset(l, 0, sizeof(*l));
+    l->uart = uart;
+    l->baud = UART_LINK_BASE_BAUD;
+    uart_init(uart, UART_LINK_BASE_BAUD);
+    gpio_set_function(tx_pin, GPIO_FUNC_UART);
+    gpio_set_function(rx_pin, GPIO_FUNC_UART);
+
+    l->state = UART_LINK_IDLE;
+    l->deadline_ms = now_ms() + 1000; // Give the sketch time to boot
+    l->window_start_ms = now_ms();
+
+    register_link(l, uart == uart0 ? UART0_IRQ : UART1_IRQ);
+    uart_set_irq_enables(uart, true, false); // RX FIFO level and RX timeout
+}
+
+bool uart_link_init_pio(uart_link_t* l, PIO pio, uint32_t tx_pin, uint32_t rx_pin) {
+    memset(l, 0, sizeof(*l));
+    l->pio = pio;
+    l->sm_tx = -1;
+    l->baud = UART_LINK_BASE_BAUD;
+    uint idx = pio_get_index(pio);
+
+    if (rx_offset[idx] < 0) {
+        if (!pio_can_add_program(pio, &uart_link_rx_program)) return false;
+        rx_offset[idx] = pio_add_program(pio, &uart_link_rx_program);
+    }
+    int sm = pio_claim_unused_sm(pio, false);
+    if (sm < 0) return false;
+    l->sm_rx = (uint8_t)sm;
+
+    if (tx_pin != UART_LINK_NO_PIN) {
+        if (tx_offset[idx] < 0) {
+            if (!pio_can_add_program(pio, &uart_link_tx_program)) return false;
+            tx_offset[idx] = pio_add_program(pio, &uart_link_tx_program);
+        }
+        sm = pio_claim_unused_sm(pio, false);
+        if (sm < 0) return false;
+        l->sm_tx = (int8_t)sm;
+        uart_link_tx_program_init(pio, l->sm_tx, tx_offset[idx], tx_pin, UART_LINK_BASE_BAUD);
+    }
+    uart_link_rx_program_init(pio, l->sm_rx, rx_offset[idx], rx_pin, UART_LINK_BASE_BAUD);
+
+    l->state = UART_LINK_IDLE;
+    l->deadline_ms = now_ms() + 1000; // Give the sketch time to boot
+    l->window_start_ms = now_ms();
+
+    register_link(l, idx == 0 ? PIO0_IRQ_0 : PIO1_IRQ_0);
+    pio_interrupt_clear(pio, l->sm_rx);
+    pio_set_irq0_source_enabled(pio, (enum pio_interrupt_source)(pis_sm0_rx_fifo_not_empty + l->sm_rx), true);
+    pio_set_irq0_source_enabled(pio, (enum pio_interrupt_source)(pis_interrupt0 + l->sm_rx), true);
+    return true;
+}
+
+bool uart_link_getc(uart_link_t* l, char* c) {
+    uint16_t tail = l->rx_tail;
+    if (tail == l->rx_head) {
+        return false;
+    }
+    *c = (char)l->rx_ring[tail & (UART_LINK_RING_SIZE - 1)];
+    l->rx_tail = tail + 1;
+    return true;
+}
+
+bool uart_link_handle_line(uart_link_t* l, const char* line) {
+    if (strncmp(line, "BAUD_", 5) != 0) {
+        return false;
+    }
+
+    if (strncmp(line, "BAUD_ACK:", 9) == 0 && l->state == UART_LINK_WAIT_ACK &&
+        strtoul(line + 9, NULL, 10) == link_offers[l->offer]) {
+        set_baud(l, link_offers[l->offer]);
+        l->state = UART_LINK_WAIT_PONG;
+        l->deadline_ms = now_ms() + UART_LINK_PONG_TIMEOUT_MS;
+        l->next_tx_ms = now_ms() + UART_LINK_PING_PERIOD_MS; // Sketch switches meanwhile
+    } else if (strncmp(line, "BAUD_NAK:", 9) == 0 && l->state == UART_LINK_WAIT_ACK) {
+        fall_back(l, l->offer + 1, 0);
+    } else if (strcmp(line, "BAUD_PONG") == 0 && l->state == UART_LINK_WAIT_PONG) {
+        l->state = UART_LINK_ACTIVE;
+        l->next_tx_ms = now_ms() + UART_LINK_KEEPALIVE_MS;
+        l->window_errors = 0;
+        l->window_start_ms = now_ms();
+        printf("UART link at %lu baud.\n", (unsigned long)l->baud);
+    }
+    return true;
+}
+
+void uart_link_poll(uart_link_t* l) {
+    uint64_t now = now_ms();
+
+    // Receive-only PIO link: nothing to negotiate, stays at the base rate
+    if (!l->uart && l->sm_tx < 0) {
+        return;
+    }
+
+    switch (l->state) {
+        case UART_LINK_IDLE:
+            if (now >= l->deadline_ms) {
+                send_line(l, "BAUD_REQ", link_offers[l->offer]);
+                l->state = UART_LINK_WAIT_ACK;
+                l->deadline_ms = now + UART_LINK_ACK_TIMEOUT_MS;
+            }
+            break;
+        case UART_LINK_WAIT_ACK:
+            if (now >= l->deadline_ms) {
+                fall_back(l, NUM_OFFERS, 0); // No answer: sketch without negotiation
+            }
+            break;
+        case UART_LINK_WAIT_PONG:
+            if (now >= l->deadline_ms) {
+                fall_back(l, l->offer + 1, UART_LINK_RESYNC_MS);
+            } else if (now >= l->next_tx_ms) {
+                send_line(l, "BAUD_PING", 0);
+                l->next_tx_ms = now + UART_LINK_PING_PERIOD_MS;
+            }
+            break;
+        case UART_LINK_ACTIVE:
+            if (now >= l->next_tx_ms) {
+                send_line(l, "BAUD_KEEP", 0);
+                l->next_tx_ms = now + UART_LINK_KEEPALIVE_MS;
+            }
+            break;
+    }
+
+    // Too many framing/break errors in one window: the two ends disagree on the rate
+    if (now - l->window_start_ms >= UART_LINK_ERROR_WINDOW_MS) {
+        if (l->window_errors > UART_LINK_MAX_ERRORS && l->baud != UART_LINK_BASE_BAUD) {
+            printf("UART link: %lu errors at %lu baud, falling back.\n",
+                   (unsigned long)l->window_errors, (unsigned long)l->baud);
+            fall_back(l, l->offer + 1, UART_LINK_RESYNC_MS);
+        }
+        l->window_errors = 0;
+        l->window_start_ms = now;
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef __UART_LINK_H__
+#define __UART_LINK_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/uart.h"
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Serial link to an Arduino front-end with baud-rate negotiation.
+
+ Both ends start at UART_LINK_BASE_BAUD. The hub offers rates from the highest
+ down ("BAUD_REQ:<rate>"); the sketch answers "BAUD_ACK:<rate>" or
+ "BAUD_NAK:<rate>". After an ACK both switch, the hub sends "BAUD_PING" until
+ it gets "BAUD_PONG", otherwise both fall back to the base rate. While above
+ the base rate the hub sends "BAUD_KEEP" periodically; the sketch drops back
+ to the base rate when keepalives stop, and the hub does the same when the
+ framing/break error rate gets too high, then renegotiates.
+
+ A link runs either on a hardware UART or on a PIO soft UART (uart_link.pio,
+ one state machine per direction). PIO links without a TX pin are receive-only
+ and stay at the base rate. Received bytes are moved by the UART/PIO RX
+ interrupt into a per-link ring buffer, so a slow main loop iteration (SD
+ write, display update) does not overrun the 32-byte UART or 8-word PIO FIFO.
+*/
+
+#define UART_LINK_BASE_BAUD        9600
+#define UART_LINK_ACK_TIMEOUT_MS   300   // BAUD_REQ -> BAUD_ACK/NAK
+#define UART_LINK_PONG_TIMEOUT_MS  500   // Switch -> BAUD_PONG
+#define UART_LINK_PING_PERIOD_MS   50
+#define UART_LINK_RETRY_MS         30000 // Renegotiation attempt while at the base rate
+#define UART_LINK_KEEPALIVE_MS     2000  // Sketch falls back after 3 missed keepalives
+#define UART_LINK_RESYNC_MS        7000  // Wait after a fallback so the sketch reverts too
+#define UART_LINK_ERROR_WINDOW_MS  1000
+#define UART_LINK_MAX_ERRORS       8     // Framing/break errors per window before fallback
+#define UART_LINK_RING_SIZE        256   // RX ring buffer bytes per link (power of two)
+#define UART_LINK_MAX_LINKS        8     // Links served by the RX interrupt handlers
+#define UART_LINK_NO_PIN           0xFF  // tx_pin of a receive-only PIO link
+
+typedef enum {
+    UART_LINK_IDLE,      // At the base rate, next offer at deadline_ms
+    UART_LINK_WAIT_ACK,  // Offer sent
+    UART_LINK_WAIT_PONG, // Switched, pinging
+    UART_LINK_ACTIVE     // Negotiated rate confirmed
+} uart_link_state_t;
+
+typedef struct {
+    uart_inst_t* uart;          // Hardware UART, or NULL for a PIO link
+    PIO pio;                    // PIO link: block and state machines
+    uint8_t sm_rx;
+    int8_t sm_tx;               // -1 for a receive-only link
+    uint32_t baud;              // Rate currently programmed
+    uart_link_state_t state;
+    uint8_t offer;              // Index of the rate being offered
+    uint64_t deadline_ms;       // Timeout / next action of the current state
+    uint64_t next_tx_ms;        // Next BAUD_PING or BAUD_KEEP
+
+    // Link quality counters (since boot)
+    uint32_t rx_bytes;
+    uint32_t framing_errors;
+    uint32_t parity_errors;
+    uint32_t break_errors;
+    uint32_t overrun_errors;
+    uint32_t fallbacks;
+    uint32_t ring_overflows;    // Bytes dropped because the ring buffer was full
+
+    uint32_t window_errors;     // Framing/break errors in the current window
+    uint64_t window_start_ms;
+
+    // Filled by the RX interrupt, drained by uart_link_getc()
+    uint8_t rx_ring[UART_LINK_RING_SIZE];
+    volatile uint16_t rx_head;
+    volatile uint16_t rx_tail;
+} uart_link_t;
+
+/**
+ * @brief Initializes the UART at the base rate and schedules the first offer.
+ */
+void uart_link_init(uart_link_t* l, uart_inst_t* uart, uint32_t tx_pin, uint32_t rx_pin);
+
+/**
+ * @brief Initializes a PIO soft UART link at the base rate.
+ * @param tx_pin UART_LINK_NO_PIN for a receive-only link (no negotiation).
+ * @return false if the PIO has no free state machine or program space.
+ */
+bool uart_link_init_pio(uart_link_t* l, PIO pio, uint32_t tx_pin, uint32_t rx_pin);
+
+/**
+ * @brief Takes one received character from the link's ring buffer.
+ * @return false if nothing is buffered (corrupted characters never get there).
+ */
+bool uart_link_getc(uart_link_t* l, char* c);
+
+/**
+ * @brief Consumes negotiation replies ("BAUD_...") from the sketch.
+ * @return true if the line belonged to the link protocol.
+ */
+bool uart_link_handle_line(uart_link_t* l, const char* line);
+
+/**
+ * @brief Runs the negotiation timers and error-rate fallback; call every loop.
+ */
+void uart_link_poll(uart_link_t* l);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UART_LINK_H__
@@ -0,0 +1,243 @@
+#include "log_binary.h"
+
+#include <string.h>
+
+#include "crc.h" // update_crc16() from the SD driver
+
+static size_t put_varint(uint8_t* out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+// Returns bytes used, 0 if truncated, -1 if longer than 10 bytes
+static int get_varint(const uint8_t* in, size_t len, uint64_t* v) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < 10; i++) {
+        if (i >= len) return 0;
+        result |= (uint64_t)(in[i] & 0x7F) << (7 * i);
+        if (!(in[i] & 0x80)) {
+            *v = result;
+            return (int)i + 1;
+        }
+    }
+    return -1;
+}
+
+static unsigned short record_crc(uint16_t nonce, const uint8_t* record, size_t len) {
+    unsigned short crc = nonce;
+    update_crc16(&crc, (const char*)record, len);
+    return crc;
+}
+
+static size_t put_crc(uint16_t nonce, uint8_t* record, size_t len) {
+    unsigned short crc = record_crc(nonce, record, len);
+    record[len] = crc >> 8;
+    record[len + 1] = crc & 0xFF;
+    return len + 2;
+}
+
+size_t log_bin_write_header(uint8_t* out, uint16_t nonce) {
+    memcpy(out, LOG_BIN_MAGIC, 4);
+    out[4] = LOG_BIN_VERSION;
+    out[5] = 0;
+    out[6] = nonce >> 8;
+    out[7] = nonce & 0xFF;
+    return LOG_BIN_HEADER_SIZE;
+}
+
+bool log_bin_check_header(const uint8_t* in, size_t len, uint16_t* nonce) {
+    if (len < LOG_BIN_HEADER_SIZE || memcmp(in, LOG_BIN_MAGIC, 4) != 0 ||
+        in[4] < 2 || in[4] > LOG_BIN_VERSION) {
+        return false;
+    }
+    *nonce = (uint16_t)(in[6] << 8 | in[7]);
+    return true;
+}
+
+void log_bin_writer_init(log_bin_writer_t* w, uint16_t nonce) {
+    w->last_ms = 0;
+    w->synced = false;
+    w->seq = 0;
+    w->nonce = nonce;
+}
+
+size_t log_bin_encode(log_bin_writer_t* w, const log_record_t* rec, uint8_t* out) {
+    size_t n = 0;
+
+    if (!w->synced || rec->time_ms < w->last_ms ||
+        rec->time_ms - w->last_ms > LOG_BIN_SYNC_INTERVAL_MS) {
+        out[0] = LOG_BIN_SYNC;
+        out[1] = w->seq++;
+        n = put_crc(w->nonce, out, 2 + put_varint(&out[2], rec->time_ms));
+        w->last_ms = rec->time_ms;
+        w->synced = true;
+    }
+    if (rec->type == LOG_BIN_SYNC) {
+        return n;
+    }
+
+    uint8_t* r = &out[n];
+    uint8_t len = rec->len > LOG_BIN_MAX_DATA ? LOG_BIN_MAX_DATA : rec->len;
+    size_t i = 0;
+    uint8_t door = rec->door > LOG_BIN_MAX_DOOR ? LOG_BIN_MAX_DOOR : rec->door;
+    r[i++] = (uint8_t)(door << 4 | rec->type);
+    r[i++] = w->seq++;
+    i += put_varint(&r[i], rec->time_ms - w->last_ms);
+    r[i++] = rec->status;
+    r[i++] = len;
+    memcpy(&r[i], rec->data, len);
+    i += len;
+    w->last_ms = rec->time_ms;
+    return n + put_crc(w->nonce, r, i);
+}
+
+void log_bin_reader_init(log_bin_reader_t* r, uint16_t nonce) {
+    r->last_ms = 0;
+    r->synced = false;
+    r->nonce = nonce;
+}
+
+int log_bin_decode(log_bin_reader_t* r, const uint8_t* in, size_t len, log_record_t* rec) {
+    if (len < 1) return 0;
+    if (in[0] == LOG_BIN_PAD) {
+        rec->type = LOG_BIN_PAD;
+        return 1;
+    }
+    uint8_t type = in[0] & 0x0F;
+    uint8_t door = in[0] >> 4;
+    if (type > LOG_BIN_TELEMETRY || (type == LOG_BIN_SYNC && door != 0)) return -1;
+    if (len < 2) return 0;
+
+    uint64_t t;
+    int vn = get_varint(&in[2], len - 2, &t);
+    if (vn <= 0) return vn;
+    size_t i = 2 + vn;
+
+    rec->type = type;
+    rec->door = door;
+    rec->seq = in[1];
+    rec->status = LOG_STATUS_NONE;
+    rec->len = 0;
+    if (type != LOG_BIN_SYNC) {
+        if (len < i + 2) return 0;
+        rec->status = in[i++];
+        rec->len = in[i++];
+        if (rec->len > LOG_BIN_MAX_DATA) return -1;
+        if (len < i + rec->len) return 0;
+        memcpy(rec->data, &in[i], rec->len);
+        i += rec->len;
+    }
+    if (len < i + 2) return 0;
+
+    unsigned short crc = record_crc(r->nonce, in, i);
+    if (in[i] != (crc >> 8) || in[i + 1] != (crc & 0xFF)) return -1;
+
+    if (type == LOG_BIN_SYNC) {
+        r->last_ms = t;
+        r->synced = true;
+    } else {
+        r->last_ms += t;
+    }
+    rec->time_ms = r->last_ms;
+    return (int)(i + 2);
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint64_t v) {
+    return (int32_t)((uint32_t)(v >> 1) ^ (0u - (uint32_t)(v & 1)));
+}
+
+void log_bin_telemetry_pack(log_record_t* rec, int32_t min, int32_t max, int32_t mean, uint16_t count) {
+    size_t n = put_varint(rec->data, zigzag(min));
+    n += put_varint(&rec->data[n], zigzag(max));
+    n += put_varint(&rec->data[n], zigzag(mean));
+    n += put_varint(&rec->data[n], count);
+    rec->len = (uint8_t)n;
+}
+
+bool log_bin_telemetry_unpack(const log_record_t* rec, int32_t* min, int32_t* max, int32_t* mean,
+                              uint16_t* count) {
+    uint64_t v[4];
+    size_t n = 0;
+    for (int i = 0; i < 4; i++) {
+        int used = get_varint(&rec->data[n], rec->len - n, &v[i]);
+        if (used <= 0) return false;
+        n += used;
+    }
+    *min = unzigzag(v[0]);
+    *max = unzigzag(v[1]);
+    *mean = unzigzag(v[2]);
+    *count = (uint16_t)v[3];
+    return true;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+uint8_t log_bin_uid_from_hex(const char* hex, uint8_t* out, uint8_t max) {
+    uint8_t n = 0;
+    while (hex[0] && hex[1] && n < max) {
+        int hi = hex_value(hex[0]);
+        int lo = hex_value(hex[1]);
+        if (hi < 0 || lo < 0) return 0;
+        out[n++] = (uint8_t)(hi << 4 | lo);
+        hex += 2;
+    }
+    return hex[0] ? 0 : n; // Odd length or longer than max
+}
+
+void log_bin_uid_to_hex(const uint8_t* uid, uint8_t len, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    for (uint8_t i = 0; i < len; i++) {
+        *out++ = digits[uid[i] >> 4];
+        *out++ = digits[uid[i] & 0x0F];
+    }
+    *out = '\0';
+}
+
+uint8_t log_bin_pir_status(const char* message) {
+    if (strcmp(message, "MOTION_DETECTED_RFID_ACTIVATED") == 0) return LOG_PIR_ACTIVATED;
+    if (strcmp(message, "NO_MOTION_RFID_SLEEP") == 0) return LOG_PIR_SLEEP;
+    if (strcmp(message, "MOTION_DETECTED") == 0) return LOG_PIR_MOTION;
+    return LOG_PIR_OTHER;
+}
+
+const char* log_bin_type_str(uint8_t type) {
+    switch (type) {
+        case LOG_BIN_SYNC: return "SYNC";
+        case LOG_BIN_ACCESS: return "RFID_ACCESS";
+        case LOG_BIN_PIR: return "PIR_STATUS";
+        case LOG_BIN_TEXT: return "TEXT";
+        case LOG_BIN_TELEMETRY: return "TELEMETRY";
+        case LOG_BIN_PAD: return "PAD";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* log_bin_status_str(uint8_t status) {
+    switch (status) {
+        case LOG_STATUS_GRANTED: return "GRANTED";
+        case LOG_STATUS_DENIED: return "DENIED";
+        case LOG_PIR_MOTION: return "MOTION_DETECTED";
+        case LOG_PIR_ACTIVATED: return "MOTION_DETECTED_RFID_ACTIVATED";
+        case LOG_PIR_SLEEP: return "NO_MOTION_RFID_SLEEP";
+        case LOG_PIR_OTHER: return "OTHER";
+        case LOG_TELEM_TEMP_1M: return "TEMP_C_1M";
+        case LOG_TELEM_PRESS_1M: return "PRESS_HPA_1M";
+        case LOG_TELEM_TEMP_1H: return "TEMP_C_1H";
+        case LOG_TELEM_PRESS_1H: return "PRESS_HPA_1H";
+        default: return "";
+    }
+}
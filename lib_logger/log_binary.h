@@ -0,0 +1,164 @@
+#ifndef __LOG_BINARY_H__
+#define __LOG_BINARY_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Binary log layout (all multi-byte fields big-endian unless noted):
+
+ File header (8 bytes):  'B' 'D' 'L' 'G' | version | reserved (0) | nonce (2)
+
+ Record:
+   type     1 byte   low nibble: log_bin_type_t, high nibble: door id
+                     (0 for SYNC; 0xFF is the PAD byte, never a record)
+   seq      1 byte   sequence number, +1 per record (wraps), SYNC included
+   time     varint   LEB128; absolute epoch ms for LOG_BIN_SYNC,
+                     ms since the previous record for every other type
+   status   1 byte   (not present in LOG_BIN_SYNC)
+   len      1 byte   number of data bytes (not present in LOG_BIN_SYNC)
+   data     len      binary UID for LOG_BIN_ACCESS, packed rollup for
+                     LOG_BIN_TELEMETRY, text for unknown states
+   crc      2 bytes  CRC-16/XMODEM (sd_driver update_crc16) of all previous
+                     bytes, seeded with the file nonce
+
+ The nonce makes records left over from another file on reused clusters fail
+ their CRC, so recovery can stop at the first bad record or sequence gap.
+
+ Segments are split into LOG_BIN_BLOCK_SIZE blocks. A record never crosses a
+ block boundary (the rest of the block is filled with LOG_BIN_PAD bytes) and
+ the first record of every block is a SYNC, so the blocks' leading SYNC
+ records form a sparse time index that can be binary-searched.
+ A typical access record (4-byte UID, < 16 s since the previous event) is
+ 12 bytes instead of ~55 bytes of ASCII.
+*/
+
+#define LOG_BIN_MAGIC           "BDLG"
+#define LOG_BIN_VERSION         4 // v4: telemetry records; v2 files (no door ids) decode as door 0
+#define LOG_BIN_HEADER_SIZE     8
+#define LOG_BIN_MAX_DATA        48
+#define LOG_BIN_MAX_RECORD      (1 + 1 + 10 + 1 + 1 + LOG_BIN_MAX_DATA + 2)
+// An encode call may emit a SYNC record in front of the requested one
+#define LOG_BIN_MAX_ENCODED     (1 + 1 + 10 + 2 + LOG_BIN_MAX_RECORD)
+#define LOG_BIN_BLOCK_SIZE      4096
+#define LOG_BIN_MAX_DOOR        14   // Door 15 + type 15 would collide with LOG_BIN_PAD
+// Deltas longer than this are re-anchored with a SYNC record
+#define LOG_BIN_SYNC_INTERVAL_MS 60000
+
+typedef enum {
+    LOG_BIN_SYNC = 0x00,   // Absolute time anchor
+    LOG_BIN_ACCESS = 0x01, // RFID badge decision
+    LOG_BIN_PIR = 0x02,    // PIR / reader power state
+    LOG_BIN_TEXT = 0x03,   // Free-form event (status unused)
+    LOG_BIN_TELEMETRY = 0x04, // Sensor rollup (status: channel and interval)
+    LOG_BIN_PAD = 0xFF     // Single filler byte up to the next block boundary
+} log_bin_type_t;
+
+typedef enum {
+    LOG_STATUS_GRANTED = 0x00,
+    LOG_STATUS_DENIED = 0x01,
+    LOG_PIR_MOTION = 0x10,     // "MOTION_DETECTED"
+    LOG_PIR_ACTIVATED = 0x11,  // "MOTION_DETECTED_RFID_ACTIVATED"
+    LOG_PIR_SLEEP = 0x12,      // "NO_MOTION_RFID_SLEEP"
+    LOG_PIR_OTHER = 0x1F,      // Unknown state, text kept in data
+    LOG_TELEM_TEMP_1M = 0x20,  // TEMP_C, 1-minute rollup
+    LOG_TELEM_PRESS_1M = 0x21, // PRESS_HPA, 1-minute rollup
+    LOG_TELEM_TEMP_1H = 0x28,  // TEMP_C, 1-hour rollup
+    LOG_TELEM_PRESS_1H = 0x29, // PRESS_HPA, 1-hour rollup
+    LOG_STATUS_NONE = 0xFF
+} log_bin_status_t;
+
+// One decoded/encodable event
+typedef struct {
+    uint64_t time_ms;  // Epoch milliseconds
+    uint8_t type;      // log_bin_type_t
+    uint8_t door;      // Reader/door the event came from (0..LOG_BIN_MAX_DOOR)
+    uint8_t seq;       // Sequence number (set by the encoder)
+    uint8_t status;    // log_bin_status_t
+    uint8_t len;       // Bytes used in data
+    uint8_t data[LOG_BIN_MAX_DATA];
+} log_record_t;
+
+typedef struct {
+    uint64_t last_ms;  // Time of the previous record written
+    bool synced;       // A SYNC record has been emitted in this file/session
+    uint8_t seq;       // Sequence number of the next record
+    uint16_t nonce;    // CRC seed of the file being written
+} log_bin_writer_t;
+
+typedef struct {
+    uint64_t last_ms;  // Time of the previous record decoded
+    bool synced;       // Times are absolute (a SYNC record was seen)
+    uint16_t nonce;    // CRC seed from the file header
+} log_bin_reader_t;
+
+/**
+ * @brief Writes the 8-byte file header into out.
+ * @return LOG_BIN_HEADER_SIZE
+ */
+size_t log_bin_write_header(uint8_t* out, uint16_t nonce);
+
+/**
+ * @brief Checks magic and version of a file header and extracts its nonce.
+ */
+bool log_bin_check_header(const uint8_t* in, size_t len, uint16_t* nonce);
+
+void log_bin_writer_init(log_bin_writer_t* w, uint16_t nonce);
+
+/**
+ * @brief Encodes rec into out (at least LOG_BIN_MAX_ENCODED bytes).
+ * @note Prepends a SYNC record on the first call and after long idle periods.
+ * @return Number of bytes written.
+ */
+size_t log_bin_encode(log_bin_writer_t* w, const log_record_t* rec, uint8_t* out);
+
+void log_bin_reader_init(log_bin_reader_t* r, uint16_t nonce);
+
+/**
+ * @brief Decodes one record (SYNC records and single PAD bytes are returned too).
+ * @return Bytes consumed (> 0), 0 if more input is needed, -1 if the bytes at
+ *         in[0] are not a valid record (skip one byte and retry to resync).
+ */
+int log_bin_decode(log_bin_reader_t* r, const uint8_t* in, size_t len, log_record_t* rec);
+
+/**
+ * @brief Converts a hex UID string ("224c8d04") into bytes.
+ * @return Number of bytes written, 0 if the string is not valid hex.
+ */
+uint8_t log_bin_uid_from_hex(const char* hex, uint8_t* out, uint8_t max);
+
+/**
+ * @brief Writes the lowercase hex form of a UID (2*len+1 bytes) into out.
+ */
+void log_bin_uid_to_hex(const uint8_t* uid, uint8_t len, char* out);
+
+/**
+ * @brief Maps a PIR_STATUS message from the Arduino hub to log_bin_status_t.
+ */
+uint8_t log_bin_pir_status(const char* message);
+
+/**
+ * @brief Packs a rollup (hundredths of the unit) into rec->data/len as
+ *        zigzag varints: min, max, mean, then the sample count.
+ */
+void log_bin_telemetry_pack(log_record_t* rec, int32_t min, int32_t max, int32_t mean, uint16_t count);
+
+/**
+ * @brief Unpacks the data of a LOG_BIN_TELEMETRY record.
+ */
+bool log_bin_telemetry_unpack(const log_record_t* rec, int32_t* min, int32_t* max, int32_t* mean,
+                              uint16_t* count);
+
+const char* log_bin_type_str(uint8_t type);
+const char* log_bin_status_str(uint8_t status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LOG_BINARY_H__
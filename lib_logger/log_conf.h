@@ -0,0 +1,25 @@
+/**
+ * Private configuration file for the access logger (lib_logger).
+ * Selects which on-card formats log_event()/log_access_event() produce.
+ */
+
+#ifndef __LOG_CONF_H__
+#define __LOG_CONF_H__
+
+// Available formats (may be OR-ed together)
+#define LOG_FORMAT_TEXT         0x01 // log.txt  - one ASCII line per event (~45-60 bytes)
+#define LOG_FORMAT_BINARY       0x02 // logs/*.bin - compact records, see log_binary.h (~11 bytes)
+
+// Choose the format(s) written to the SD card
+#define LOG_FORMAT              LOG_FORMAT_BINARY
+
+// File names on the card
+#define LOG_TEXT_FILE           "log.txt"
+
+// Binary log rotation (see log_rotate.h)
+#define LOG_DIR                 "logs"
+#define LOG_INDEX_FILE          LOG_DIR "/index.bin"
+#define LOG_SEGMENT_MAX_BYTES   (256 * 1024) // A new segment starts past this size or at midnight (multiple of LOG_BIN_BLOCK_SIZE)
+#define LOG_BATCH_MAX_MS        1000         // Longest time a record may wait in RAM before its sector is written
+
+#endif /* __LOG_CONF_H__ */
@@ -0,0 +1,68 @@
+#include "log_fixed.h"
+
+#include <limits.h>
+
+static const int32_t pow10[LOG_FIXED_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000 };
+
+bool log_fixed_parse(const char* text, uint8_t decimals, int32_t* value) {
+    if (decimals > LOG_FIXED_MAX_DECIMALS) return false;
+
+    bool negative = false;
+    if (*text == '-' || *text == '+') {
+        negative = (*text == '-');
+        text++;
+    }
+
+    // Whole part; the range is checked on the scaled result below
+    int64_t whole = 0;
+    int digits = 0;
+    while (*text >= '0' && *text <= '9') {
+        whole = whole * 10 + (*text++ - '0');
+        if (whole > INT32_MAX) return false;
+        digits++;
+    }
+
+    // Fraction kept with one extra digit for rounding
+    int32_t frac = 0;
+    int32_t scale = pow10[decimals];
+    if (*text == '.') {
+        text++;
+        for (; *text >= '0' && *text <= '9'; text++, digits++) {
+            if (scale > 0) {
+                frac += (*text - '0') * scale;
+                scale /= 10;
+            }
+        }
+    }
+    if (digits == 0 || *text != '\0') return false;
+
+    // Every value log_fixed_format() writes reads back, INT32_MIN included
+    int64_t v = whole * pow10[decimals] + (frac + 5) / 10;
+    if (negative) v = -v;
+    if (v > INT32_MAX || v < INT32_MIN) return false;
+    *value = (int32_t)v;
+    return true;
+}
+
+size_t log_fixed_format(int32_t value, uint8_t decimals, char* out) {
+    if (decimals > LOG_FIXED_MAX_DECIMALS) decimals = LOG_FIXED_MAX_DECIMALS;
+
+    // Digits in reverse, at least one before the point
+    char digits[11];
+    uint32_t v = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0 || n <= decimals);
+
+    char* p = out;
+    if (value < 0) *p++ = '-';
+    while (n > decimals) *p++ = digits[--n];
+    if (decimals > 0) {
+        *p++ = '.';
+        while (n > 0) *p++ = digits[--n];
+    }
+    *p = '\0';
+    return (size_t)(p - out);
+}
@@ -0,0 +1,43 @@
+#ifndef __LOG_FIXED_H__
+#define __LOG_FIXED_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Fixed-point decimals for sensor values and log text.
+
+ A value with `decimals` places is an int32 scaled by 10^decimals
+ (decimals = 2: 2345 = 23.45). The RP2040 has no FPU, so parsing with atof or
+ printing with %f drags soft-float and a float-capable printf into the image
+ and costs several microseconds per value; these routines only use integer
+ arithmetic, which keeps FF_PRINT_FLOAT and PICO_PRINTF_SUPPORT_FLOAT off.
+*/
+
+#define LOG_FIXED_MAX_DECIMALS 4
+#define LOG_FIXED_MAX_LEN      13 // "-2147483.648" + terminator, any decimals
+
+/**
+ * @brief Parses a plain decimal ("-3.5", "1013.25", "+7") with `decimals`
+ *        places; the next digit rounds, further digits are ignored.
+ * @return false for anything else ("nan", "", "1e3", out of range).
+ */
+bool log_fixed_parse(const char* text, uint8_t decimals, int32_t* value);
+
+/**
+ * @brief Writes value as a decimal with `decimals` places ("-0.05") into out
+ *        (at least LOG_FIXED_MAX_LEN bytes).
+ * @return Length written, terminator excluded.
+ */
+size_t log_fixed_format(int32_t value, uint8_t decimals, char* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LOG_FIXED_H__
@@ -0,0 +1,214 @@
+#include "log_journal.h"
+
+#include <string.h>
+
+#include "diskio.h"
+
+#define SECTOR_SIZE FF_MAX_SS
+
+// First sector of cluster `clst` (same as clst2sect() in ff.c)
+static LBA_t cluster_lba(FATFS* fs, DWORD clst) {
+    return fs->database + (LBA_t)fs->csize * (clst - 2);
+}
+
+static FRESULT write_sectors(log_journal_t* j, uint32_t index, const uint8_t* buf, UINT count) {
+    return disk_write(j->fs->pdrv, buf, j->base_lba + index, count) == RES_OK ? FR_OK : FR_DISK_ERR;
+}
+
+static FRESULT read_sector(log_journal_t* j, uint32_t index, uint8_t* buf) {
+    return disk_read(j->fs->pdrv, buf, j->base_lba + index, 1) == RES_OK ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT log_journal_create(log_journal_t* j, const char* path, uint32_t capacity, uint16_t nonce) {
+    FIL fil;
+    FRESULT fr = f_open(&fil, path, FA_CREATE_NEW | FA_WRITE);
+    if (fr != FR_OK) return fr;
+
+    fr = f_expand(&fil, capacity, 1);
+    if (fr == FR_OK) {
+        j->fs = fil.obj.fs;
+        j->base_lba = cluster_lba(j->fs, fil.obj.sclust);
+    }
+    FRESULT fr2 = f_close(&fil); // Commits the size and chain of the extent once
+    if (fr != FR_OK || fr2 != FR_OK) {
+        f_unlink(path);
+        return fr != FR_OK ? fr : fr2;
+    }
+
+    j->capacity = capacity;
+    j->length = log_bin_write_header(j->tail[0], nonce);
+    memset(&j->tail[0][j->length], 0, SECTOR_SIZE - j->length);
+    j->dirty = false;
+    j->pending = false;
+    return write_sectors(j, 0, j->tail[0], 1);
+}
+
+FRESULT log_journal_recover(log_journal_t* j, const char* path, uint32_t capacity,
+                            log_journal_scan_t* scan) {
+    FIL fil;
+    FRESULT fr = f_open(&fil, path, FA_READ);
+    if (fr != FR_OK) return fr;
+    j->fs = fil.obj.fs;
+    j->capacity = (uint32_t)f_size(&fil);
+    j->base_lba = cluster_lba(j->fs, fil.obj.sclust);
+    bool empty = fil.obj.sclust == 0;
+    f_close(&fil);
+    if (empty) return FR_NO_FILE;
+    // A truncated segment was closed; it still starts on its extent, so it is
+    // scanned the same way in case the index missed the close
+    scan->closed = j->capacity != capacity;
+
+    // Two-sector window so records crossing a sector boundary decode in one piece
+    static uint8_t window[2 * SECTOR_SIZE];
+    uint32_t sectors = (j->capacity + SECTOR_SIZE - 1) / SECTOR_SIZE;
+    fr = read_sector(j, 0, window);
+    if (fr != FR_OK) return fr;
+    if (!log_bin_check_header(window, SECTOR_SIZE, &scan->nonce)) return FR_NO_FILE;
+    if (sectors > 1 && (fr = read_sector(j, 1, &window[SECTOR_SIZE])) != FR_OK) return fr;
+
+    log_bin_reader_t reader;
+    log_bin_reader_init(&reader, scan->nonce);
+    scan->records = 0;
+    scan->first_ms = scan->last_ms = 0;
+
+    uint32_t base = 0;                  // File offset of window[0]
+    uint32_t pos = LOG_BIN_HEADER_SIZE; // File offset of the next record
+    uint32_t valid_end = pos;           // End of the last valid non-PAD record
+    bool first = true;
+    uint8_t seq = 0;
+    while (pos < j->capacity) {
+        if (pos - base >= SECTOR_SIZE) {
+            // Move the window so it starts at the sector holding pos
+            uint32_t sector = pos / SECTOR_SIZE;
+            if (sector == base / SECTOR_SIZE + 1) {
+                memcpy(window, &window[SECTOR_SIZE], SECTOR_SIZE);
+            } else if ((fr = read_sector(j, sector, window)) != FR_OK) {
+                return fr;
+            }
+            base = sector * SECTOR_SIZE;
+            if (sector + 1 < sectors && (fr = read_sector(j, sector + 1, &window[SECTOR_SIZE])) != FR_OK) {
+                return fr;
+            }
+        }
+        uint32_t end = base + 2 * SECTOR_SIZE < j->capacity ? base + 2 * SECTOR_SIZE : j->capacity;
+        uint32_t avail = end - pos;
+        log_record_t rec;
+        int n = log_bin_decode(&reader, &window[pos - base], avail, &rec);
+        if (n > 0 && rec.type == LOG_BIN_PAD) {
+            // Padding runs to the next block boundary; erased 0xFF sectors are
+            // not counted unless a valid record follows them
+            pos = (pos / LOG_BIN_BLOCK_SIZE + 1) * LOG_BIN_BLOCK_SIZE;
+            continue;
+        }
+        if (n <= 0 || (!first && rec.seq != seq)) break;
+        first = false;
+        seq = rec.seq + 1;
+        pos += n;
+        valid_end = pos;
+        if (rec.type == LOG_BIN_SYNC) continue;
+        if (scan->records++ == 0) scan->first_ms = rec.time_ms;
+        scan->last_ms = rec.time_ms;
+    }
+    scan->next_seq = seq;
+
+    // Reload the tail sector and clear whatever followed the last valid record
+    pos = valid_end;
+    j->length = pos;
+    fr = read_sector(j, pos / SECTOR_SIZE, j->tail[0]);
+    if (fr != FR_OK) return fr;
+    memset(&j->tail[0][pos % SECTOR_SIZE], 0, SECTOR_SIZE - pos % SECTOR_SIZE);
+    j->dirty = false;
+    j->pending = false;
+    return FR_OK;
+}
+
+// The sector before `length` has just been filled: hand it off, or write it
+// together with the one handed off before it
+static FRESULT sector_done(log_journal_t* j) {
+    if (!j->pending) {
+        j->pending = true; // Records go on into tail[1]
+        memset(j->tail[1], 0, SECTOR_SIZE);
+        return FR_OK;
+    }
+    FRESULT fr = write_sectors(j, j->length / SECTOR_SIZE - 2, j->tail[0], 2);
+    if (fr != FR_OK) return fr;
+    memset(j->tail[0], 0, SECTOR_SIZE);
+    j->pending = false;
+    j->dirty = false;
+    return FR_OK;
+}
+
+FRESULT log_journal_append(log_journal_t* j, const uint8_t* data, uint32_t len, uint64_t now_ms) {
+    if (j->length + len > j->capacity) return FR_DENIED;
+    if (!j->dirty) j->dirty_ms = now_ms;
+
+    while (len > 0) {
+        uint32_t off = j->length % SECTOR_SIZE;
+        uint32_t chunk = SECTOR_SIZE - off < len ? SECTOR_SIZE - off : len;
+        memcpy(&j->tail[j->pending][off], data, chunk);
+        j->length += chunk;
+        data += chunk;
+        len -= chunk;
+        j->dirty = true;
+
+        if (j->length % SECTOR_SIZE == 0) {
+            // Sector complete: hand it off and start the next one empty
+            FRESULT fr = sector_done(j);
+            if (fr != FR_OK) return fr;
+        }
+    }
+    return FR_OK;
+}
+
+FRESULT log_journal_pad(log_journal_t* j, uint32_t block, uint64_t now_ms) {
+    uint32_t target = (j->length / block + 1) * block;
+    if (j->length % block == 0) return FR_OK;
+    if (target > j->capacity) return FR_DENIED;
+    if (!j->dirty) j->dirty_ms = now_ms;
+
+    while (j->length < target) {
+        uint32_t off = j->length % SECTOR_SIZE;
+        uint32_t chunk = SECTOR_SIZE - off < target - j->length ? SECTOR_SIZE - off : target - j->length;
+        memset(&j->tail[j->pending][off], LOG_BIN_PAD, chunk);
+        j->length += chunk;
+        j->dirty = true;
+        if (j->length % SECTOR_SIZE == 0) {
+            FRESULT fr = sector_done(j);
+            if (fr != FR_OK) return fr;
+        }
+    }
+    return FR_OK;
+}
+
+FRESULT log_journal_flush(log_journal_t* j) {
+    if (!j->dirty) return FR_OK;
+    uint32_t index = j->length / SECTOR_SIZE;
+    FRESULT fr;
+    if (!j->pending) {
+        fr = write_sectors(j, index, j->tail[0], 1);
+    } else if (j->length % SECTOR_SIZE == 0) {
+        fr = write_sectors(j, index - 1, j->tail[0], 1); // tail[1] is still empty
+    } else {
+        fr = write_sectors(j, index - 1, j->tail[0], 2);
+    }
+    if (fr != FR_OK) return fr;
+    if (j->pending) {
+        memcpy(j->tail[0], j->tail[1], SECTOR_SIZE);
+        j->pending = false;
+    }
+    j->dirty = false;
+    return FR_OK;
+}
+
+FRESULT log_journal_close(log_journal_t* j, const char* path) {
+    FRESULT fr = log_journal_flush(j);
+    if (fr != FR_OK) return fr;
+
+    FIL fil;
+    fr = f_open(&fil, path, FA_WRITE);
+    if (fr != FR_OK) return fr;
+    fr = f_lseek(&fil, j->length);
+    if (fr == FR_OK) fr = f_truncate(&fil);
+    FRESULT fr2 = f_close(&fil);
+    return fr != FR_OK ? fr : fr2;
+}
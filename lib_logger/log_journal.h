@@ -0,0 +1,95 @@
+#ifndef __LOG_JOURNAL_H__
+#define __LOG_JOURNAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ff.h"
+#include "log_binary.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Crash-consistent append area for one binary log segment.
+
+ The segment file is preallocated as one contiguous extent (f_expand) when it
+ is created, so its FAT chain and directory entry never change while records
+ are appended: records are batched in a RAM copy of the tail sector and written
+ with disk_write() straight to the extent. A power cut can therefore only lose
+ the unflushed tail, never corrupt FAT or directory sectors.
+
+ The tail is double-buffered: a completed sector is handed off in tail[0] while
+ records go on filling tail[1], and the two are written together as one
+ 2-sector disk_write() (a single CMD25) when the second completes or at the
+ next flush. The unflushed tail is thus at most two sectors, still bounded in
+ time by the caller's flush interval (dirty_ms).
+
+ On mount, log_journal_recover() scans the extent for the last record whose
+ CRC (seeded with the segment nonce) and sequence number are valid; appending
+ resumes there. log_journal_close() truncates the file to the valid length.
+*/
+
+typedef struct {
+    FATFS* fs;               // Volume holding the segment
+    LBA_t base_lba;          // First sector of the contiguous extent
+    uint32_t capacity;       // Preallocated bytes
+    uint32_t length;         // Valid bytes (header + records)
+    bool dirty;              // Tail sector(s) have unflushed records
+    bool pending;            // tail[0] is a completed sector not yet written
+    uint64_t dirty_ms;       // Time of the oldest unflushed record
+    uint8_t tail[2][FF_MAX_SS]; // tail[pending]: RAM copy of the sector containing `length`
+} log_journal_t;
+
+// Summary of the records found by log_journal_recover()
+typedef struct {
+    uint16_t nonce;          // CRC seed from the segment header
+    uint8_t next_seq;        // Sequence number to continue with
+    uint32_t records;        // Valid records, SYNC excluded
+    uint64_t first_ms;       // Time of the first valid record
+    uint64_t last_ms;        // Time of the last valid record
+    bool closed;             // Segment was already truncated by log_journal_close()
+} log_journal_scan_t;
+
+/**
+ * @brief Creates path, preallocates `capacity` bytes and writes the header.
+ * @return FR_EXIST if the file already exists, FR_DENIED if no contiguous area.
+ */
+FRESULT log_journal_create(log_journal_t* j, const char* path, uint32_t capacity, uint16_t nonce);
+
+/**
+ * @brief Reopens a segment left open by a reset and finds its valid length.
+ * A segment shorter than `capacity` was already closed (truncated): it is
+ * scanned too and flagged in scan->closed.
+ * @return FR_NO_FILE if the segment is empty or has no valid header.
+ */
+FRESULT log_journal_recover(log_journal_t* j, const char* path, uint32_t capacity,
+                            log_journal_scan_t* scan);
+
+/**
+ * @brief Copies an encoded record into the tail; full sectors are written in pairs.
+ * @return FR_DENIED if the record does not fit in the preallocated extent.
+ */
+FRESULT log_journal_append(log_journal_t* j, const uint8_t* data, uint32_t len, uint64_t now_ms);
+
+/**
+ * @brief Fills LOG_BIN_PAD bytes up to the next multiple of `block`.
+ */
+FRESULT log_journal_pad(log_journal_t* j, uint32_t block, uint64_t now_ms);
+
+/**
+ * @brief Writes the handed-off and the partially filled tail sectors, if dirty.
+ */
+FRESULT log_journal_flush(log_journal_t* j);
+
+/**
+ * @brief Flushes and truncates path to the valid length.
+ */
+FRESULT log_journal_close(log_journal_t* j, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LOG_JOURNAL_H__
@@ -0,0 +1,183 @@
+#include "log_query.h"
+
+#include <string.h>
+
+#include "log_conf.h"
+
+// One open segment being searched
+typedef struct {
+    FIL fil;
+    DWORD clmt[LOG_QUERY_CLMT_SIZE];     // Fast-seek cluster link map
+    uint32_t size;                       // Valid bytes in the segment
+    uint16_t nonce;                      // CRC seed from the header
+    uint8_t buf[2 * FF_MAX_SS];          // Read window
+    uint32_t base;                       // File offset of buf[0]
+    uint32_t have;                       // Valid bytes in buf
+    log_query_stats_t* stats;
+} segment_t;
+
+static segment_t seg; // Too large for the stack; queries do not nest
+
+// Makes buf cover at least one full record starting at pos (or up to size)
+static FRESULT fill(segment_t* s, uint32_t pos) {
+    if (pos >= s->base && pos + LOG_BIN_MAX_RECORD <= s->base + s->have) return FR_OK;
+
+    if (pos >= s->base && pos <= s->base + s->have) {
+        // Keep the unread tail; the file pointer already sits at base + have
+        uint32_t keep = s->base + s->have - pos;
+        memmove(s->buf, &s->buf[pos - s->base], keep);
+        s->have = keep;
+    } else {
+        FRESULT fr = f_lseek(&s->fil, pos);
+        if (fr != FR_OK) return fr;
+        s->have = 0;
+    }
+    s->base = pos;
+
+    uint32_t want = sizeof(s->buf) - s->have;
+    uint32_t left = s->size - (s->base + s->have);
+    if (want > left) want = left;
+    UINT br = 0;
+    FRESULT fr = want ? f_read(&s->fil, &s->buf[s->have], want, &br) : FR_OK;
+    s->have += br;
+    s->stats->bytes_read += br;
+    return fr;
+}
+
+// Decodes the record at pos; returns its length, 0 at end of data, -1 if invalid
+static int decode_at(segment_t* s, log_bin_reader_t* reader, uint32_t pos, log_record_t* rec) {
+    if (pos >= s->size || fill(s, pos) != FR_OK) return 0;
+    int n = log_bin_decode(reader, &s->buf[pos - s->base], s->base + s->have - pos, rec);
+    if (n > 0) s->stats->records++;
+    return n;
+}
+
+static uint32_t block_start(uint32_t block) {
+    return block == 0 ? LOG_BIN_HEADER_SIZE : block * LOG_BIN_BLOCK_SIZE;
+}
+
+// Time of the SYNC record leading `block`; false if the block has none
+static bool probe_block(segment_t* s, uint32_t block, uint64_t* time_ms) {
+    log_bin_reader_t reader;
+    log_record_t rec;
+    log_bin_reader_init(&reader, s->nonce);
+    s->stats->seeks++;
+    if (decode_at(s, &reader, block_start(block), &rec) <= 0 || rec.type != LOG_BIN_SYNC) {
+        return false;
+    }
+    *time_ms = rec.time_ms;
+    return true;
+}
+
+static bool matches(const log_query_t* q, const log_record_t* rec) {
+    if (rec->type == LOG_BIN_SYNC || rec->type == LOG_BIN_PAD) return false;
+    if (rec->time_ms < q->from_ms || rec->time_ms > q->to_ms) return false;
+    if (q->access_only && rec->type != LOG_BIN_ACCESS) return false;
+    if (q->doors && !(q->doors & (1u << rec->door))) return false;
+    if (q->uid_len == 0) return true;
+    return rec->type == LOG_BIN_ACCESS && rec->len == q->uid_len &&
+           memcmp(rec->data, q->uid, q->uid_len) == 0;
+}
+
+// Searches one segment; sets *stop when the callback ends the query
+static FRESULT search_segment(const log_query_t* q, const char* name, uint32_t valid,
+                              log_query_cb_t cb, void* ctx, bool* stop) {
+    char path[32];
+    log_segment_path(name, path);
+    FRESULT fr = f_open(&seg.fil, path, FA_READ);
+    if (fr != FR_OK) return fr;
+    seg.stats->segments++;
+
+    // Cluster link map: later seeks are resolved without walking the FAT
+    seg.clmt[0] = LOG_QUERY_CLMT_SIZE;
+    seg.fil.cltbl = seg.clmt;
+    if (f_lseek(&seg.fil, CREATE_LINKMAP) != FR_OK) {
+        seg.fil.cltbl = NULL; // Too fragmented for the map: plain seeks still work
+    }
+
+    seg.size = valid ? valid : (uint32_t)f_size(&seg.fil);
+    seg.base = 0;
+    seg.have = 0;
+    fr = fill(&seg, 0);
+    if (fr != FR_OK || !log_bin_check_header(seg.buf, seg.have, &seg.nonce)) {
+        f_close(&seg.fil);
+        return fr;
+    }
+
+    // Binary search for the last block whose leading SYNC is older than from_ms
+    uint32_t lo = 0;
+    uint32_t hi = (seg.size + LOG_BIN_BLOCK_SIZE - 1) / LOG_BIN_BLOCK_SIZE - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        uint64_t t;
+        if (probe_block(&seg, mid, &t) && t < q->from_ms) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    log_bin_reader_t reader;
+    log_bin_reader_init(&reader, seg.nonce);
+    uint32_t pos = block_start(lo);
+    bool past_range = false;
+    while (!*stop && !past_range) {
+        log_record_t rec;
+        int n = decode_at(&seg, &reader, pos, &rec);
+        if (n == 0) break;
+        if (n < 0 || rec.type == LOG_BIN_PAD) {
+            // Padding or damage: every block restarts with a SYNC record
+            pos = (pos / LOG_BIN_BLOCK_SIZE + 1) * LOG_BIN_BLOCK_SIZE;
+            continue;
+        }
+        pos += n;
+        if (rec.type != LOG_BIN_SYNC && rec.time_ms > q->to_ms) {
+            past_range = true;
+        } else if (matches(q, &rec)) {
+            seg.stats->matches++;
+            if (!cb(&rec, ctx)) *stop = true;
+        }
+    }
+    return f_close(&seg.fil);
+}
+
+FRESULT log_query_run(const log_query_t* q, log_rotator_t* live,
+                      log_query_cb_t cb, void* ctx, log_query_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+    seg.stats = stats;
+
+    // Make the batched tail of the open segment visible to f_read
+    if (live && live->open) {
+        FRESULT fr = log_journal_flush(&live->journal);
+        if (fr != FR_OK) return fr;
+    }
+
+    // One sequential pass over the index: a log_index_read() per slot would
+    // reopen the file and walk its cluster chain every time
+    static FIL index; // Too large for the stack, like seg
+    FRESULT fr = f_open(&index, LOG_INDEX_FILE, FA_READ);
+    if (fr == FR_NO_FILE || fr == FR_NO_PATH) return FR_OK;
+    if (fr != FR_OK) return fr;
+    bool stop = false;
+    for (uint32_t slot = 0; !stop; slot++) {
+        log_index_entry_t e;
+        UINT br;
+        fr = f_read(&index, &e, sizeof(e), &br);
+        if (fr != FR_OK || br != sizeof(e)) break;
+        uint32_t valid = 0;
+        if (live && live->open && slot == live->slot) {
+            e = live->entry;
+            valid = live->journal.length;
+        }
+        if (e.last_ms < q->from_ms) continue;
+        // Not a break: after the clock is set back, later segments can start
+        // earlier than this one
+        if (e.first_ms > q->to_ms) continue;
+
+        fr = search_segment(q, e.name, valid, cb, ctx, &stop);
+        if (fr != FR_OK && fr != FR_NO_FILE) break;
+        fr = FR_OK;
+    }
+    f_close(&index);
+    return fr;
+}
@@ -0,0 +1,61 @@
+#ifndef __LOG_QUERY_H__
+#define __LOG_QUERY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ff.h"
+#include "log_binary.h"
+#include "log_rotate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Time-range / UID search over the rotated binary log.
+
+ 1. The segment index (LOG_INDEX_FILE) rules out segments whose
+    [first_ms, last_ms] does not overlap the range.
+ 2. Inside a segment, the SYNC record leading every LOG_BIN_BLOCK_SIZE block is
+    the sparse time index: a binary search over blocks (one small read each)
+    finds the block where the range starts.
+ 3. Records are streamed from there until one is newer than to_ms. Seeks go
+    through a FatFs fast-seek cluster link map (CLMT), so they cost no FAT
+    reads.
+*/
+
+#define LOG_QUERY_CLMT_SIZE 32 // DWORDs of cluster link map per open segment
+
+typedef struct {
+    uint64_t from_ms;              // First epoch ms included
+    uint64_t to_ms;                // Last epoch ms included
+    bool access_only;              // Only RFID access records
+    uint16_t doors;                // Bit mask of door ids, 0 matches any door
+    uint8_t uid_len;               // 0 matches any UID
+    uint8_t uid[10];               // Access records with this UID only
+} log_query_t;
+
+typedef struct {
+    uint32_t segments;             // Segments opened
+    uint32_t seeks;                // Block probes made by the binary search
+    uint32_t records;              // Records decoded
+    uint32_t matches;              // Records passed to the callback
+    uint32_t bytes_read;           // Bytes read through f_read
+} log_query_stats_t;
+
+// Return false to stop the query early
+typedef bool (*log_query_cb_t)(const log_record_t* rec, void* ctx);
+
+/**
+ * @brief Runs q over all segments, calling cb for every match in time order.
+ * @param live Rotator of the open segment (flushed first), or NULL.
+ */
+FRESULT log_query_run(const log_query_t* q, log_rotator_t* live,
+                      log_query_cb_t cb, void* ctx, log_query_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LOG_QUERY_H__
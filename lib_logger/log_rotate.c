@@ -0,0 +1,182 @@
+#include "log_rotate.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "log_conf.h"
+#include "log_time.h"
+
+_Static_assert(sizeof(log_index_entry_t) == 40, "index slot layout changed");
+
+void log_segment_path(const char* name, char* path) {
+    snprintf(path, 32, LOG_DIR "/%s.bin", name);
+}
+
+uint32_t log_index_count(void) {
+    FILINFO fno;
+    if (f_stat(LOG_INDEX_FILE, &fno) != FR_OK) return 0;
+    return (uint32_t)(fno.fsize / sizeof(log_index_entry_t));
+}
+
+FRESULT log_index_read(uint32_t slot, log_index_entry_t* e) {
+    FIL idx;
+    UINT br;
+    FRESULT fr = f_open(&idx, LOG_INDEX_FILE, FA_READ);
+    if (fr != FR_OK) return fr;
+    fr = f_lseek(&idx, (FSIZE_t)slot * sizeof(*e));
+    if (fr == FR_OK) fr = f_read(&idx, e, sizeof(*e), &br);
+    if (fr == FR_OK && br != sizeof(*e)) fr = FR_INT_ERR;
+    f_close(&idx);
+    return fr;
+}
+
+static FRESULT index_write(uint32_t slot, const log_index_entry_t* e) {
+    FIL idx;
+    UINT bw;
+    FRESULT fr = f_open(&idx, LOG_INDEX_FILE, FA_OPEN_ALWAYS | FA_WRITE);
+    if (fr != FR_OK) return fr;
+    fr = f_lseek(&idx, (FSIZE_t)slot * sizeof(*e));
+    if (fr == FR_OK) fr = f_write(&idx, e, sizeof(*e), &bw);
+    FRESULT fr2 = f_close(&idx);
+    return fr != FR_OK ? fr : fr2;
+}
+
+static uint32_t parse_seq(const char* name) {
+    // "YYYYMMDD-NNN" -> NNN
+    uint32_t n = 0;
+    for (int i = 9; i < 12 && name[i] >= '0' && name[i] <= '9'; i++) {
+        n = n * 10 + (name[i] - '0');
+    }
+    return n;
+}
+
+// Opens a fresh segment for the day containing epoch_ms
+static FRESULT open_segment(log_rotator_t* r, uint64_t epoch_ms) {
+    uint32_t day = (uint32_t)(epoch_ms / 86400000u);
+    uint16_t year;
+    uint8_t month, mday, hour, min, sec;
+    log_time_civil(day * 86400u, &year, &month, &mday, &hour, &min, &sec);
+
+    // Continue the numbering of the previous segment when it is from the same day
+    uint32_t seq = 1;
+    uint32_t slot = log_index_count();
+    log_index_entry_t prev;
+    if (slot > 0 && log_index_read(slot - 1, &prev) == FR_OK &&
+        (uint32_t)(prev.first_ms / 86400000u) == day) {
+        seq = parse_seq(prev.name) + 1;
+    }
+
+    // Per-segment CRC seed, so stale records on reused clusters never validate
+    uint16_t nonce = (uint16_t)(epoch_ms ^ (epoch_ms >> 16) ^ (slot * 0x9E37u));
+
+    FRESULT fr = FR_EXIST;
+    char path[32];
+    for (; seq <= 999 && fr == FR_EXIST; seq++) {
+        snprintf(r->entry.name, sizeof(r->entry.name), "%04u%02u%02u-%03lu",
+                 year, month, mday, (unsigned long)seq);
+        log_segment_path(r->entry.name, path);
+        fr = log_journal_create(&r->journal, path, LOG_SEGMENT_MAX_BYTES, nonce);
+    }
+    if (fr != FR_OK) return fr;
+
+    r->open = true;
+    r->slot = slot;
+    r->day = day;
+    r->entry.first_ms = epoch_ms;
+    r->entry.last_ms = epoch_ms;
+    r->entry.records = 0;
+    r->entry.bytes = r->journal.length;
+    log_bin_writer_init(&r->writer, nonce);
+    return index_write(r->slot, &r->entry);
+}
+
+FRESULT log_rotate_init(log_rotator_t* r) {
+    memset(r, 0, sizeof(*r));
+    FRESULT fr = f_mkdir(LOG_DIR);
+    if (fr != FR_OK && fr != FR_EXIST) return fr;
+
+    uint32_t count = log_index_count();
+    if (count == 0) return FR_OK; // First segment is created by the first record
+
+    // Recover the newest segment: find its last valid record and resume there
+    fr = log_index_read(count - 1, &r->entry);
+    if (fr != FR_OK) return fr;
+    char path[32];
+    log_segment_path(r->entry.name, path);
+    log_journal_scan_t scan;
+    fr = log_journal_recover(&r->journal, path, LOG_SEGMENT_MAX_BYTES, &scan);
+    if (fr == FR_NO_FILE) return FR_OK; // Missing: next record opens a new one
+    if (fr != FR_OK) return fr;
+    if (scan.closed) {
+        // Closed: the next record opens a new segment. A reset between the
+        // truncate and the index update leaves the slot at its opening values
+        if (r->entry.bytes == r->journal.length) return FR_OK;
+        r->entry.records = scan.records;
+        r->entry.bytes = r->journal.length;
+        if (scan.records > 0) r->entry.last_ms = scan.last_ms;
+        return index_write(count - 1, &r->entry);
+    }
+
+    r->open = true;
+    r->slot = count - 1;
+    r->day = (uint32_t)(r->entry.first_ms / 86400000u);
+    if (scan.records > 0) {
+        r->entry.last_ms = scan.last_ms;
+    }
+    r->entry.records = scan.records;
+    r->entry.bytes = r->journal.length;
+    log_bin_writer_init(&r->writer, scan.nonce);
+    r->writer.seq = scan.next_seq;
+    return FR_OK;
+}
+
+FRESULT log_rotate_append(log_rotator_t* r, const log_record_t* rec) {
+    FRESULT fr;
+    uint32_t day = (uint32_t)(rec->time_ms / 86400000u);
+    // A clock set back rotates too: log_query binary-searches segments by time
+    if (!r->open || day != r->day || rec->time_ms < r->entry.last_ms ||
+        r->journal.length + LOG_BIN_MAX_ENCODED > r->journal.capacity) {
+        if (r->open) {
+            fr = log_rotate_close(r);
+            if (fr != FR_OK) return fr;
+        }
+        fr = open_segment(r, rec->time_ms);
+        if (fr != FR_OK) return fr;
+    }
+
+    uint8_t out[LOG_BIN_MAX_ENCODED];
+    log_bin_writer_t saved = r->writer;
+    size_t len = log_bin_encode(&r->writer, rec, out);
+    if (r->journal.length % LOG_BIN_BLOCK_SIZE + len > LOG_BIN_BLOCK_SIZE) {
+        // Would cross a block boundary: pad, and start the next block with a SYNC
+        fr = log_journal_pad(&r->journal, LOG_BIN_BLOCK_SIZE, rec->time_ms);
+        if (fr != FR_OK) return fr;
+        r->writer = saved;
+        r->writer.synced = false;
+        len = log_bin_encode(&r->writer, rec, out);
+    }
+    fr = log_journal_append(&r->journal, out, len, rec->time_ms);
+    if (fr != FR_OK) return fr;
+
+    r->entry.bytes = r->journal.length;
+    r->entry.last_ms = rec->time_ms;
+    if (rec->type != LOG_BIN_SYNC) r->entry.records++;
+    return FR_OK;
+}
+
+FRESULT log_rotate_poll(log_rotator_t* r, uint64_t now_ms) {
+    if (!r->open || !r->journal.dirty || now_ms - r->journal.dirty_ms < LOG_BATCH_MAX_MS) {
+        return FR_OK;
+    }
+    return log_journal_flush(&r->journal);
+}
+
+FRESULT log_rotate_close(log_rotator_t* r) {
+    if (!r->open) return FR_OK;
+    r->open = false;
+    char path[32];
+    log_segment_path(r->entry.name, path);
+    FRESULT fr = log_journal_close(&r->journal, path);
+    FRESULT fr2 = index_write(r->slot, &r->entry);
+    return fr != FR_OK ? fr : fr2;
+}
@@ -0,0 +1,88 @@
+#ifndef __LOG_ROTATE_H__
+#define __LOG_ROTATE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ff.h"
+#include "log_binary.h"
+#include "log_journal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ The binary log is split into segments LOG_DIR/YYYYMMDD-NNN.bin. A segment is
+ closed when it would exceed LOG_SEGMENT_MAX_BYTES, when the UTC date of a
+ record differs from the segment's date, or when a record is older than the
+ last one (the clock was set back), so every segment is in time order. Every
+ segment has one fixed-size slot in LOG_INDEX_FILE so a reader can pick the
+ segments covering a time range without opening them. Records are appended
+ through log_journal.h, so the slot of the open segment is only rewritten when
+ it is created or closed.
+*/
+
+#define LOG_SEGMENT_NAME_LEN 16 // "YYYYMMDD-NNN" plus terminator, padded
+
+// One slot of LOG_INDEX_FILE (little-endian, 40 bytes, no padding)
+typedef struct {
+    char name[LOG_SEGMENT_NAME_LEN]; // Segment base name, without dir/extension
+    uint64_t first_ms;               // Epoch ms of the first record
+    uint64_t last_ms;                // Epoch ms of the last record
+    uint32_t records;                // Records, SYNC excluded (0 while the segment is open)
+    uint32_t bytes;                  // Valid bytes (header only while the segment is open)
+} log_index_entry_t;
+
+typedef struct {
+    log_journal_t journal;     // Preallocated extent of the open segment
+    bool open;
+    uint32_t slot;             // Index slot of the open segment
+    uint32_t day;              // Epoch day of the open segment
+    log_index_entry_t entry;   // Live counters of the open segment
+    log_bin_writer_t writer;   // Delta-time/sequence state, restarted per segment
+} log_rotator_t;
+
+/**
+ * @brief Creates LOG_DIR if needed and recovers the newest segment after a reset.
+ * @note Call once after f_mount(); the valid records of an interrupted segment
+ *       are kept and appending continues after the last one.
+ */
+FRESULT log_rotate_init(log_rotator_t* r);
+
+/**
+ * @brief Encodes rec into the current segment, rotating first if required.
+ * @note The record is batched in RAM; see log_rotate_poll().
+ */
+FRESULT log_rotate_append(log_rotator_t* r, const log_record_t* rec);
+
+/**
+ * @brief Writes the batched tail sector once it is LOG_BATCH_MAX_MS old.
+ */
+FRESULT log_rotate_poll(log_rotator_t* r, uint64_t now_ms);
+
+/**
+ * @brief Truncates the open segment, writes its index slot and closes it (e.g. before unmount).
+ */
+FRESULT log_rotate_close(log_rotator_t* r);
+
+/**
+ * @brief Number of slots in LOG_INDEX_FILE.
+ */
+uint32_t log_index_count(void);
+
+/**
+ * @brief Reads index slot `slot` into e.
+ */
+FRESULT log_index_read(uint32_t slot, log_index_entry_t* e);
+
+/**
+ * @brief Builds "LOG_DIR/<name>.bin" into path (at least 32 bytes).
+ */
+void log_segment_path(const char* name, char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LOG_ROTATE_H__
@@ -0,0 +1,214 @@
+#include "log_time.h"
+
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "hardware/rtc.h"
+#include "pico/util/datetime.h"
+
+#include "rtc.h" // time_init(): restores the datetime saved across resets
+
+// Epoch milliseconds and time_us_64() value captured at the same instant
+static uint64_t base_epoch_ms = 0;
+static uint64_t base_us = 0;
+static bool clock_valid = false;
+
+// Cached "YYYY-MM-DDTHH:MM:SS." prefix and the epoch second it represents
+static char iso_prefix[LOG_TIME_ISO_LEN - 3];
+static uint32_t iso_prefix_sec = UINT32_MAX;
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+static int32_t days_from_civil(int32_t y, uint32_t m, uint32_t d) {
+    y -= m <= 2;
+    const int32_t era = (y >= 0 ? y : y - 399) / 400;
+    const uint32_t yoe = (uint32_t)(y - era * 400);
+    const uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+void log_time_civil(uint32_t epoch_s, uint16_t* year, uint8_t* month, uint8_t* day,
+                    uint8_t* hour, uint8_t* min, uint8_t* sec) {
+    uint32_t days = epoch_s / 86400;
+    uint32_t rem = epoch_s % 86400;
+    *hour = rem / 3600;
+    *min = (rem / 60) % 60;
+    *sec = rem % 60;
+
+    // Inverse of days_from_civil(), restricted to dates after 1970
+    uint32_t z = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = m;
+    *year = yoe + era * 400 + (m <= 2);
+}
+
+static uint64_t datetime_to_epoch_ms(const datetime_t* t) {
+    int32_t days = days_from_civil(t->year, t->month, t->day);
+    uint32_t secs = (uint32_t)days * 86400u + t->hour * 3600u + t->min * 60u + t->sec;
+    return (uint64_t)secs * 1000u;
+}
+
+static inline void put2(char* p, uint32_t v) {
+    p[0] = '0' + v / 10;
+    p[1] = '0' + v % 10;
+}
+
+// Writes "YYYY-MM-DDTHH:MM:SS." for epoch_s
+static void format_prefix(uint32_t epoch_s, char* p) {
+    uint16_t year;
+    uint8_t month, day, hour, min, sec;
+    log_time_civil(epoch_s, &year, &month, &day, &hour, &min, &sec);
+
+    put2(&p[0], year / 100);
+    put2(&p[2], year % 100);
+    p[4] = '-';
+    put2(&p[5], month);
+    p[7] = '-';
+    put2(&p[8], day);
+    p[10] = 'T';
+    put2(&p[11], hour);
+    p[13] = ':';
+    put2(&p[14], min);
+    p[16] = ':';
+    put2(&p[17], sec);
+    p[19] = '.';
+}
+
+static inline void put_ms(char* p, uint32_t ms) {
+    p[0] = '0' + ms / 100;
+    p[1] = '0' + (ms / 10) % 10;
+    p[2] = '0' + ms % 10;
+}
+
+// Rebuilds the cached prefix; runs at most once per second of log activity
+static void refresh_prefix(uint32_t epoch_s) {
+    format_prefix(epoch_s, iso_prefix);
+    iso_prefix_sec = epoch_s;
+
+    // Refreshes the copy rtc.c keeps in .uninitialized_data for warm resets
+    if (clock_valid) {
+        time(NULL);
+    }
+}
+
+void log_time_init(void) {
+    time_init();
+
+    datetime_t t;
+    if (!rtc_get_datetime(&t) || t.year < 1970) {
+        // RTC never set: stamps count from the epoch so they are still ordered
+        base_epoch_ms = 0;
+        base_us = time_us_64();
+        clock_valid = false;
+        return;
+    }
+
+    // The RTC only has 1 s resolution: wait for its next edge to anchor the
+    // microsecond timer, otherwise the milliseconds could be off by up to 999.
+    int8_t start_sec = t.sec;
+    uint64_t deadline = time_us_64() + 1100 * 1000;
+    while (t.sec == start_sec && time_us_64() < deadline) {
+        rtc_get_datetime(&t);
+    }
+    base_us = time_us_64();
+    base_epoch_ms = datetime_to_epoch_ms(&t);
+    clock_valid = true;
+    iso_prefix_sec = UINT32_MAX;
+}
+
+static int days_in_month(int year, int month) {
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return days[month - 1] + (month == 2 && leap);
+}
+
+static bool parse_num(const char* s, int n, int* out) {
+    int v = 0;
+    for (int i = 0; i < n; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        v = v * 10 + (s[i] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+bool log_time_parse_iso(const char* str, uint64_t* epoch_ms) {
+    int year, month, day, hour, min, sec;
+    if (strlen(str) < 19 ||
+        !parse_num(&str[0], 4, &year) || str[4] != '-' ||
+        !parse_num(&str[5], 2, &month) || str[7] != '-' ||
+        !parse_num(&str[8], 2, &day) || (str[10] != ' ' && str[10] != 'T') ||
+        !parse_num(&str[11], 2, &hour) || str[13] != ':' ||
+        !parse_num(&str[14], 2, &min) || str[16] != ':' ||
+        !parse_num(&str[17], 2, &sec)) {
+        return false;
+    }
+    // Seconds are kept in 32 bits (log_time_civil), which last until 2106-02-07
+    if (year < 1970 || year > LOG_TIME_MAX_YEAR || month < 1 || month > 12 || day < 1 || day > days_in_month(year, month) ||
+        hour > 23 || min > 59 || sec > 59) {
+        return false;
+    }
+    uint32_t secs = (uint32_t)days_from_civil(year, month, day) * 86400u +
+                    hour * 3600u + min * 60u + sec;
+    *epoch_ms = (uint64_t)secs * 1000u;
+    return true;
+}
+
+bool log_time_set_iso(const char* str) {
+    uint64_t epoch_ms;
+    if (!log_time_parse_iso(str, &epoch_ms)) return false;
+
+    uint32_t epoch_s = (uint32_t)(epoch_ms / 1000);
+    uint16_t year;
+    uint8_t month, day, hour, min, sec;
+    log_time_civil(epoch_s, &year, &month, &day, &hour, &min, &sec);
+
+    datetime_t t = {
+        .year = year,
+        .month = month,
+        .day = day,
+        .dotw = (epoch_s / 86400 + 4) % 7, // 1970-01-01 was a Thursday
+        .hour = hour,
+        .min = min,
+        .sec = sec
+    };
+    if (!rtc_set_datetime(&t)) return false;
+
+    base_us = time_us_64();
+    base_epoch_ms = datetime_to_epoch_ms(&t);
+    clock_valid = true;
+    iso_prefix_sec = UINT32_MAX;
+    return true;
+}
+
+bool log_time_is_valid(void) {
+    return clock_valid;
+}
+
+uint64_t log_time_epoch_ms(void) {
+    return base_epoch_ms + (time_us_64() - base_us) / 1000;
+}
+
+uint64_t log_time_format_iso(char* buf) {
+    uint64_t now_ms = log_time_epoch_ms();
+    uint32_t now_s = (uint32_t)(now_ms / 1000);
+    uint32_t ms = (uint32_t)(now_ms % 1000);
+
+    if (now_s != iso_prefix_sec) {
+        refresh_prefix(now_s);
+    }
+    memcpy(buf, iso_prefix, sizeof(iso_prefix));
+    put_ms(&buf[20], ms);
+    return now_ms;
+}
+
+void log_time_format_epoch(uint64_t epoch_ms, char* buf) {
+    format_prefix((uint32_t)(epoch_ms / 1000), buf);
+    put_ms(&buf[20], (uint32_t)(epoch_ms % 1000));
+}
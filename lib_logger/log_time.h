@@ -0,0 +1,66 @@
+#ifndef __LOG_TIME_H__
+#define __LOG_TIME_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Length of an ISO-8601 stamp "YYYY-MM-DDTHH:MM:SS.mmm" (without terminator)
+#define LOG_TIME_ISO_LEN 23
+
+/**
+ * @brief Restores the RTC (time_init) and aligns the microsecond timer to it.
+ * @note Waits for the next RTC second edge (max ~1 s) so milliseconds are exact.
+ */
+void log_time_init(void);
+
+/**
+ * @brief Sets the wall clock (RTC and timestamp service) from "YYYY-MM-DD HH:MM:SS".
+ * @return true if the string was valid and the RTC accepted it.
+ */
+bool log_time_set_iso(const char* str);
+
+#define LOG_TIME_MAX_YEAR 2105 // Last full year in 32-bit epoch seconds
+
+/**
+ * @brief Parses "YYYY-MM-DD HH:MM:SS" or "YYYY-MM-DDTHH:MM:SS" into epoch milliseconds.
+ * @return false for an invalid date or time, or a year outside 1970-LOG_TIME_MAX_YEAR.
+ */
+bool log_time_parse_iso(const char* str, uint64_t* epoch_ms);
+
+/**
+ * @brief Reports whether the wall clock was ever set (otherwise stamps start at 1970).
+ */
+bool log_time_is_valid(void);
+
+/**
+ * @brief Milliseconds since 1970-01-01T00:00:00 UTC.
+ */
+uint64_t log_time_epoch_ms(void);
+
+/**
+ * @brief Writes "YYYY-MM-DDTHH:MM:SS.mmm" into buf (LOG_TIME_ISO_LEN bytes, not terminated).
+ * @note The date/time prefix is cached and only rebuilt when the second changes.
+ * @return Epoch milliseconds of the stamp that was written.
+ */
+uint64_t log_time_format_iso(char* buf);
+
+/**
+ * @brief Writes the ISO-8601 form of an arbitrary epoch_ms (LOG_TIME_ISO_LEN bytes, not terminated).
+ */
+void log_time_format_epoch(uint64_t epoch_ms, char* buf);
+
+/**
+ * @brief Converts epoch seconds into broken-down UTC fields (integer only).
+ */
+void log_time_civil(uint32_t epoch_s, uint16_t* year, uint8_t* month, uint8_t* day,
+                    uint8_t* hour, uint8_t* min, uint8_t* sec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LOG_TIME_H__
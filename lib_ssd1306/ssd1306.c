@@ -3,7 +3,6 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
-#include "math.h"
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
@@ -15,6 +14,12 @@
 const uint8_t I2C_SDA_PIN_OLED = 14;
 const uint8_t I2C_SCL_PIN_OLED = 15;
 
+static uint32_t bus_bytes; // Bytes written to the display since boot, control bytes included
+
+uint32_t ssd1306_BusBytes(void) {
+    return bus_bytes;
+}
+
 // Send a byte to the command register
 void ssd1306_WriteCommand(uint8_t byte) {
     uint8_t buffer[2];           // Buffer containing the register and the data (Creates a 2-byte buffer.)
@@ -22,6 +27,7 @@ void ssd1306_WriteCommand(uint8_t byte) {
     buffer[1] = byte;            // Stores the command to be sent. Data to be sent. 
 
     i2c_write_blocking(SSD1306_I2C_PORT, SSD1306_I2C_ADDR, buffer, sizeof(buffer), false); // Sends the buffer via I2C to the display address.
+    bus_bytes += sizeof(buffer);
 }
 
 // Send data
@@ -31,6 +37,7 @@ void ssd1306_WriteData(uint8_t* buffer, size_t buff_size) {
     memcpy(&temp_buffer[1], buffer, buff_size); // Copies data to the temporary buffer
 
     i2c_write_blocking(SSD1306_I2C_PORT, SSD1306_I2C_ADDR, temp_buffer, sizeof(temp_buffer), false); // Envia o buffer via I2C.
+    bus_bytes += sizeof(temp_buffer);
 }
 
 #else
@@ -183,6 +190,47 @@ void ssd1306_UpdateScreen(void) {
     }
 }
 
+/*
+ * Write only columns x1..x2 of pages page1..page2 to the screen.
+ * Uses the horizontal addressing window (0x21/0x22), so the region goes out in
+ * a single data transfer, then restores the full-screen window that
+ * ssd1306_UpdateScreen() relies on. Returns the bytes sent on the bus.
+ */
+size_t ssd1306_UpdateRegion(uint8_t x1, uint8_t page1, uint8_t x2, uint8_t page2) {
+    uint32_t start = bus_bytes;
+    if (x2 >= SSD1306_WIDTH) x2 = SSD1306_WIDTH - 1;
+    if (page2 >= SSD1306_HEIGHT / 8) page2 = SSD1306_HEIGHT / 8 - 1;
+    if (x1 > x2 || page1 > page2) {
+        return 0;
+    }
+
+    const uint8_t width = x2 - x1 + 1;
+    uint8_t region[SSD1306_BUFFER_SIZE];
+    size_t len = 0;
+    for (uint8_t page = page1; page <= page2; page++) {
+        memcpy(&region[len], &SSD1306_Buffer[page * SSD1306_WIDTH + x1], width);
+        len += width;
+    }
+
+    ssd1306_WriteCommand(0x21); // Column address range
+    ssd1306_WriteCommand(x1 + SSD1306_X_OFFSET_LOWER + (SSD1306_X_OFFSET_UPPER << 4));
+    ssd1306_WriteCommand(x2 + SSD1306_X_OFFSET_LOWER + (SSD1306_X_OFFSET_UPPER << 4));
+    ssd1306_WriteCommand(0x22); // Page address range
+    ssd1306_WriteCommand(page1);
+    ssd1306_WriteCommand(page2);
+    ssd1306_WriteData(region, len);
+
+    // Back to the full screen, pointer at column 0 / page 0
+    ssd1306_WriteCommand(0x21);
+    ssd1306_WriteCommand(SSD1306_X_OFFSET_LOWER + (SSD1306_X_OFFSET_UPPER << 4));
+    ssd1306_WriteCommand(SSD1306_WIDTH - 1 + SSD1306_X_OFFSET_LOWER + (SSD1306_X_OFFSET_UPPER << 4));
+    ssd1306_WriteCommand(0x22);
+    ssd1306_WriteCommand(0);
+    ssd1306_WriteCommand(SSD1306_HEIGHT / 8 - 1);
+
+    return bus_bytes - start;
+}
+
 /*
  * Draw one pixel in the screenbuffer
  * X => X Coordinate
@@ -203,6 +251,50 @@ void ssd1306_DrawPixel(uint8_t x, uint8_t y, SSD1306_COLOR color) {
     }
 }
 
+/*
+ * Fill the rectangle x1..x2 / y1..y2 (inclusive, clipped to the screen) a page
+ * byte at a time: one masked byte per column for the first and last page and
+ * whole bytes in between, instead of one DrawPixel per pixel.
+ */
+static void ssd1306_FillSpan(int16_t x1, int16_t y1, int16_t x2, int16_t y2, SSD1306_COLOR color) {
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= SSD1306_WIDTH) x2 = SSD1306_WIDTH - 1;
+    if (y2 >= SSD1306_HEIGHT) y2 = SSD1306_HEIGHT - 1;
+    if (x1 > x2 || y1 > y2) {
+        return;
+    }
+
+    const uint8_t page1 = y1 / 8, page2 = y2 / 8;
+    for (uint8_t page = page1; page <= page2; page++) {
+        uint8_t mask = 0xFF;
+        if (page == page1) mask &= 0xFF << (y1 % 8);
+        if (page == page2) mask &= 0xFF >> (7 - (y2 % 8));
+
+        uint8_t* dst = &SSD1306_Buffer[page * SSD1306_WIDTH + x1];
+        uint8_t* end = &SSD1306_Buffer[page * SSD1306_WIDTH + x2];
+        if (mask == 0xFF) {
+            memset(dst, color == White ? 0xFF : 0x00, end - dst + 1);
+        } else if (color == White) {
+            for (; dst <= end; dst++) *dst |= mask;
+        } else {
+            for (; dst <= end; dst++) *dst &= ~mask;
+        }
+    }
+}
+
+/* Draw a horizontal line from x1 to x2 */
+void ssd1306_HLine(uint8_t x1, uint8_t x2, uint8_t y, SSD1306_COLOR color) {
+    if (x1 > x2) { uint8_t t = x1; x1 = x2; x2 = t; }
+    ssd1306_FillSpan(x1, y, x2, y, color);
+}
+
+/* Draw a vertical line from y1 to y2 */
+void ssd1306_VLine(uint8_t x, uint8_t y1, uint8_t y2, SSD1306_COLOR color) {
+    if (y1 > y2) { uint8_t t = y1; y1 = y2; y2 = t; }
+    ssd1306_FillSpan(x, y1, x, y2, color);
+}
+
 /*
  * Draw 1 char to the screen buffer
  * ch       => char om weg te schrijven
@@ -265,6 +357,15 @@ void ssd1306_SetCursor(uint8_t x, uint8_t y) {
 
 /* Draw line by Bresenhem's algorithm */
 void ssd1306_Line(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
+    if (y1 == y2) {
+        ssd1306_HLine(x1, x2, y1, color);
+        return;
+    }
+    if (x1 == x2) {
+        ssd1306_VLine(x1, y1, y2, color);
+        return;
+    }
+
     int32_t deltaX = abs(x2 - x1);
     int32_t deltaY = abs(y2 - y1);
     int32_t signX = ((x1 < x2) ? 1 : -1);
@@ -304,9 +405,33 @@ void ssd1306_Polyline(const SSD1306_VERTEX *par_vertex, uint16_t par_size, SSD13
     return;
 }
 
-/* Convert Degrees to Radians */
-static float ssd1306_DegToRad(float par_deg) {
-    return par_deg * (3.14f / 180.0f);
+/* sin(0..90 degrees) * 32767 */
+static const int16_t ssd1306_SinTable[91] = {
+        0,   572,  1144,  1715,  2286,  2856,  3425,  3993,  4560,  5126,
+     5690,  6252,  6813,  7371,  7927,  8481,  9032,  9580, 10126, 10668,
+    11207, 11743, 12275, 12803, 13328, 13848, 14364, 14876, 15383, 15886,
+    16383, 16876, 17364, 17846, 18323, 18794, 19260, 19720, 20173, 20621,
+    21062, 21497, 21925, 22347, 22762, 23170, 23571, 23964, 24351, 24730,
+    25101, 25465, 25821, 26169, 26509, 26841, 27165, 27481, 27788, 28087,
+    28377, 28659, 28932, 29196, 29451, 29697, 29934, 30162, 30381, 30591,
+    30791, 30982, 31163, 31335, 31498, 31650, 31794, 31927, 32051, 32165,
+    32269, 32364, 32448, 32523, 32587, 32642, 32687, 32722, 32747, 32762,
+    32767
+};
+
+/* Integer sine of a whole degree, scaled by 32767 (no float on the M0+) */
+static int32_t ssd1306_SinDeg(uint32_t deg) {
+    deg %= 360;
+    if (deg <= 90)  return ssd1306_SinTable[deg];
+    if (deg <= 180) return ssd1306_SinTable[180 - deg];
+    if (deg <= 270) return -ssd1306_SinTable[deg - 180];
+    return -ssd1306_SinTable[360 - deg];
+}
+
+/* Point of the arc at deg, measured like the arcs below (sin on x, cos on y) */
+static void ssd1306_ArcPoint(uint8_t x, uint8_t y, uint8_t radius, uint32_t deg, uint8_t* px, uint8_t* py) {
+    *px = x + (int8_t)(ssd1306_SinDeg(deg) * radius / 32767);
+    *py = y + (int8_t)(ssd1306_SinDeg(deg + 90) * radius / 32767);
 }
 
 /* Normalize degree to [0;360] */
@@ -328,32 +453,21 @@ static uint16_t ssd1306_NormalizeTo0_360(uint16_t par_deg) {
  */
 void ssd1306_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color) {
     static const uint8_t CIRCLE_APPROXIMATION_SEGMENTS = 36;
-    float approx_degree;
     uint32_t approx_segments;
     uint8_t xp1,xp2;
     uint8_t yp1,yp2;
     uint32_t count;
     uint32_t loc_sweep;
-    float rad;
     
     loc_sweep = ssd1306_NormalizeTo0_360(sweep);
     
     count = (ssd1306_NormalizeTo0_360(start_angle) * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
     approx_segments = (loc_sweep * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
-    approx_degree = loc_sweep / (float)approx_segments;
     while(count < approx_segments)
     {
-        rad = ssd1306_DegToRad(count*approx_degree);
-        xp1 = x + (int8_t)(sinf(rad)*radius);
-        yp1 = y + (int8_t)(cosf(rad)*radius);    
+        ssd1306_ArcPoint(x, y, radius, count * loc_sweep / approx_segments, &xp1, &yp1);
         count++;
-        if(count != approx_segments) {
-            rad = ssd1306_DegToRad(count*approx_degree);
-        } else {
-            rad = ssd1306_DegToRad(loc_sweep);
-        }
-        xp2 = x + (int8_t)(sinf(rad)*radius);
-        yp2 = y + (int8_t)(cosf(rad)*radius);    
+        ssd1306_ArcPoint(x, y, radius, count * loc_sweep / approx_segments, &xp2, &yp2);
         ssd1306_Line(xp1,yp1,xp2,yp2,color);
     }
     
@@ -368,7 +482,6 @@ void ssd1306_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle,
  */
 void ssd1306_DrawArcWithRadiusLine(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color) {
     const uint32_t CIRCLE_APPROXIMATION_SEGMENTS = 36;
-    float approx_degree;
     uint32_t approx_segments;
     uint8_t xp1;
     uint8_t xp2 = 0;
@@ -376,29 +489,18 @@ void ssd1306_DrawArcWithRadiusLine(uint8_t x, uint8_t y, uint8_t radius, uint16_
     uint8_t yp2 = 0;
     uint32_t count;
     uint32_t loc_sweep;
-    float rad;
     
     loc_sweep = ssd1306_NormalizeTo0_360(sweep);
     
     count = (ssd1306_NormalizeTo0_360(start_angle) * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
     approx_segments = (loc_sweep * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
-    approx_degree = loc_sweep / (float)approx_segments;
 
-    rad = ssd1306_DegToRad(count*approx_degree);
-    uint8_t first_point_x = x + (int8_t)(sinf(rad)*radius);
-    uint8_t first_point_y = y + (int8_t)(cosf(rad)*radius);   
+    uint8_t first_point_x, first_point_y;
+    ssd1306_ArcPoint(x, y, radius, approx_segments ? count * loc_sweep / approx_segments : 0, &first_point_x, &first_point_y);
     while (count < approx_segments) {
-        rad = ssd1306_DegToRad(count*approx_degree);
-        xp1 = x + (int8_t)(sinf(rad)*radius);
-        yp1 = y + (int8_t)(cosf(rad)*radius);    
+        ssd1306_ArcPoint(x, y, radius, count * loc_sweep / approx_segments, &xp1, &yp1);
         count++;
-        if (count != approx_segments) {
-            rad = ssd1306_DegToRad(count*approx_degree);
-        } else {
-            rad = ssd1306_DegToRad(loc_sweep);
-        }
-        xp2 = x + (int8_t)(sinf(rad)*radius);
-        yp2 = y + (int8_t)(cosf(rad)*radius);    
+        ssd1306_ArcPoint(x, y, radius, count * loc_sweep / approx_segments, &xp2, &yp2);
         ssd1306_Line(xp1,yp1,xp2,yp2,color);
     }
     
@@ -455,11 +557,9 @@ void ssd1306_FillCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR
     }
 
     do {
-        for (uint8_t _y = (par_y + y); _y >= (par_y - y); _y--) {
-            for (uint8_t _x = (par_x - x); _x >= (par_x + x); _x--) {
-                ssd1306_DrawPixel(_x, _y, par_color);
-            }
-        }
+        // Columns par_x-|x| and par_x+|x| span the full chord; later steps only grow y
+        ssd1306_FillSpan(par_x + x, par_y - y, par_x + x, par_y + y, par_color);
+        ssd1306_FillSpan(par_x - x, par_y - y, par_x - x, par_y + y, par_color);
 
         e2 = err;
         if (e2 <= y) {
@@ -481,10 +581,10 @@ void ssd1306_FillCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR
 
 /* Draw a rectangle */
 void ssd1306_DrawRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
-    ssd1306_Line(x1,y1,x2,y1,color);
-    ssd1306_Line(x2,y1,x2,y2,color);
-    ssd1306_Line(x2,y2,x1,y2,color);
-    ssd1306_Line(x1,y2,x1,y1,color);
+    ssd1306_HLine(x1,x2,y1,color);
+    ssd1306_VLine(x2,y1,y2,color);
+    ssd1306_HLine(x1,x2,y2,color);
+    ssd1306_VLine(x1,y1,y2,color);
 
     return;
 }
@@ -496,11 +596,7 @@ void ssd1306_FillRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD13
     uint8_t y_start = ((y1<=y2) ? y1 : y2);
     uint8_t y_end   = ((y1<=y2) ? y2 : y1);
 
-    for (uint8_t y= y_start; (y<= y_end)&&(y<SSD1306_HEIGHT); y++) {
-        for (uint8_t x= x_start; (x<= x_end)&&(x<SSD1306_WIDTH); x++) {
-            ssd1306_DrawPixel(x, y, color);
-        }
-    }
+    ssd1306_FillSpan(x_start, y_start, x_end, y_end, color);
     return;
 }
 
@@ -715,23 +811,144 @@ void ssd1306_FillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_
         a = ax + (dx01 * (y - ay)) / (dy01 ? dy01 : 1);
         b = ax + (dx02 * (y - ay)) / (dy02 ? dy02 : 1);
         if (a > b) { int16_t t = a; a = b; b = t; }
-        for (int16_t x = a; x <= b; x++) {
-            ssd1306_DrawPixel(x, y, color);
-        }
+        ssd1306_FillSpan(a, y, b, y, color);
     }
     // Parte inferior do triângulo
     for (y = by; y <= cy; y++) {
         a = bx + (dx12 * (y - by)) / (dy12 ? dy12 : 1);
         b = ax + (dx02 * (y - ay)) / (dy02 ? dy02 : 1);
         if (a > b) { int16_t t = a; a = b; b = t; }
-        for (int16_t x = a; x <= b; x++) {
-            ssd1306_DrawPixel(x, y, color);
+        ssd1306_FillSpan(a, y, b, y, color);
+    }
+}
+
+/**
+ * @brief Calcula a largura de um texto em pixels.
+ * @param text Texto a ser medido.
+ * @param Font Fonte a ser utilizada.
+ * @return Largura total em pixels.
+ */
+uint16_t ssd1306_TextWidth(const char* text, SSD1306_Font_t Font) {
+    uint16_t width = 0;
+    for (; *text; text++) {
+        if (*text < 32 || *text > 126) continue;
+        width += Font.char_width ? Font.char_width[*text - 32] : Font.width;
+    }
+    return width;
+}
+
+/**
+ * @brief Inicia a rolagem não bloqueante de um texto (da direita até sair pela esquerda, em loop).
+ *
+ * O texto é renderizado uma única vez na faixa do scroller; ssd1306_ScrollerPoll() só copia
+ * a janela visível e envia as páginas ocupadas pelo texto. Os comandos de scroll do próprio
+ * SSD1306 apenas giram as 128 colunas já na GDDRAM, por isso não servem para texto mais
+ * largo que a tela.
+ * @param s Scroller.
+ * @param text Texto (cortado em SSD1306_SCROLL_STRIP_WIDTH pixels).
+ * @param Font Fonte a ser utilizada.
+ * @param color Cor do texto (o fundo usa a cor oposta).
+ * @param y Linha vertical onde o texto será exibido.
+ * @param delay_ms Tempo entre deslocamentos de um pixel.
+ * @param now_ms Tempo atual em milissegundos.
+ */
+void ssd1306_ScrollerStart(SSD1306_Scroller_t* s, const char* text, SSD1306_Font_t Font, SSD1306_COLOR color, uint8_t y, uint16_t delay_ms, uint32_t now_ms) {
+    memset(s, 0, sizeof(*s));
+    const uint8_t shift = y % 8;
+    uint8_t height = Font.height;
+    if (y + height > SSD1306_HEIGHT) height = SSD1306_HEIGHT - y;
+    s->page = y / 8;
+    s->pages = (shift + height + 7) / 8;
+    if (s->pages > SSD1306_SCROLL_PAGES) {
+        s->pages = SSD1306_SCROLL_PAGES;
+        height = SSD1306_SCROLL_PAGES * 8 - shift;
+    }
+    for (uint8_t row = shift; row < shift + height; row++) {
+        s->mask[row / 8] |= 1 << (row % 8);
+    }
+
+    // Só os pixels acesos do texto; a cor é aplicada ao copiar para o buffer
+    uint16_t x = 0;
+    for (; *text; text++) {
+        if (*text < 32 || *text > 126) continue;
+        uint8_t charWidth = Font.char_width ? Font.char_width[*text - 32] : Font.width;
+        if (x + charWidth > SSD1306_SCROLL_STRIP_WIDTH) break;
+        for (uint8_t i = 0; i < height; i++) {
+            uint16_t b = Font.data[(*text - 32) * Font.height + i];
+            uint8_t row = shift + i;
+            for (uint8_t j = 0; j < Font.width && x + j < SSD1306_SCROLL_STRIP_WIDTH; j++) {
+                if ((b << j) & 0x8000) {
+                    s->strip[row / 8][x + j] |= 1 << (row % 8);
+                }
+            }
+        }
+        x += charWidth;
+    }
+
+    s->text_width = x;
+    s->color = color;
+    s->delay_ms = delay_ms ? delay_ms : 1;
+    s->last_step_ms = now_ms;
+    s->running = 1;
+    s->dirty = 1;
+}
+
+/**
+ * @brief Avança a rolagem conforme o tempo decorrido e envia as páginas do texto.
+ *
+ * Se o laço atrasou, pula os passos perdidos em vez de enviar um quadro por passo.
+ * @param s Scroller.
+ * @param now_ms Tempo atual em milissegundos.
+ * @return Bytes enviados ao display (0 se nada mudou).
+ */
+size_t ssd1306_ScrollerPoll(SSD1306_Scroller_t* s, uint32_t now_ms) {
+    if (!s->running) return 0;
+
+    const uint32_t period = s->text_width + SSD1306_WIDTH;
+    uint32_t steps = (now_ms - s->last_step_ms) / s->delay_ms;
+    if (steps == 0 && !s->dirty) return 0;
+    if (steps > 0) {
+        s->last_step_ms += steps * s->delay_ms;
+        uint32_t offset = s->offset + steps;
+        s->passes += offset / period;
+        s->offset = offset % period;
+    }
+    s->dirty = 0;
+
+    // Coluna v da janela virtual: [SSD1306_WIDTH colunas vazias][texto]
+    for (uint8_t p = 0; p < s->pages; p++) {
+        uint8_t* dst = &SSD1306_Buffer[(s->page + p) * SSD1306_WIDTH];
+        const uint8_t mask = s->mask[p];
+        for (uint16_t x = 0; x < SSD1306_WIDTH; x++) {
+            int32_t col = (int32_t)s->offset + x - SSD1306_WIDTH;
+            uint8_t bits = (col >= 0 && col < s->text_width) ? s->strip[p][col] : 0;
+            if (s->color == Black) bits = ~bits;
+            dst[x] = (dst[x] & ~mask) | (bits & mask);
         }
     }
+    return ssd1306_UpdateRegion(0, s->page, SSD1306_WIDTH - 1, s->page + s->pages - 1);
+}
+
+/**
+ * @brief Força o reenvio do texto no próximo ssd1306_ScrollerPoll() (ex.: após redesenhar a tela toda).
+ * @param s Scroller.
+ */
+void ssd1306_ScrollerInvalidate(SSD1306_Scroller_t* s) {
+    s->dirty = 1;
+}
+
+/**
+ * @brief Para a rolagem; o conteúdo atual permanece no buffer.
+ * @param s Scroller.
+ */
+void ssd1306_ScrollerStop(SSD1306_Scroller_t* s) {
+    s->running = 0;
 }
 
 /**
  * @brief Exibe um texto que não cabe totalmente na tela fazendo scroll horizontal (sem quebra de linha).
+ *
+ * Versão bloqueante de uma volta do scroller: envia só as páginas do texto a cada passo.
  * @param text Texto a ser exibido.
  * @param Font Fonte a ser utilizada.
  * @param color Cor do texto.
@@ -739,39 +956,11 @@ void ssd1306_FillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_
  * @param delay_ms Tempo de atraso (em milissegundos) entre as atualizações do scroll.
  */
 void ssd1306_ScrollTextHorizontal(const char* text, SSD1306_Font_t Font, SSD1306_COLOR color, uint8_t y, uint16_t delay_ms) {
-    // Calcula a largura total do texto
-    uint16_t text_width = 0;
-    const char* ptr = text;
-    while (*ptr) {
-        uint8_t charWidth = Font.char_width ? Font.char_width[*ptr - 32] : Font.width;
-        text_width += charWidth;
-        ptr++;
-    }
-    
-    // O scroll ocorrerá do texto completamente à direita até ele ter rolado para fora pela esquerda.
-    // Ou seja, o deslocamento varia de 0 até (text_width + SSD1306_WIDTH)
-    for (int offset = 0; offset < text_width + SSD1306_WIDTH; offset++) {
-        // Limpa a área onde o texto será desenhado
-        ssd1306_FillRectangle(0, y, SSD1306_WIDTH - 1, y + Font.height - 1, Black);
-        
-        // Desenha o texto com deslocamento: x inicial negativo faz com que o início do texto fique fora da tela e entre gradualmente
-        int currentX = SSD1306_WIDTH - offset;
-        ptr = text;
-        while (*ptr) {
-            uint8_t charWidth = Font.char_width ? Font.char_width[*ptr - 32] : Font.width;
-            // Desenha o caractere somente se ele estiver dentro da área visível
-            if ( (currentX + charWidth > 0) && (currentX < SSD1306_WIDTH) ) {
-                // Salva a posição atual para não interferir com o resto do desenho
-                uint16_t savedX = SSD1306.CurrentX;
-                uint16_t savedY = SSD1306.CurrentY;
-                ssd1306_SetCursor(currentX, y);
-                ssd1306_WriteChar(*ptr, Font, color);
-                ssd1306_SetCursor(savedX, savedY);
-            }
-            currentX += charWidth;
-            ptr++;
-        }
-        ssd1306_UpdateScreen();
-        sleep_ms(delay_ms);
+    static SSD1306_Scroller_t scroller; // Faixa grande demais para a pilha
+    ssd1306_ScrollerStart(&scroller, text, Font, color, y, delay_ms, to_ms_since_boot(get_absolute_time()));
+    while (scroller.passes == 0) {
+        ssd1306_ScrollerPoll(&scroller, to_ms_since_boot(get_absolute_time()));
+        sleep_ms(1);
     }
-}
\ No newline at end of file
+    ssd1306_ScrollerStop(&scroller);
+}
@@ -81,11 +81,15 @@ typedef struct {
 void ssd1306_Init(void);
 void ssd1306_Fill(SSD1306_COLOR color);
 void ssd1306_UpdateScreen(void);
+size_t ssd1306_UpdateRegion(uint8_t x1, uint8_t page1, uint8_t x2, uint8_t page2);
+uint32_t ssd1306_BusBytes(void);
 void ssd1306_DrawPixel(uint8_t x, uint8_t y, SSD1306_COLOR color);
 char ssd1306_WriteChar(char ch, SSD1306_Font_t Font, SSD1306_COLOR color);
 char ssd1306_WriteString(char* str, SSD1306_Font_t Font, SSD1306_COLOR color);
 void ssd1306_SetCursor(uint8_t x, uint8_t y);
 void ssd1306_Line(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color);
+void ssd1306_HLine(uint8_t x1, uint8_t x2, uint8_t y, SSD1306_COLOR color);
+void ssd1306_VLine(uint8_t x, uint8_t y1, uint8_t y2, SSD1306_COLOR color);
 void ssd1306_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color);
 void ssd1306_DrawArcWithRadiusLine(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color);
 void ssd1306_DrawCircle(uint8_t par_x, uint8_t par_y, uint8_t par_r, SSD1306_COLOR color);
@@ -142,6 +146,32 @@ void ssd1306_WriteStringWrapped(const char* str, SSD1306_Font_t Font, SSD1306_CO
 void ssd1306_DrawTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color);
 void ssd1306_FillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color);
 
+// Rolagem de texto não bloqueante: o texto é pré-renderizado uma vez numa faixa fora da tela
+// e cada passo copia a janela visível para o buffer e envia apenas as páginas do texto.
+#define SSD1306_SCROLL_STRIP_WIDTH 256  // Largura máxima do texto pré-renderizado (px)
+#define SSD1306_SCROLL_PAGES       5    // Fonte de até 26 px em qualquer y
+
+typedef struct {
+    uint8_t strip[SSD1306_SCROLL_PAGES][SSD1306_SCROLL_STRIP_WIDTH]; // Texto em colunas de página
+    uint8_t mask[SSD1306_SCROLL_PAGES]; // Bits de cada página ocupados pelo texto
+    uint16_t text_width;
+    uint16_t offset;       // 0 .. text_width + SSD1306_WIDTH - 1
+    uint8_t page;          // Primeira página do texto
+    uint8_t pages;
+    SSD1306_COLOR color;
+    uint16_t delay_ms;     // Tempo por pixel deslocado
+    uint32_t last_step_ms;
+    uint32_t passes;       // Voltas completas
+    uint8_t running;
+    uint8_t dirty;         // Redesenhar mesmo sem passo pendente
+} SSD1306_Scroller_t;
+
+void ssd1306_ScrollerStart(SSD1306_Scroller_t* s, const char* text, SSD1306_Font_t Font, SSD1306_COLOR color, uint8_t y, uint16_t delay_ms, uint32_t now_ms);
+size_t ssd1306_ScrollerPoll(SSD1306_Scroller_t* s, uint32_t now_ms);
+void ssd1306_ScrollerInvalidate(SSD1306_Scroller_t* s);
+void ssd1306_ScrollerStop(SSD1306_Scroller_t* s);
+uint16_t ssd1306_TextWidth(const char* text, SSD1306_Font_t Font);
+
 void ssd1306_ScrollTextHorizontal(const char* text, SSD1306_Font_t Font, SSD1306_COLOR color, uint8_t y, uint16_t delay_ms);
 
 // ========================================
@@ -146,4 +146,8 @@ const unsigned char OLED_bitmap[] = {
 
     const unsigned char arrow_bitmap[] = {
         0x18, 0x3C, 0x7E, 0xFF, 0x18, 0x18, 0x18, 0x18
-    };
\ No newline at end of file
+    };
+    // 8x8 motion indicator (walking figure), row-major, MSB left
+    const unsigned char motion_bitmap[] = {
+        0x18, 0x18, 0x3C, 0x5A, 0x18, 0x24, 0x42, 0x42
+    };
@@ -8,5 +8,6 @@
 extern const unsigned char OLED_bitmap[];
 extern const uint8_t bitdogleb[];
 extern const unsigned char arrow_bitmap[];
+extern const unsigned char motion_bitmap[];
 
 #endif // SSD1306_BITMAPS_H
\ No newline at end of file
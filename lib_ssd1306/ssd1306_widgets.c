@@ -0,0 +1,171 @@
+#include "ssd1306_widgets.h"
+
+#include <string.h>
+
+static void widget_init(SSD1306_Widget_t* w, SSD1306_WidgetType_t type,
+                        uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    memset(w, 0, sizeof(*w));
+    w->type = type;
+    w->x = x;
+    w->y = y;
+    w->w = width;
+    w->h = height;
+    w->dirty = true;
+}
+
+void ssd1306_WidgetLabel(SSD1306_Widget_t* w, uint8_t x, uint8_t y, uint8_t width, const SSD1306_Font_t* font) {
+    widget_init(w, SSD1306_WIDGET_LABEL, x, y, width, font->height);
+    w->font = font;
+}
+
+void ssd1306_WidgetStatusBar(SSD1306_Widget_t* w, uint8_t y, const SSD1306_Font_t* font) {
+    widget_init(w, SSD1306_WIDGET_STATUS_BAR, 0, y, SSD1306_WIDTH, font->height);
+    w->font = font;
+}
+
+void ssd1306_WidgetIcon(SSD1306_Widget_t* w, uint8_t x, uint8_t y, const unsigned char* bitmap, uint8_t width, uint8_t height) {
+    widget_init(w, SSD1306_WIDGET_ICON, x, y, width, height);
+    w->icon.bitmap = bitmap;
+}
+
+void ssd1306_WidgetSparkline(SSD1306_Widget_t* w, uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    widget_init(w, SSD1306_WIDGET_SPARKLINE, x, y, width, height);
+}
+
+/* Copies text into dst (truncated to what fits in max_px), true if it changed */
+static bool set_text(char* dst, const char* text, const SSD1306_Font_t* font, uint8_t max_px) {
+    size_t max_chars = max_px / font->width;
+    if (max_chars > SSD1306_LABEL_MAX - 1) max_chars = SSD1306_LABEL_MAX - 1;
+    size_t len = strnlen(text, max_chars);
+    if (strncmp(dst, text, len) == 0 && dst[len] == '\0') {
+        return false;
+    }
+    memcpy(dst, text, len);
+    dst[len] = '\0';
+    return true;
+}
+
+void ssd1306_WidgetSetText(SSD1306_Widget_t* w, const char* text) {
+    if (set_text(w->label.text, text, w->font, w->w)) {
+        w->dirty = true;
+    }
+}
+
+void ssd1306_WidgetSetStatus(SSD1306_Widget_t* w, const char* left, const char* right) {
+    bool changed = set_text(w->bar.right, right, w->font, w->w);
+    uint8_t right_px = strlen(w->bar.right) * w->font->width;
+    changed |= set_text(w->bar.left, left, w->font, w->w - right_px);
+    if (changed) {
+        w->dirty = true;
+    }
+}
+
+void ssd1306_WidgetSetVisible(SSD1306_Widget_t* w, bool visible) {
+    if (w->icon.visible != visible) {
+        w->icon.visible = visible;
+        w->dirty = true;
+    }
+}
+
+void ssd1306_WidgetSetPoints(SSD1306_Widget_t* w, const int32_t* points, uint8_t count) {
+    if (count > SSD1306_SPARKLINE_MAX) count = SSD1306_SPARKLINE_MAX;
+    if (count == w->spark.count && memcmp(w->spark.points, points, count * sizeof(points[0])) == 0) {
+        return;
+    }
+    memcpy(w->spark.points, points, count * sizeof(points[0]));
+    w->spark.count = count;
+    w->dirty = true;
+}
+
+void ssd1306_WidgetsInvalidate(SSD1306_Widget_t* const* widgets, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        widgets[i]->dirty = true;
+    }
+}
+
+static void draw_text(uint8_t x, uint8_t y, const char* text, const SSD1306_Font_t* font, SSD1306_COLOR color) {
+    ssd1306_SetCursor(x, y);
+    while (*text) {
+        ssd1306_WriteChar(*text++, *font, color);
+    }
+}
+
+static void draw_sparkline(const SSD1306_Widget_t* w) {
+    int32_t lo = INT32_MAX, hi = INT32_MIN;
+    for (uint8_t i = 0; i < w->spark.count; i++) {
+        int32_t v = w->spark.points[i];
+        if (v == SSD1306_SPARKLINE_GAP) continue;
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    if (lo > hi) {
+        return; // No data
+    }
+
+    const int32_t range = hi - lo;
+    const uint8_t span = w->spark.count > 1 ? w->spark.count - 1 : 1;
+    int prev_x = -1, prev_y = 0;
+    for (uint8_t i = 0; i < w->spark.count; i++) {
+        int32_t v = w->spark.points[i];
+        if (v == SSD1306_SPARKLINE_GAP) {
+            prev_x = -1;
+            continue;
+        }
+        int x = w->x + i * (w->w - 1) / span;
+        int y = range == 0 ? w->y + w->h / 2
+                           : w->y + w->h - 1 - (int)((int64_t)(v - lo) * (w->h - 1) / range);
+        if (prev_x >= 0) {
+            ssd1306_Line(prev_x, prev_y, x, y, White);
+        } else {
+            ssd1306_DrawPixel(x, y, White);
+        }
+        prev_x = x;
+        prev_y = y;
+    }
+}
+
+static void draw_widget(const SSD1306_Widget_t* w) {
+    switch (w->type) {
+        case SSD1306_WIDGET_LABEL:
+            draw_text(w->x, w->y, w->label.text, w->font, White);
+            break;
+        case SSD1306_WIDGET_STATUS_BAR:
+            ssd1306_FillRectangle(w->x, w->y, w->x + w->w - 1, w->y + w->h - 1, White);
+            draw_text(w->x, w->y, w->bar.left, w->font, Black);
+            draw_text(w->x + w->w - strlen(w->bar.right) * w->font->width, w->y, w->bar.right, w->font, Black);
+            break;
+        case SSD1306_WIDGET_ICON:
+            if (w->icon.visible) {
+                ssd1306_DrawBitmap(w->x, w->y, w->icon.bitmap, w->w, w->h, White);
+            }
+            break;
+        case SSD1306_WIDGET_SPARKLINE:
+            draw_sparkline(w);
+            break;
+    }
+}
+
+size_t ssd1306_WidgetsRender(SSD1306_Widget_t* const* widgets, uint8_t count, bool full) {
+    size_t bytes = 0;
+
+    if (full) {
+        ssd1306_Fill(Black);
+        for (uint8_t i = 0; i < count; i++) {
+            draw_widget(widgets[i]);
+            widgets[i]->dirty = false;
+        }
+        uint32_t start = ssd1306_BusBytes();
+        ssd1306_UpdateScreen();
+        return ssd1306_BusBytes() - start;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        SSD1306_Widget_t* w = widgets[i];
+        if (!w->dirty) continue;
+        ssd1306_FillRectangle(w->x, w->y, w->x + w->w - 1, w->y + w->h - 1, Black);
+        draw_widget(w);
+        w->dirty = false;
+        bytes += ssd1306_UpdateRegion(w->x, w->y / 8, w->x + w->w - 1, (w->y + w->h - 1) / 8);
+    }
+    return bytes;
+}
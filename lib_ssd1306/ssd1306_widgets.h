@@ -0,0 +1,80 @@
+#ifndef __SSD1306_WIDGETS_H__
+#define __SSD1306_WIDGETS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <_ansi.h>
+
+_BEGIN_STD_C
+
+#include "ssd1306.h"
+
+/*
+ * Retained-mode widgets on top of the screen buffer.
+ *
+ * Each widget owns a bounding box and the value it shows. Setters compare the
+ * new value with the retained one and only mark the widget dirty when it
+ * changed; ssd1306_WidgetsRender() then clears and redraws the dirty widgets
+ * and sends just their pages/columns with ssd1306_UpdateRegion(), instead of
+ * clearing, redrawing and pushing the whole 1 KiB frame every refresh.
+ */
+
+#define SSD1306_LABEL_MAX     22         // 128 px / 6 px font + terminator
+#define SSD1306_SPARKLINE_MAX 64         // Points of a sparkline
+#define SSD1306_SPARKLINE_GAP INT32_MIN  // Point without data (breaks the line)
+
+typedef enum {
+    SSD1306_WIDGET_LABEL,      // One line of text
+    SSD1306_WIDGET_STATUS_BAR, // Inverted full-width line, text left and right
+    SSD1306_WIDGET_ICON,       // Bitmap shown or hidden
+    SSD1306_WIDGET_SPARKLINE   // Trend line scaled to its own min/max
+} SSD1306_WidgetType_t;
+
+typedef struct {
+    SSD1306_WidgetType_t type;
+    uint8_t x, y, w, h;        // Bounding box
+    bool dirty;
+    const SSD1306_Font_t* font;
+    union {
+        struct {
+            char text[SSD1306_LABEL_MAX];
+        } label;
+        struct {
+            char left[SSD1306_LABEL_MAX];
+            char right[SSD1306_LABEL_MAX];
+        } bar;
+        struct {
+            const unsigned char* bitmap;
+            bool visible;
+        } icon;
+        struct {
+            int32_t points[SSD1306_SPARKLINE_MAX];
+            uint8_t count;
+        } spark;
+    };
+} SSD1306_Widget_t;
+
+void ssd1306_WidgetLabel(SSD1306_Widget_t* w, uint8_t x, uint8_t y, uint8_t width, const SSD1306_Font_t* font);
+void ssd1306_WidgetStatusBar(SSD1306_Widget_t* w, uint8_t y, const SSD1306_Font_t* font);
+void ssd1306_WidgetIcon(SSD1306_Widget_t* w, uint8_t x, uint8_t y, const unsigned char* bitmap, uint8_t width, uint8_t height);
+void ssd1306_WidgetSparkline(SSD1306_Widget_t* w, uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+
+void ssd1306_WidgetSetText(SSD1306_Widget_t* w, const char* text);
+void ssd1306_WidgetSetStatus(SSD1306_Widget_t* w, const char* left, const char* right);
+void ssd1306_WidgetSetVisible(SSD1306_Widget_t* w, bool visible);
+void ssd1306_WidgetSetPoints(SSD1306_Widget_t* w, const int32_t* points, uint8_t count);
+
+/* Marks every widget dirty (e.g. after switching screens) */
+void ssd1306_WidgetsInvalidate(SSD1306_Widget_t* const* widgets, uint8_t count);
+
+/*
+ * Redraws the dirty widgets and sends their regions to the display.
+ * full: clear the buffer, draw every widget and send the whole frame.
+ * Returns the bytes sent on the bus (0 if nothing changed).
+ */
+size_t ssd1306_WidgetsRender(SSD1306_Widget_t* const* widgets, uint8_t count, bool full);
+
+_END_STD_C
+
+#endif // __SSD1306_WIDGETS_H__
@@ -0,0 +1,115 @@
+#include "telemetry.h"
+
+#include <string.h>
+
+#include "lib_logger/log_fixed.h"
+
+#define HOUR_MS (60u * TELEM_MINUTE_MS)
+
+static const char* const channel_prefix[TELEM_NUM_CHANNELS] = { "TEMP_C:", "PRESS_HPA:" };
+
+void telemetry_init(telemetry_t* t, uint64_t now_ms) {
+    memset(t, 0, sizeof(*t));
+    t->minute_start_ms = now_ms - now_ms % TELEM_MINUTE_MS;
+}
+
+bool telemetry_parse_line(const char* line, telem_channel_t* ch, int32_t* value) {
+    for (int i = 0; i < TELEM_NUM_CHANNELS; i++) {
+        size_t len = strlen(channel_prefix[i]);
+        if (strncmp(line, channel_prefix[i], len) == 0) {
+            *ch = (telem_channel_t)i;
+            return log_fixed_parse(line + len, TELEM_DECIMALS, value);
+        }
+    }
+    return false;
+}
+
+static void close_minute(telemetry_t* t, telem_emit_t emit, void* ctx) {
+    for (int i = 0; i < TELEM_NUM_CHANNELS; i++) {
+        telem_series_t* s = &t->series[i];
+        telem_rollup_t r = { 0 };
+        if (s->count > 0) {
+            r.min = s->min;
+            r.max = s->max;
+            r.mean = (int32_t)(s->sum / s->count);
+            r.count = s->count;
+
+            if (s->hour_count == 0 || r.min < s->hour_min) s->hour_min = r.min;
+            if (s->hour_count == 0 || r.max > s->hour_max) s->hour_max = r.max;
+            s->hour_sum += s->sum;
+            s->hour_count += s->count;
+            if (emit) emit((telem_channel_t)i, false, &r, ctx);
+        }
+        // Empty minutes are stored too, so the sparkline shows the gap
+        s->minutes[s->minute_head] = r;
+        s->minute_head = (s->minute_head + 1) % TELEM_MINUTES;
+        if (s->minutes_stored < TELEM_MINUTES) s->minutes_stored++;
+        s->count = 0;
+        s->sum = 0;
+    }
+}
+
+static void close_hour(telemetry_t* t, telem_emit_t emit, void* ctx) {
+    for (int i = 0; i < TELEM_NUM_CHANNELS; i++) {
+        telem_series_t* s = &t->series[i];
+        telem_rollup_t r = { 0 };
+        if (s->hour_count > 0) {
+            r.min = s->hour_min;
+            r.max = s->hour_max;
+            r.mean = (int32_t)(s->hour_sum / s->hour_count);
+            r.count = s->hour_count > UINT16_MAX ? UINT16_MAX : (uint16_t)s->hour_count;
+            if (emit) emit((telem_channel_t)i, true, &r, ctx);
+        }
+        s->hours[s->hour_head] = r;
+        s->hour_head = (s->hour_head + 1) % TELEM_HOURS;
+        if (s->hours_stored < TELEM_HOURS) s->hours_stored++;
+        s->hour_count = 0;
+        s->hour_sum = 0;
+    }
+}
+
+void telemetry_poll(telemetry_t* t, uint64_t now_ms, telem_emit_t emit, void* ctx) {
+    // Clock set or stepped: close what was collected and restart on the new time base
+    if (now_ms < t->minute_start_ms ||
+        now_ms - t->minute_start_ms >= (uint64_t)TELEM_MINUTES * TELEM_MINUTE_MS) {
+        close_minute(t, emit, ctx);
+        close_hour(t, emit, ctx);
+        t->minute_start_ms = now_ms - now_ms % TELEM_MINUTE_MS;
+        return;
+    }
+
+    while (now_ms - t->minute_start_ms >= TELEM_MINUTE_MS) {
+        close_minute(t, emit, ctx);
+        t->minute_start_ms += TELEM_MINUTE_MS;
+        if (t->minute_start_ms % HOUR_MS == 0) {
+            close_hour(t, emit, ctx);
+        }
+    }
+}
+
+void telemetry_sample(telemetry_t* t, telem_channel_t ch, int32_t value, uint64_t now_ms,
+                      telem_emit_t emit, void* ctx) {
+    telemetry_poll(t, now_ms, emit, ctx);
+
+    telem_series_t* s = &t->series[ch];
+    if (s->count == 0 || value < s->min) s->min = value;
+    if (s->count == 0 || value > s->max) s->max = value;
+    if (s->count < UINT16_MAX) {
+        s->sum += value;
+        s->count++;
+    }
+    s->last = value;
+    s->has_last = true;
+}
+
+const telem_rollup_t* telemetry_minute(const telemetry_t* t, telem_channel_t ch, uint8_t age) {
+    const telem_series_t* s = &t->series[ch];
+    if (age >= s->minutes_stored) {
+        return NULL;
+    }
+    return &s->minutes[(s->minute_head + TELEM_MINUTES - 1 - age) % TELEM_MINUTES];
+}
+
+const char* telemetry_channel_str(telem_channel_t ch) {
+    return ch == TELEM_TEMP ? "TEMP_C" : "PRESS_HPA";
+}
@@ -0,0 +1,104 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Environmental telemetry from a reader front-end ("TEMP_C:23.45",
+ "PRESS_HPA:1013.25", every 2 s).
+
+ Values are kept in fixed point (log_fixed), hundredths of the unit
+ (2345 = 23.45 C), so nothing here touches soft-float. Samples are folded
+ into min/max/mean rollups: one per wall-clock minute (ring of TELEM_MINUTES)
+ and one per hour built from the minute rollups (ring of TELEM_HOURS). Only
+ closed rollups leave the module, through the emit callback, so the SD card
+ sees one small record per channel and minute instead of every sample.
+*/
+
+#define TELEM_MINUTES   60 // 1-minute rollups kept (last hour, sparkline source)
+#define TELEM_HOURS     24 // 1-hour rollups kept (last day)
+#define TELEM_MINUTE_MS 60000u
+#define TELEM_DECIMALS  2  // Fixed-point places of every channel
+
+typedef enum {
+    TELEM_TEMP = 0,   // TEMP_C, 0.01 C
+    TELEM_PRESS = 1,  // PRESS_HPA, 0.01 hPa
+    TELEM_NUM_CHANNELS
+} telem_channel_t;
+
+typedef struct {
+    int32_t min;      // Hundredths of the unit
+    int32_t max;
+    int32_t mean;
+    uint16_t count;   // Samples rolled up, 0 if the interval had none
+} telem_rollup_t;
+
+typedef struct {
+    // Interval in progress
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint16_t count;
+
+    int32_t last;                       // Latest sample
+    bool has_last;
+
+    // Hour in progress, built from closed minutes
+    int32_t hour_min;
+    int32_t hour_max;
+    int64_t hour_sum;                   // Sum of mean * count
+    uint32_t hour_count;
+
+    telem_rollup_t minutes[TELEM_MINUTES];
+    uint8_t minute_head;                // Slot of the next closed minute
+    uint8_t minutes_stored;
+    telem_rollup_t hours[TELEM_HOURS];
+    uint8_t hour_head;
+    uint8_t hours_stored;
+} telem_series_t;
+
+typedef struct {
+    telem_series_t series[TELEM_NUM_CHANNELS];
+    uint64_t minute_start_ms;           // Epoch ms of the minute in progress
+} telemetry_t;
+
+// Receives every closed rollup (hourly = false: 1 minute, true: 1 hour)
+typedef void (*telem_emit_t)(telem_channel_t ch, bool hourly, const telem_rollup_t* r, void* ctx);
+
+void telemetry_init(telemetry_t* t, uint64_t now_ms);
+
+/**
+ * @brief Maps a sketch line ("TEMP_C:23.45") to a channel and parsed value.
+ * @return false if the line is not telemetry or the value is invalid.
+ */
+bool telemetry_parse_line(const char* line, telem_channel_t* ch, int32_t* value);
+
+/**
+ * @brief Adds a sample to the interval in progress (closes due intervals first).
+ */
+void telemetry_sample(telemetry_t* t, telem_channel_t ch, int32_t value, uint64_t now_ms,
+                      telem_emit_t emit, void* ctx);
+
+/**
+ * @brief Closes the intervals that ended by now_ms; call periodically.
+ */
+void telemetry_poll(telemetry_t* t, uint64_t now_ms, telem_emit_t emit, void* ctx);
+
+/**
+ * @brief Closed minute rollup, age 0 being the most recent.
+ * @return NULL if fewer than age+1 minutes are stored.
+ */
+const telem_rollup_t* telemetry_minute(const telemetry_t* t, telem_channel_t ch, uint8_t age);
+
+const char* telemetry_channel_str(telem_channel_t ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TELEMETRY_H__
@@ -4,6 +4,7 @@
 *******************************************************************************/
 
 // System and Hardware Includes
+#include <ctype.h>
 #include <stdio.h>
 #include <string.h>
 #include "pico/stdlib.h"
@@ -15,17 +16,31 @@
 
 // Includes the FatFs library
 #include "lib/FatFs_SPI/ff15/source/ff.h"
+#include "lib/FatFs_SPI/sd_driver/hw_config.h"
 
 // Include OLED display library
 #include "lib_ssd1306/ssd1306.h"
 #include "lib_ssd1306/ssd1306_fonts.h"
+#include "lib_ssd1306/ssd1306_bitmaps.h"
+#include "lib_ssd1306/ssd1306_widgets.h"
 
-// --- UART Configuration (Arduino Hub - Mapped to GPIO 0 & 1) ---
-// Note: Arduino Hub TX must be connected to Pico RX (GPIO 1), and vice-versa.
-#define UART_ID uart0
-#define BAUD_RATE 9600
-#define UART_TX_PIN 0
-#define UART_RX_PIN 1
+// Include wall-clock timestamp service and log formats
+#include "lib_logger/log_conf.h"
+#include "lib_logger/log_time.h"
+#include "lib_logger/log_binary.h"
+#include "lib_logger/log_rotate.h"
+#include "lib_logger/log_query.h"
+#include "lib_logger/log_fixed.h"
+
+// Include the negotiated serial link to the Arduino hub
+#include "lib_link/uart_link.h"
+
+// --- Access Control Includes ---
+#include "lib_access/uid_cache.h"
+#include "lib_access/door.h"
+
+// --- Telemetry Includes ---
+#include "lib_telemetry/telemetry.h"
 
 // --- I2C Configuration (OLED Display - I2C0 Mapped to GPIO 4 & 5) ---
 #define I2C_PORT i2c0
@@ -37,29 +52,90 @@
 #define LED_GREEN_PIN 11
 #define LED_BLUE_PIN 12
 
-// --- Authorized UIDs ---
-const char *AUTHORIZED_UIDS[] = {
+// Reads of the same UID closer together than this are collapsed into one decision
+#define UID_REPEAT_WINDOW_MS 3000
+
+// --- Authorized UIDs (per door) ---
+const char *const FRONT_AUTHORIZED_UIDS[] = {
     "224c8d04",
     "b4067e05",
 };
-const int NUM_AUTHORIZED_UIDS = 2;
+
+// --- Doors (one Arduino reader front-end each) ---
+// Note: each Arduino TX goes to the door's RX pin, and vice-versa.
+// Hardware UART links start at UART_LINK_BASE_BAUD (9600) and negotiate up to 500000 baud.
+// Free pins on the BitDogLab for more doors: uart1 on GPIO 8/9, PIO soft UARTs on GPIO 6/7, 14/15, 20/21...
+// A PIO door takes one state machine per direction (4 per PIO block); receive-only doors
+// (tx_pin = UART_LINK_NO_PIN) take one, so up to 8 of them fit besides uart0/uart1.
+const door_config_t DOOR_CONFIG[] = {
+    {
+        .policy = { "FRONT", FRONT_AUTHORIZED_UIDS, 2, UID_REPEAT_WINDOW_MS, 2000 },
+        .uart = uart0, .tx_pin = 0, .rx_pin = 1,
+    },
+    // { .policy = { "BACK", BACK_AUTHORIZED_UIDS, 1, UID_REPEAT_WINDOW_MS, 2000 },
+    //   .uart = uart1, .tx_pin = 8, .rx_pin = 9 },
+    // { .policy = { "GARAGE", GARAGE_AUTHORIZED_UIDS, 1, UID_REPEAT_WINDOW_MS, 2000 },
+    //   .pio = pio0, .tx_pin = UART_LINK_NO_PIN, .rx_pin = 6 },
+};
+#define NUM_DOORS (int)(sizeof(DOOR_CONFIG) / sizeof(DOOR_CONFIG[0]))
+
+// --- Display Pages ---
+// Out of every DISPLAY_CYCLE_MS the telemetry page is shown for the last DISPLAY_TELEMETRY_MS
+#define DISPLAY_CYCLE_MS 10000
+#define DISPLAY_TELEMETRY_MS 4000
 
 // --- Global Variables (for State Management) ---
 FATFS fs; 
 FIL fil;  
+door_t doors[NUM_DOORS]; // Door state: link, policy, recently decided UIDs (ids 1..NUM_DOORS)
+door_queue_t door_events; // Lines from all doors, in arrival order
+log_rotator_t log_rotator; // Open binary log segment (logs/YYYYMMDD-NNN.bin), recovered at mount
+uint64_t led_off_ms = 0; // When the current LED indication ends (0: none)
+telemetry_t door_telemetry[NUM_DOORS]; // TEMP_C/PRESS_HPA rollups per door
+int telemetry_door = -1; // Door shown on the telemetry page (latest sample), -1: none yet
 
 // Variables to hold the current status for the OLED
 char current_status[32] = "INITIALIZING...";
-char last_uid[16] = "NONE";
+char last_uid[32] = "NONE";
 char pir_current_state[32] = "NO MOTION"; // Tracks the PIR status for the display
+bool pir_motion = false; // Motion icon next to the PIR line
+
+// --- Display Widgets (redrawn and sent only when their value changes) ---
+SSD1306_Widget_t header_bar, uid_label, pir_label, motion_icon, status_label;
+SSD1306_Widget_t* const status_screen[] = { &header_bar, &uid_label, &pir_label, &motion_icon, &status_label };
+SSD1306_Widget_t temp_label, temp_sparkline, press_label, press_sparkline;
+SSD1306_Widget_t* const telemetry_screen[] = { &temp_label, &temp_sparkline, &press_label, &press_sparkline };
+SSD1306_Widget_t* const* shown_screen = NULL; // Screen currently on the OLED
+SSD1306_Scroller_t uid_scroller; // UID line too wide for the screen scrolls instead
+char uid_scroll_text[32] = "";
+#define UID_SCROLL_STEP_MS 40
+
+// Display refresh cost, for the "display" console command
+uint32_t display_frames = 0;
+uint64_t display_bytes = 0;
+uint64_t display_us = 0;
 
 // --- Function Prototypes ---
 void set_rgb_color(int r, int g, int b);
+void flash_rgb_color(int r, int g, int b, uint32_t ms);
 void initialize_sd();
-void log_event(const char* event_type, const char* message);
-void log_access_event(const char* uid, const char* status);
-void log_pir_event(const char* status);
+void log_event(const door_t* door, const char* event_type, const char* message);
+void log_text_line(const door_t* door, const char* event_type, const char* message);
+void log_binary_record(const door_t* door, log_record_t* rec);
+void log_access_event(const door_t* door, const char* uid, const char* status);
+void log_pir_event(const door_t* door, const char* status);
+void log_repeat_summary(const uid_cache_entry_t* entry, void* ctx);
+void log_telemetry_rollup(telem_channel_t ch, bool hourly, const telem_rollup_t* r, void* ctx);
+void handle_door_event(door_t* door, char* line);
+void display_init();
+void display_render(SSD1306_Widget_t* const* screen, uint8_t count, uint64_t start_us);
+void display_scroll(uint32_t now_ms);
 void display_status(); // New centralized display function
+void display_telemetry(const door_t* door, const telemetry_t* t);
+void handle_console_command(char* line);
+void spi_bench();
+bool parse_query_time(const char* token, uint64_t* epoch_ms);
+bool print_query_match(const log_record_t* rec, void* ctx);
 
 // --- Helper Functions ---
 
@@ -69,6 +145,12 @@ void set_rgb_color(int r, int g, int b) {
     gpio_put(LED_BLUE_PIN, b);
 }
 
+// Lights the LED for ms without blocking the loop (other doors keep being served)
+void flash_rgb_color(int r, int g, int b, uint32_t ms) {
+    set_rgb_color(r, g, b);
+    led_off_ms = to_ms_since_boot(get_absolute_time()) + ms;
+}
+
 void initialize_sd() {
     FRESULT fr = f_mount(&fs, "", 1);
     if (fr != FR_OK) {
@@ -78,70 +160,509 @@ void initialize_sd() {
     } else {
         printf("SD card mounted successfully.\n");
         strcpy(current_status, "SYSTEM READY");
+#if LOG_FORMAT & LOG_FORMAT_BINARY
+        fr = log_rotate_init(&log_rotator);
+        if (fr != FR_OK) {
+            printf("Failed to open log segments: %d\n", fr);
+        }
+#endif
     }
 }
 
-void log_event(const char* event_type, const char* message) {
-    FRESULT fr = f_open(&fil, "log.txt", FA_OPEN_APPEND | FA_WRITE);
+// door is NULL for events of the hub itself (door id 0 in the binary log)
+void log_event(const door_t* door, const char* event_type, const char* message) {
+#if LOG_FORMAT & LOG_FORMAT_TEXT
+    log_text_line(door, event_type, message);
+#endif
+#if LOG_FORMAT & LOG_FORMAT_BINARY
+    log_record_t rec = { .type = LOG_BIN_TEXT, .status = LOG_STATUS_NONE };
+    int n = snprintf((char*)rec.data, sizeof(rec.data), "%s: %s", event_type, message);
+    rec.len = n < (int)sizeof(rec.data) ? n : sizeof(rec.data) - 1;
+    log_binary_record(door, &rec);
+#endif
+}
+
+void log_text_line(const door_t* door, const char* event_type, const char* message) {
+    FRESULT fr = f_open(&fil, LOG_TEXT_FILE, FA_OPEN_APPEND | FA_WRITE);
     if (fr == FR_OK) {
-        uint64_t current_time_ms = to_ms_since_boot(get_absolute_time());
-        unsigned long minutes = current_time_ms / 60000;
-        unsigned long seconds = (current_time_ms / 1000) % 60;
+        // "YYYY-MM-DDTHH:MM:SS.mmm [DOOR] TYPE: message\n" assembled without f_printf
+        char line[LOG_TIME_ISO_LEN + DOOR_NAME_LEN + 96];
+        log_time_format_iso(line);
+        size_t len = LOG_TIME_ISO_LEN;
+        line[len++] = ' ';
+        if (door) {
+            size_t name_len = strlen(door->policy->name);
+            line[len++] = '[';
+            memcpy(&line[len], door->policy->name, name_len);
+            len += name_len;
+            line[len++] = ']';
+            line[len++] = ' ';
+        }
 
-        f_printf(&fil, "[%02lu:%02lu] %s: %s\n", 
-            minutes, seconds, event_type, message);
+        size_t type_len = strlen(event_type);
+        size_t msg_len = strlen(message);
+        if (len + type_len + 2 + msg_len + 1 > sizeof(line)) {
+            msg_len = sizeof(line) - len - type_len - 3;
+        }
+        memcpy(&line[len], event_type, type_len);
+        len += type_len;
+        line[len++] = ':';
+        line[len++] = ' ';
+        memcpy(&line[len], message, msg_len);
+        len += msg_len;
+        line[len++] = '\n';
+
+        UINT written;
+        f_write(&fil, line, len, &written);
         f_close(&fil);
     } else {
         printf("Failed to open file for writing: %d\n", fr);
     }
 }
 
-void log_access_event(const char* uid, const char* status) {
-    char access_str[50];
+void log_binary_record(const door_t* door, log_record_t* rec) {
+    rec->time_ms = log_time_epoch_ms();
+    rec->door = door ? door->id : 0;
+    FRESULT fr = log_rotate_append(&log_rotator, rec);
+    if (fr != FR_OK) {
+        printf("Failed to append binary log: %d\n", fr);
+    }
+}
+
+void log_access_event(const door_t* door, const char* uid, const char* status) {
+#if LOG_FORMAT & LOG_FORMAT_TEXT
+    char access_str[64];
     snprintf(access_str, sizeof(access_str), "UID=%s, Status=%s", uid, status);
-    log_event("RFID_ACCESS", access_str);
+    log_text_line(door, "RFID_ACCESS", access_str);
+#endif
+#if LOG_FORMAT & LOG_FORMAT_BINARY
+    log_record_t rec = {
+        .type = LOG_BIN_ACCESS,
+        .status = strcmp(status, "GRANTED") == 0 ? LOG_STATUS_GRANTED : LOG_STATUS_DENIED
+    };
+    rec.len = log_bin_uid_from_hex(uid, rec.data, 10);
+    if (rec.len == 0) {
+        // Not a hex UID: keep the raw text so nothing is lost
+        rec.type = LOG_BIN_TEXT;
+        int n = snprintf((char*)rec.data, sizeof(rec.data), "UID=%s, Status=%s", uid, status);
+        rec.len = n < (int)sizeof(rec.data) ? n : sizeof(rec.data) - 1;
+    }
+    log_binary_record(door, &rec);
+#endif
 }
 
-void log_pir_event(const char* status) {
-    log_event("PIR_STATUS", status);
+void log_pir_event(const door_t* door, const char* status) {
+#if LOG_FORMAT & LOG_FORMAT_TEXT
+    log_text_line(door, "PIR_STATUS", status);
+#endif
+#if LOG_FORMAT & LOG_FORMAT_BINARY
+    log_record_t rec = { .type = LOG_BIN_PIR, .status = log_bin_pir_status(status) };
+    if (rec.status == LOG_PIR_OTHER) {
+        rec.len = strnlen(status, sizeof(rec.data));
+        memcpy(rec.data, status, rec.len);
+    }
+    log_binary_record(door, &rec);
+#endif
+}
+
+// Called once a badge has left the reader: one line for all the reads collapsed into its decision
+void log_repeat_summary(const uid_cache_entry_t* entry, void* ctx) {
+    char summary[64];
+    snprintf(summary, sizeof(summary), "UID=%s, Status=%s, Repeats=%lu",
+             entry->uid, entry->granted ? "GRANTED" : "DENIED", (unsigned long)entry->repeats);
+    log_event((const door_t*)ctx, "RFID_REPEAT", summary);
+}
+
+// Called for every closed 1-minute/1-hour rollup: one compact record instead of 30 samples per minute
+void log_telemetry_rollup(telem_channel_t ch, bool hourly, const telem_rollup_t* r, void* ctx) {
+    const door_t* door = (const door_t*)ctx;
+#if LOG_FORMAT & LOG_FORMAT_TEXT
+    char min[LOG_FIXED_MAX_LEN], max[LOG_FIXED_MAX_LEN], mean[LOG_FIXED_MAX_LEN], rollup_str[80];
+    log_fixed_format(r->min, TELEM_DECIMALS, min);
+    log_fixed_format(r->max, TELEM_DECIMALS, max);
+    log_fixed_format(r->mean, TELEM_DECIMALS, mean);
+    snprintf(rollup_str, sizeof(rollup_str), "%s %s min=%s max=%s mean=%s n=%u",
+             telemetry_channel_str(ch), hourly ? "1h" : "1m", min, max, mean, r->count);
+    log_text_line(door, "TELEMETRY", rollup_str);
+#endif
+#if LOG_FORMAT & LOG_FORMAT_BINARY
+    log_record_t rec = { .type = LOG_BIN_TELEMETRY };
+    if (ch == TELEM_TEMP) {
+        rec.status = hourly ? LOG_TELEM_TEMP_1H : LOG_TELEM_TEMP_1M;
+    } else {
+        rec.status = hourly ? LOG_TELEM_PRESS_1H : LOG_TELEM_PRESS_1M;
+    }
+    log_bin_telemetry_pack(&rec, r->min, r->max, r->mean, r->count);
+    log_binary_record(door, &rec);
+#endif
+}
+
+// === OLED Display: retained widgets, partial redraw ===
+void display_init() {
+    // Status screen: one widget per text line, the motion icon right of the PIR line
+    ssd1306_WidgetStatusBar(&header_bar, 0, &Font_6x8);
+    ssd1306_WidgetLabel(&uid_label, 0, 16, SSD1306_WIDTH, &Font_6x8);
+    ssd1306_WidgetLabel(&pir_label, 0, 32, SSD1306_WIDTH - 10, &Font_6x8);
+    ssd1306_WidgetIcon(&motion_icon, SSD1306_WIDTH - 8, 32, motion_bitmap, 8, 8);
+    ssd1306_WidgetLabel(&status_label, 0, 48, SSD1306_WIDTH, &Font_6x8);
+
+    // Telemetry screen: latest value and last-hour sparkline per channel
+    ssd1306_WidgetLabel(&temp_label, 0, 0, SSD1306_WIDTH, &Font_6x8);
+    ssd1306_WidgetSparkline(&temp_sparkline, 0, 10, SSD1306_WIDTH, 20);
+    ssd1306_WidgetLabel(&press_label, 0, 32, SSD1306_WIDTH, &Font_6x8);
+    ssd1306_WidgetSparkline(&press_sparkline, 0, 42, SSD1306_WIDTH, 20);
+}
+
+// Sends the changed widgets of screen (the whole frame when switching screens)
+void display_render(SSD1306_Widget_t* const* screen, uint8_t count, uint64_t start_us) {
+    bool full = (shown_screen != screen);
+    shown_screen = screen;
+    size_t bytes = ssd1306_WidgetsRender(screen, count, full);
+    if (bytes > 0) {
+        display_frames++;
+        display_bytes += bytes;
+        display_us += time_us_64() - start_us;
+        if (screen == status_screen) {
+            ssd1306_ScrollerInvalidate(&uid_scroller); // Redraw over a cleared UID line
+        }
+    }
+}
+
+// Advances the scrolling UID line while the status screen is shown
+void display_scroll(uint32_t now_ms) {
+    if (shown_screen != status_screen) {
+        return;
+    }
+    uint64_t start_us = time_us_64();
+    size_t bytes = ssd1306_ScrollerPoll(&uid_scroller, now_ms);
+    if (bytes > 0) {
+        display_frames++;
+        display_bytes += bytes;
+        display_us += time_us_64() - start_us;
+    }
 }
 
-// === Function to update the OLED Display with detailed status ===
 void display_status() {
+    uint64_t start_us = time_us_64();
     char buffer[32];
-    ssd1306_Fill(Black);
-    
-    // Line 1: Header
-    ssd1306_SetCursor(0, 0);
-    ssd1306_WriteString("ACCESS MONITOR HUB", Font_6x8, White);
+
+    // Line 1: Header with the wall-clock time
+    char stamp[LOG_TIME_ISO_LEN + 1];
+    log_time_format_iso(stamp);
+    stamp[16] = '\0';
+    ssd1306_WidgetSetStatus(&header_bar, "ACCESS MONITOR", log_time_is_valid() ? &stamp[11] : "--:--");
 
     // Line 2: Last UID read
-    ssd1306_SetCursor(0, 16);
     snprintf(buffer, sizeof(buffer), "UID: %s", last_uid);
-    ssd1306_WriteString(buffer, Font_6x8, White);
+    if (ssd1306_TextWidth(buffer, Font_6x8) > uid_label.w) {
+        ssd1306_WidgetSetText(&uid_label, "");
+        if (!uid_scroller.running || strcmp(buffer, uid_scroll_text) != 0) {
+            strcpy(uid_scroll_text, buffer);
+            ssd1306_ScrollerStart(&uid_scroller, buffer, Font_6x8, White, uid_label.y, UID_SCROLL_STEP_MS,
+                                  to_ms_since_boot(get_absolute_time()));
+        }
+    } else {
+        ssd1306_ScrollerStop(&uid_scroller);
+        ssd1306_WidgetSetText(&uid_label, buffer);
+    }
 
     // Line 3: PIR State
-    ssd1306_SetCursor(0, 32);
     snprintf(buffer, sizeof(buffer), "PIR: %s", pir_current_state);
-    ssd1306_WriteString(buffer, Font_6x8, White);
-    
+    ssd1306_WidgetSetText(&pir_label, buffer);
+    ssd1306_WidgetSetVisible(&motion_icon, pir_motion);
+
     // Line 4: Main Access/System Status
-    ssd1306_SetCursor(0, 48);
-    // Use a larger or emphasized font for the main status if available, 
-    // but sticking to Font_6x8 for consistency with provided files.
-    ssd1306_WriteString(current_status, Font_6x8, White); 
+    ssd1306_WidgetSetText(&status_label, current_status);
 
-    ssd1306_UpdateScreen();
+    display_render(status_screen, count_of(status_screen), start_us);
+}
+
+// Latest reading and last-hour trend of each channel of one door
+void display_telemetry(const door_t* door, const telemetry_t* t) {
+    static SSD1306_Widget_t* const labels[TELEM_NUM_CHANNELS] = { &temp_label, &press_label };
+    static SSD1306_Widget_t* const sparklines[TELEM_NUM_CHANNELS] = { &temp_sparkline, &press_sparkline };
+    uint64_t start_us = time_us_64();
+    char buffer[32];
+
+    for (int ch = 0; ch < TELEM_NUM_CHANNELS; ch++) {
+        const telem_series_t* s = &t->series[ch];
+        char value[LOG_FIXED_MAX_LEN] = "--";
+        if (s->has_last) {
+            log_fixed_format(s->last, TELEM_DECIMALS, value);
+        }
+        if (ch == TELEM_TEMP) {
+            snprintf(buffer, sizeof(buffer), "%s T %s C", door->policy->name, value);
+        } else {
+            snprintf(buffer, sizeof(buffer), "P %s hPa", value);
+        }
+        ssd1306_WidgetSetText(labels[ch], buffer);
+
+        // Minute means, oldest on the left; minutes without samples break the line
+        int32_t points[TELEM_MINUTES];
+        uint8_t count = 0;
+        for (int age = TELEM_MINUTES - 1; age >= 0; age--) {
+            const telem_rollup_t* r = telemetry_minute(t, (telem_channel_t)ch, age);
+            if (r != NULL) {
+                points[count++] = r->count > 0 ? r->mean : SSD1306_SPARKLINE_GAP;
+            }
+        }
+        ssd1306_WidgetSetPoints(sparklines[ch], points, count);
+    }
+
+    display_render(telemetry_screen, count_of(telemetry_screen), start_us);
+}
+
+// === Query helpers for the "log" console command ===
+bool parse_query_time(const char* token, uint64_t* epoch_ms) {
+    if (log_time_parse_iso(token, epoch_ms)) {
+        return true;
+    }
+    // "HH:MM" is taken as today (UTC)
+    if (strlen(token) == 5 && isdigit((unsigned char)token[0]) && isdigit((unsigned char)token[1]) &&
+        token[2] == ':' && isdigit((unsigned char)token[3]) && isdigit((unsigned char)token[4])) {
+        int hour = (token[0] - '0') * 10 + (token[1] - '0');
+        int min = (token[3] - '0') * 10 + (token[4] - '0');
+        if (hour > 23 || min > 59) {
+            return false;
+        }
+        uint64_t today = log_time_epoch_ms() / 86400000u * 86400000u;
+        *epoch_ms = today + hour * 3600000u + min * 60000u;
+        return true;
+    }
+    return false;
+}
+
+bool print_query_match(const log_record_t* rec, void* ctx) {
+    char stamp[LOG_TIME_ISO_LEN + 1];
+    char data[2 * LOG_BIN_MAX_DATA + 1];
+    log_time_format_epoch(rec->time_ms, stamp);
+    stamp[LOG_TIME_ISO_LEN] = '\0';
+    int32_t min, max, mean;
+    uint16_t count;
+    if (rec->type == LOG_BIN_ACCESS) {
+        log_bin_uid_to_hex(rec->data, rec->len, data);
+    } else if (rec->type == LOG_BIN_TELEMETRY && log_bin_telemetry_unpack(rec, &min, &max, &mean, &count)) {
+        char min_str[LOG_FIXED_MAX_LEN], max_str[LOG_FIXED_MAX_LEN], mean_str[LOG_FIXED_MAX_LEN];
+        log_fixed_format(min, TELEM_DECIMALS, min_str);
+        log_fixed_format(max, TELEM_DECIMALS, max_str);
+        log_fixed_format(mean, TELEM_DECIMALS, mean_str);
+        snprintf(data, sizeof(data), "min=%s max=%s mean=%s n=%u", min_str, max_str, mean_str, count);
+    } else {
+        memcpy(data, rec->data, rec->len);
+        data[rec->len] = '\0';
+    }
+    const char* door = rec->door == 0 ? "HUB" : rec->door <= NUM_DOORS ? doors[rec->door - 1].policy->name : "?";
+    printf("%s %s %s %s %s\n", stamp, door, log_bin_type_str(rec->type), log_bin_status_str(rec->status), data);
+    return true;
+}
+
+// === Lines received from a door's Arduino front-end ===
+void handle_door_event(door_t* door, char* line) {
+    const char* name = door->policy->name;
+
+    // 1. Check for PIR status
+    if (strstr(line, "PIR_STATUS:") != NULL) {
+        
+        char *status_message = line + strlen("PIR_STATUS:");
+        printf("[%s] Received PIR Status: %s\n", name, status_message);
+        log_pir_event(door, status_message);
+        
+        // Update PIR display status (e.g., ACTIVATED, SLEEP)
+        if (strstr(status_message, "ACTIVATED") != NULL) {
+           snprintf(pir_current_state, sizeof(pir_current_state), "%s ACTIVE", name);
+           pir_motion = true;
+           strcpy(current_status, "Awaiting Tag");
+        } else if (strstr(status_message, "SLEEP") != NULL) {
+           snprintf(pir_current_state, sizeof(pir_current_state), "%s IDLE", name);
+           pir_motion = false;
+           strcpy(current_status, "Awaiting Motion");
+        } else {
+           snprintf(pir_current_state, sizeof(pir_current_state), "%s %s", name, status_message);
+        }
+        
+        // Flash blue for PIR detection (unless a decision is being shown)
+        if (led_off_ms == 0) {
+            flash_rgb_color(0, 0, 1, 50);
+        }
+        
+    } 
+    // 2. Check for RFID UID
+    else if (strstr(line, "RFID_UID:") != NULL) {
+        
+        char *uid_str = line + strlen("RFID_UID:");
+        uint64_t now_ms = to_ms_since_boot(get_absolute_time());
+
+        // A badge resting on the reader keeps the decision it already got
+        uid_cache_entry_t *seen = uid_cache_lookup(&door->recent, uid_str, now_ms);
+        if (seen != NULL) {
+            printf("[%s] Repeat read of %s ignored (x%lu)\n", name, uid_str, (unsigned long)seen->repeats);
+            return;
+        }
+        printf("[%s] Received UID: %s\n", name, uid_str);
+        
+        // Update last UID globally
+        snprintf(last_uid, sizeof(last_uid), "%s %s", name, uid_str);
+        
+        bool access_granted = door_authorized(door, uid_str);
+        if (access_granted) {
+            printf("[%s] Access Granted!\n", name);
+            log_access_event(door, uid_str, "GRANTED"); 
+            snprintf(current_status, sizeof(current_status), "%s: GRANTED", name);
+            flash_rgb_color(0, 1, 0, door->policy->hold_ms); // Green
+        } else {
+            printf("[%s] Access Denied!\n", name);
+            log_access_event(door, uid_str, "DENIED"); 
+            snprintf(current_status, sizeof(current_status), "%s: DENIED", name);
+            flash_rgb_color(1, 0, 0, door->policy->hold_ms); // Red
+        }
+        // The window starts after the LED hold so reads during the indication count as repeats
+        uid_cache_insert(&door->recent, uid_str, access_granted, now_ms + door->policy->hold_ms,
+                         log_repeat_summary, door);
+    }
+    // 3. Environmental telemetry (TEMP_C / PRESS_HPA): folded into rollups, not logged per sample
+    else {
+        telem_channel_t ch;
+        int32_t value;
+        if (telemetry_parse_line(line, &ch, &value)) {
+            telemetry_sample(&door_telemetry[door->id - 1], ch, value, log_time_epoch_ms(),
+                             log_telemetry_rollup, door);
+            telemetry_door = door->id - 1;
+        }
+    }
+}
+
+// === Commands typed on the USB console ===
+
+// Time per call of the SPI DMA paths the SD driver uses, on the card's bus with
+// the card deselected: a 1-byte transfer (nearly all setup), and the token,
+// data, CRC and response of a block write as 4 transfers and as one chain
+void spi_bench() {
+    enum { RUNS = 1000 };
+    static uint8_t block[512];
+    uint8_t token = 0xFE, crc[2] = {0xFF, 0xFF}, response;
+    const spi_seg_t segs[] = {
+        {&token, NULL, 1}, {block, NULL, sizeof(block)}, {crc, NULL, sizeof(crc)}, {NULL, &response, 1},
+    };
+    spi_t* spi = spi_get_by_num(0);
+    if (!spi || !spi->initialized) {
+        printf("SPI: not initialized\n");
+        return;
+    }
+    uint64_t t[4];
+    spi_lock(spi);
+    t[0] = time_us_64();
+    for (int i = 0; i < RUNS; i++) spi_transfer(spi, &token, &response, 1);
+    t[1] = time_us_64();
+    for (int i = 0; i < RUNS; i++) {
+        for (size_t s = 0; s < count_of(segs); s++) spi_transfer(spi, segs[s].tx, segs[s].rx, segs[s].length);
+    }
+    t[2] = time_us_64();
+    for (int i = 0; i < RUNS; i++) spi_transfer_chain(spi, segs, count_of(segs));
+    t[3] = time_us_64();
+    spi_unlock(spi);
+    printf("SPI: %lu Hz, 1 byte %lu ns, block write as %u transfers %lu ns, as one %s %lu ns\n",
+           (unsigned long)spi_get_baudrate(spi->hw_inst), (unsigned long)((t[1] - t[0]) * 1000 / RUNS),
+           (unsigned)count_of(segs), (unsigned long)((t[2] - t[1]) * 1000 / RUNS),
+           spi->chain_dma ? "chain" : "chain (no free DMA channels: sequential)",
+           (unsigned long)((t[3] - t[2]) * 1000 / RUNS));
+}
+
+void handle_console_command(char* line) {
+    if (strncmp(line, "time ", 5) == 0) {
+        // time YYYY-MM-DD HH:MM:SS -> sets the RTC used for log timestamps
+        if (log_time_set_iso(line + 5)) {
+            printf("Clock set.\n");
+        } else {
+            printf("Usage: time YYYY-MM-DD HH:MM:SS\n");
+        }
+    } else if (strcmp(line, "time") == 0) {
+        char stamp[LOG_TIME_ISO_LEN + 1];
+        log_time_format_iso(stamp);
+        stamp[LOG_TIME_ISO_LEN] = '\0';
+        printf("%s%s\n", stamp, log_time_is_valid() ? "" : " (clock not set)");
+    } else if (strcmp(line, "link") == 0) {
+        for (int i = 0; i < NUM_DOORS; i++) {
+            const uart_link_t* l = &doors[i].link;
+            printf("Door %d %s (%s): %lu baud, state %d, %lu bytes, %lu framing, %lu parity, %lu break, %lu overrun, "
+                   "%lu ring overflows, %lu fallbacks, %lu lines, %lu dropped\n",
+                   doors[i].id, doors[i].policy->name, l->uart ? "uart" : "pio",
+                   (unsigned long)l->baud, l->state, (unsigned long)l->rx_bytes,
+                   (unsigned long)l->framing_errors, (unsigned long)l->parity_errors,
+                   (unsigned long)l->break_errors, (unsigned long)l->overrun_errors,
+                   (unsigned long)l->ring_overflows, (unsigned long)l->fallbacks,
+                   (unsigned long)doors[i].lines, (unsigned long)doors[i].dropped);
+        }
+        printf("Event queue: %u/%d peak, %lu us longest wait\n", door_events.high_water, DOOR_QUEUE_LEN,
+               (unsigned long)door_events.max_wait_us);
+    } else if (strcmp(line, "display") == 0) {
+        // Average cost of the display refreshes that sent something, against
+        // resending the whole frame now (what every refresh did before widgets)
+        uint32_t full_bytes = ssd1306_BusBytes();
+        uint64_t full_us = time_us_64();
+        ssd1306_UpdateScreen();
+        full_us = time_us_64() - full_us;
+        full_bytes = ssd1306_BusBytes() - full_bytes;
+        if (display_frames > 0) {
+            printf("Display: %lu refreshes, %lu bytes and %lu us per refresh (full frame: %lu bytes, %lu us)\n",
+                   (unsigned long)display_frames, (unsigned long)(display_bytes / display_frames),
+                   (unsigned long)(display_us / display_frames), (unsigned long)full_bytes,
+                   (unsigned long)full_us);
+        } else {
+            printf("Display: no refresh yet (full frame: %lu bytes, %lu us)\n", (unsigned long)full_bytes,
+                   (unsigned long)full_us);
+        }
+    } else if (strcmp(line, "spi") == 0) {
+        spi_bench();
+    } else if (strncmp(line, "log ", 4) == 0) {
+        // log FROM TO [UID|access] [DOOR...] -> streams matching binary log records
+        char* from = strtok(line + 4, " ");
+        char* to = strtok(NULL, " ");
+        log_query_t query = {0};
+        if (!from || !to || !parse_query_time(from, &query.from_ms) ||
+            !parse_query_time(to, &query.to_ms)) {
+            printf("Usage: log FROM TO [UID|access] [DOOR...]  (FROM/TO: YYYY-MM-DDTHH:MM:SS or HH:MM today)\n");
+            return;
+        }
+        for (char* filter = strtok(NULL, " "); filter; filter = strtok(NULL, " ")) {
+            int door = -1;
+            for (int i = 0; i < NUM_DOORS; i++) {
+                if (strcmp(filter, doors[i].policy->name) == 0) door = doors[i].id;
+            }
+            if (door >= 0) {
+                query.doors |= 1u << door;
+            } else if (strcmp(filter, "access") == 0) {
+                query.access_only = true;
+            } else {
+                query.uid_len = log_bin_uid_from_hex(filter, query.uid, sizeof(query.uid));
+                if (query.uid_len == 0) {
+                    printf("Invalid UID or door: %s\n", filter);
+                    return;
+                }
+            }
+        }
+        log_query_stats_t stats;
+        uint64_t start_us = time_us_64();
+        FRESULT fr = log_query_run(&query, &log_rotator, print_query_match, NULL, &stats);
+        printf("%lu matches (%lu records decoded, %lu block probes, %lu segments, %lu bytes read) in %lu ms, result %d\n",
+               (unsigned long)stats.matches, (unsigned long)stats.records, (unsigned long)stats.seeks,
+               (unsigned long)stats.segments, (unsigned long)stats.bytes_read,
+               (unsigned long)((time_us_64() - start_us) / 1000), fr);
+    } else if (line[0] != '\0') {
+        printf("Unknown command: %s\n", line);
+    }
 }
 
 
 int main() {
     stdio_init_all();
 
-    // --- UART Initialization (GPIO 0 & 1) ---
-    uart_init(UART_ID, BAUD_RATE);
-    gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
-    gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
+    // --- Door Links Initialization (hardware UARTs and PIO soft UARTs) ---
+    door_queue_init(&door_events);
+    for (int i = 0; i < NUM_DOORS; i++) {
+        if (!door_init(&doors[i], i + 1, &DOOR_CONFIG[i])) {
+            printf("Door %s: no free PIO state machine for its link.\n", DOOR_CONFIG[i].policy.name);
+        }
+    }
 
     // --- I2C Initialization for OLED (I2C0, GP4/GP5) ---
     i2c_init(I2C_PORT, 100 * 1000); 
@@ -161,103 +682,89 @@ int main() {
     gpio_set_dir(LED_GREEN_PIN, GPIO_OUT);
     gpio_set_dir(LED_BLUE_PIN, GPIO_OUT);
     
+    // --- RTC / Timestamp Initialization ---
+    log_time_init();
+
     // --- SD Card Initialization ---
     initialize_sd();
 
-    printf("BitDogLab: System initialized. Waiting for Arduino data on GPIO 0/1...\n");
+    // --- Telemetry Rollups (aligned to wall-clock minutes) ---
+    for (int i = 0; i < NUM_DOORS; i++) {
+        telemetry_init(&door_telemetry[i], log_time_epoch_ms());
+    }
+
+    printf("BitDogLab: System initialized. Waiting for Arduino data on %d door link(s)...\n", NUM_DOORS);
     
-    char buffer[50];
-    int idx = 0;
+    char console_line[80];
+    int console_idx = 0;
 
     // Initial display update
+    display_init();
     display_status();
 
 
     while (1) {
         
-        // Check data from UART
-        if (uart_is_readable(UART_ID)) {
-            char c = uart_getc(UART_ID);
-            
-            if (c == '\n' || c == '\r') {
-                buffer[idx] = '\0';
-                
-                if (idx > 0) {
-                    
-                    // 1. Check for PIR status
-                    if (strstr(buffer, "PIR_STATUS:") != NULL) {
-                        
-                        char *status_message = buffer + strlen("PIR_STATUS:");
-                        printf("Received PIR Status: %s\n", status_message);
-                        log_pir_event(status_message);
-                        
-                        // Update PIR display status (e.g., ACTIVATED, SLEEP)
-                        if (strstr(status_message, "ACTIVATED") != NULL) {
-                           strcpy(pir_current_state, "ACTIVE");
-                           strcpy(current_status, "Awaiting Tag");
-                        } else if (strstr(status_message, "SLEEP") != NULL) {
-                           strcpy(pir_current_state, "IDLE");
-                           strcpy(current_status, "Awaiting Motion");
-                        } else {
-                           strcpy(pir_current_state, status_message);
-                        }
-                        
-                        // Flash blue for PIR detection
-                        set_rgb_color(0, 0, 1);
-                        sleep_ms(50);
-                        set_rgb_color(0, 0, 0); 
-                        
-                    } 
-                    // 2. Check for RFID UID
-                    else if (strstr(buffer, "RFID_UID:") != NULL) {
-                        
-                        char *uid_str = buffer + strlen("RFID_UID:");
-                        printf("Received UID: %s\n", uid_str);
-                        
-                        // Update last UID globally
-                        strncpy(last_uid, uid_str, sizeof(last_uid) - 1);
-                        last_uid[sizeof(last_uid) - 1] = '\0';
-                        
-                        int access_granted = 0;
-                        for (int i = 0; i < NUM_AUTHORIZED_UIDS; i++) {
-                            if (strcmp(uid_str, AUTHORIZED_UIDS[i]) == 0) {
-                                access_granted = 1;
-                                break;
-                            }
-                        }
-                        
-                        if (access_granted) {
-                            printf("Access Granted!\n");
-                            log_access_event(uid_str, "GRANTED"); 
-                            strcpy(current_status, "ACCESS GRANTED"); 
-                            set_rgb_color(0, 1, 0); // Green
-                            sleep_ms(2000);
-                            set_rgb_color(0, 0, 0); 
-                        } else {
-                            printf("Access Denied!\n");
-                            log_access_event(uid_str, "DENIED"); 
-                            strcpy(current_status, "ACCESS DENIED"); 
-                            set_rgb_color(1, 0, 0); // Red
-                            sleep_ms(2000);
-                            set_rgb_color(0, 0, 0); 
-                        }
-                    }
-                }
-                idx = 0;
-            } else {
-                if (idx < 49) {
-                    buffer[idx++] = c;
-                }
+        // Move complete lines from every door link into the shared queue
+        for (int i = 0; i < NUM_DOORS; i++) {
+            door_poll(&doors[i], &door_events);
+        }
+
+        // Handle queued door events in arrival order
+        door_event_t event;
+        while (door_queue_pop(&door_events, &event)) {
+            handle_door_event(&doors[event.door - 1], event.line);
+        }
+
+        // Log the repeat count of badges whose window has expired
+        uint64_t now_ms = to_ms_since_boot(get_absolute_time());
+        for (int i = 0; i < NUM_DOORS; i++) {
+            uid_cache_sweep(&doors[i].recent, now_ms, log_repeat_summary, &doors[i]);
+        }
+
+        // Close telemetry rollups at minute/hour boundaries even when samples stop
+        if (telemetry_door >= 0) {
+            for (int i = 0; i < NUM_DOORS; i++) {
+                telemetry_poll(&door_telemetry[i], log_time_epoch_ms(), log_telemetry_rollup, &doors[i]);
+            }
+        }
+
+        // End of a decision/PIR LED indication
+        if (led_off_ms != 0 && now_ms >= led_off_ms) {
+            set_rgb_color(0, 0, 0);
+            led_off_ms = 0;
+        }
+
+        // Check commands from the USB console (stdio is not on uart0, the Arduino link)
+        int ch = getchar_timeout_us(0);
+        if (ch != PICO_ERROR_TIMEOUT) {
+            if (ch == '\n' || ch == '\r') {
+                console_line[console_idx] = '\0';
+                handle_console_command(console_line);
+                console_idx = 0;
+            } else if (console_idx < (int)sizeof(console_line) - 1) {
+                console_line[console_idx++] = (char)ch;
             }
         }
 
+#if LOG_FORMAT & LOG_FORMAT_BINARY
+        // Write batched log records once they are LOG_BATCH_MAX_MS old
+        log_rotate_poll(&log_rotator, log_time_epoch_ms());
+#endif
+
         // Update display periodically (e.g., every 250ms)
         static uint64_t last_display_update = 0;
-        uint64_t current_time_ms = to_ms_since_boot(get_absolute_time());
-        if (current_time_ms - last_display_update > 250) {
-            display_status();
-            last_display_update = current_time_ms;
+        if (now_ms - last_display_update > 250) {
+            // Telemetry page only once there is telemetry, and never over an access decision
+            if (telemetry_door >= 0 && led_off_ms == 0 &&
+                now_ms % DISPLAY_CYCLE_MS >= DISPLAY_CYCLE_MS - DISPLAY_TELEMETRY_MS) {
+                display_telemetry(&doors[telemetry_door], &door_telemetry[telemetry_door]);
+            } else {
+                display_status();
+            }
+            last_display_update = now_ms;
         }
+        display_scroll(now_ms);
 
         sleep_ms(1); 
     }
@@ -0,0 +1,17 @@
+#!/bin/sh
+# Builds the door scaling benchmark with the door sources: tools/door_bench/build.sh [out]
+# The Pico SDK headers door.c and uart_link.h include all map to pico_host.h.
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$HERE/../..
+OUT=${1:-$HERE/door_bench}
+INC=$(mktemp -d)
+trap 'rm -rf "$INC"' EXIT
+
+mkdir -p "$INC/hardware" "$INC/pico"
+for h in hardware/pio.h hardware/uart.h pico/stdlib.h; do
+    echo '#include "pico_host.h"' > "$INC/$h"
+done
+
+${CC:-cc} -O2 -g -Wall $CFLAGS -I"$INC" -I"$HERE" -I"$ROOT/lib_link" -I"$ROOT/lib_access" \
+    -o "$OUT" "$HERE/door_bench.c" "$ROOT/lib_access/door.c" "$ROOT/lib_access/uid_cache.c"
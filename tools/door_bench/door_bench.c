@@ -0,0 +1,211 @@
+/*******************************************************************************
+ door_bench - Throughput and latency of the door event path as doors scale 1-8
+ Build: tools/door_bench/build.sh   (compiles door.c and uid_cache.c with it)
+ Usage: door_bench [baud] [handler_us] [seconds]   (default: 115200 2000 60)
+
+ Runs the main loop's door path of main.c (door_poll() on every door, then
+ door_queue_pop() and one handler per event) against N simulated Arduino
+ readers, N = 1..8, in virtual time. Each reader sends "RFID_UID:<8 hex>\r\n"
+ lines at `baud`; the bytes land in the link ring buffer at their arrival
+ time, as the RX interrupt puts them there. Two loads are run:
+   1/s   - one badge per second per door, at a random phase
+   flood - lines back to back on every link (worst case)
+ The CPU costs are a model, not measurements: handler_us per event (SD log
+ append, LED, display), 2 us per door_poll() call plus 0.2 us per byte, and
+ 20 us for the rest of a loop iteration. The links are stubs below: no
+ negotiation, and uart_link_getc() is the ring read of uart_link.c.
+ For each run it prints lines handled per second, the delay from a line's
+ CR to its handler (mean and max), the queue high water and longest
+ queue wait (door_queue_t), and lines lost (queue full, or cut by bytes
+ dropped on a full ring buffer).
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "door.h"
+
+#define LINE_LEN 19 // "RFID_UID:" + 8 hex + CRLF
+#define SEQS 4096   // Line numbers remembered per door for the latency
+
+uint64_t host_us;
+
+// The link as the main loop sees it: no hardware, no negotiation
+void uart_link_init(uart_link_t* l, uart_inst_t* uart, uint32_t tx_pin, uint32_t rx_pin) {
+    (void)tx_pin;
+    (void)rx_pin;
+    memset(l, 0, sizeof(*l));
+    l->uart = uart;
+    l->baud = UART_LINK_BASE_BAUD;
+}
+
+bool uart_link_init_pio(uart_link_t* l, PIO pio, uint32_t tx_pin, uint32_t rx_pin) {
+    uart_link_init(l, NULL, tx_pin, rx_pin);
+    l->pio = pio;
+    return true;
+}
+
+// Same ring read as uart_link.c; the simulation plays the RX interrupt
+bool uart_link_getc(uart_link_t* l, char* c) {
+    uint16_t tail = l->rx_tail;
+    if (tail == l->rx_head) {
+        return false;
+    }
+    *c = (char)l->rx_ring[tail & (UART_LINK_RING_SIZE - 1)];
+    l->rx_tail = tail + 1;
+    return true;
+}
+
+bool uart_link_handle_line(uart_link_t* l, const char* line) {
+    (void)l;
+    (void)line;
+    return false;
+}
+
+void uart_link_poll(uart_link_t* l) {
+    (void)l;
+}
+
+typedef struct {
+    char frame[LINE_LEN + 1];
+    uint32_t seq;            // Line being sent
+    uint8_t pos;             // Next byte of frame
+    uint64_t next_us;        // Arrival time of that byte
+    uint64_t done_us[SEQS];  // Arrival of the CR ending each line
+} reader_t;
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd(uint32_t n) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng % n);
+}
+
+static door_t doors[DOOR_MAX];
+static reader_t readers[DOOR_MAX];
+static const door_config_t config = {
+    .policy = {.name = "DOOR", .repeat_window_ms = 3000, .hold_ms = 1500},
+    .tx_pin = UART_LINK_NO_PIN,
+};
+
+typedef struct {
+    uint32_t sent, handled;
+    uint64_t latency_sum, latency_max;
+} result_t;
+
+static void start_line(reader_t* r, int door, uint64_t at_us) {
+    snprintf(r->frame, sizeof(r->frame), "RFID_UID:%02x%06x\r\n", door, (unsigned)(r->seq & 0xFFFFFF));
+    r->pos = 0;
+    r->next_us = at_us;
+}
+
+// Puts every byte that has arrived by now into its link ring (the RX interrupt)
+static void deliver(int n, uint32_t byte_us, uint32_t period_us, result_t* res) {
+    for (int i = 0; i < n; i++) {
+        reader_t* r = &readers[i];
+        uart_link_t* l = &doors[i].link;
+        while (r->next_us <= host_us) {
+            if ((uint16_t)(l->rx_head - l->rx_tail) >= UART_LINK_RING_SIZE) {
+                l->ring_overflows++;
+            } else {
+                l->rx_ring[l->rx_head & (UART_LINK_RING_SIZE - 1)] = (uint8_t)r->frame[r->pos];
+                l->rx_head++;
+            }
+            if (r->pos == LINE_LEN - 2) {
+                r->done_us[r->seq % SEQS] = r->next_us; // door_poll() ends the line at CR
+            }
+            r->next_us += byte_us;
+            if (++r->pos == LINE_LEN) {
+                res->sent++;
+                r->seq++;
+                // Flood: the next line follows at once; 1/s: next second, random phase
+                uint64_t next = period_us ? (r->next_us / period_us + 1) * period_us + rnd(period_us / 2)
+                                          : r->next_us;
+                start_line(r, i, next);
+            }
+        }
+    }
+}
+
+static uint64_t next_arrival(int n) {
+    uint64_t t = UINT64_MAX;
+    for (int i = 0; i < n; i++) {
+        if (readers[i].next_us < t) t = readers[i].next_us;
+    }
+    return t;
+}
+
+static result_t run(int n, uint32_t baud, uint32_t handler_us, uint32_t seconds, uint32_t period_us,
+                    door_queue_t* q) {
+    result_t res = {0};
+    uint32_t byte_us = (10000000u + baud - 1) / baud; // 8n1
+    host_us = 0;
+    door_queue_init(q);
+    for (int i = 0; i < n; i++) {
+        door_init(&doors[i], (uint8_t)(i + 1), &config);
+        memset(&readers[i], 0, sizeof(readers[i]));
+        start_line(&readers[i], i, period_us ? rnd(period_us) : rnd(LINE_LEN * byte_us));
+    }
+
+    uint64_t end_us = (uint64_t)seconds * 1000000u;
+    while (host_us < end_us) {
+        bool busy = false;
+        for (int i = 0; i < n; i++) {
+            deliver(n, byte_us, period_us, &res);
+            uint16_t tail = doors[i].link.rx_tail;
+            door_poll(&doors[i], q);
+            uint16_t taken = (uint16_t)(doors[i].link.rx_tail - tail);
+            host_us += 2 + taken / 5; // 2 us per call, 0.2 us per byte
+            busy |= taken > 0;
+        }
+        door_event_t ev;
+        while (door_queue_pop(q, &ev)) {
+            unsigned door, seq;
+            // Lines cut by lost bytes are not counted
+            if (strlen(ev.line) == LINE_LEN - 2 && sscanf(ev.line, "RFID_UID:%2x%6x", &door, &seq) == 2 &&
+                door < (unsigned)n) {
+                uint64_t latency = host_us - readers[door].done_us[seq % SEQS];
+                res.latency_sum += latency;
+                if (latency > res.latency_max) res.latency_max = latency;
+                res.handled++;
+            }
+            host_us += handler_us;
+            deliver(n, byte_us, period_us, &res);
+            busy = true;
+        }
+        host_us += 20;
+        if (!busy) {
+            uint64_t t = next_arrival(n); // Idle: skip to the next byte
+            if (t > host_us) host_us = t;
+        }
+    }
+    return res;
+}
+
+int main(int argc, char** argv) {
+    uint32_t baud = argc > 1 ? (uint32_t)atoi(argv[1]) : 115200;
+    uint32_t handler_us = argc > 2 ? (uint32_t)atoi(argv[2]) : 2000;
+    uint32_t seconds = argc > 3 ? (uint32_t)atoi(argv[3]) : 60;
+    static door_queue_t q;
+    printf("%lu baud, %lu us per event, %lu s per run\n", (unsigned long)baud, (unsigned long)handler_us,
+           (unsigned long)seconds);
+    printf("load  doors  lines/s  delay mean/max ms  queue peak  max wait ms  queue drops  lines lost\n");
+    static const struct {
+        const char* name;
+        uint32_t period_us;
+    } loads[] = {{"1/s", 1000000}, {"flood", 0}};
+    for (size_t k = 0; k < sizeof(loads) / sizeof(loads[0]); k++) {
+        for (int n = 1; n <= DOOR_MAX; n++) {
+            result_t r = run(n, baud, handler_us, seconds, loads[k].period_us, &q);
+            uint32_t drops = 0;
+            for (int i = 0; i < n; i++) drops += doors[i].dropped;
+            printf("%-5s %5d %8.1f %8.2f /%7.2f %11u %12.2f %12lu %11lu\n", loads[k].name, n,
+                   (double)r.handled / seconds, r.handled ? (double)r.latency_sum / r.handled / 1000 : 0.0,
+                   (double)r.latency_max / 1000, q.high_water, q.max_wait_us / 1000.0,
+                   (unsigned long)drops, (unsigned long)(r.sent - r.handled));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+/* pico_host.h
+Just enough of the Pico SDK to build door.c and uid_cache.c on a host (see
+door_bench.c). Time is virtual: it only moves when door_bench.c advances it.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef struct uart_inst uart_inst_t;
+typedef struct pio_hw pio_hw_t;
+typedef pio_hw_t *PIO;
+
+extern uint64_t host_us;
+static inline uint32_t time_us_32(void) { return (uint32_t)host_us; }
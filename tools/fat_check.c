@@ -0,0 +1,131 @@
+/*******************************************************************************
+ fat_check - Host tool that checks that both FATs of a FAT12/16/32 card image match
+ Build: cc -O2 -o fat_check fat_check.c
+ Usage: fat_check [--repair] card.img
+        The image may be a whole card (first MBR partition is used) or one volume.
+        With --repair, 1st FAT sectors that differ are copied over the 2nd FAT.
+ Exit:  0 both FATs match (or were repaired), 1 they differ, 2 not a FAT image
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t base;      // Volume offset in the image (bytes)
+    uint32_t ss;        // Bytes per sector
+    uint32_t reserved;  // Reserved sectors before the 1st FAT
+    uint32_t n_fats;
+    uint32_t fsize;     // Sectors per FAT
+} fat_volume_t;
+
+static uint16_t ld16(const uint8_t* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t ld32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+
+static int read_at(FILE* f, uint64_t ofs, void* buf, size_t len) {
+    return fseeko(f, (off_t)ofs, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+}
+
+static int write_at(FILE* f, uint64_t ofs, const void* buf, size_t len) {
+    return fseeko(f, (off_t)ofs, SEEK_SET) == 0 && fwrite(buf, 1, len, f) == len;
+}
+
+// Parses the boot sector at base; 0 if it is not a FAT12/16/32 volume
+static int parse_vbr(const uint8_t* s, uint64_t base, fat_volume_t* v) {
+    if (ld16(s + 510) != 0xAA55 || (s[0] != 0xEB && s[0] != 0xE9)) return 0;
+    v->base = base;
+    v->ss = ld16(s + 11);
+    v->reserved = ld16(s + 14);
+    v->n_fats = s[16];
+    v->fsize = ld16(s + 22) ? ld16(s + 22) : ld32(s + 36);
+    if (v->ss < 512 || v->ss > 4096 || (v->ss & (v->ss - 1)) || s[13] == 0 ||
+        v->reserved == 0 || v->n_fats == 0 || v->fsize == 0) {
+        return 0;
+    }
+    return 1;
+}
+
+static int find_volume(FILE* f, fat_volume_t* v) {
+    uint8_t s[512];
+    if (!read_at(f, 0, s, sizeof(s))) return 0;
+    if (parse_vbr(s, 0, v)) return 1;
+    if (ld16(s + 510) != 0xAA55) return 0;
+    uint64_t base = (uint64_t)ld32(s + 446 + 8) * 512; // 1st MBR partition
+    return base != 0 && read_at(f, base, s, sizeof(s)) && parse_vbr(s, base, v);
+}
+
+int main(int argc, char** argv) {
+    int repair = 0;
+    int argi = 1;
+    if (argi < argc && strcmp(argv[argi], "--repair") == 0) {
+        repair = 1;
+        argi++;
+    }
+    if (argi + 1 != argc) {
+        fprintf(stderr, "Usage: %s [--repair] card.img\n", argv[0]);
+        return 2;
+    }
+
+    FILE* f = fopen(argv[argi], repair ? "r+b" : "rb");
+    if (!f) {
+        perror(argv[argi]);
+        return 2;
+    }
+    fat_volume_t v;
+    if (!find_volume(f, &v)) {
+        fprintf(stderr, "%s: no FAT12/16/32 volume found\n", argv[argi]);
+        fclose(f);
+        return 2;
+    }
+    printf("volume at %llu: %u FATs of %u sectors, %u bytes/sector\n",
+           (unsigned long long)v.base, v.n_fats, v.fsize, v.ss);
+    if (v.n_fats < 2) {
+        printf("single FAT, nothing to compare\n");
+        fclose(f);
+        return 0;
+    }
+
+    uint8_t* fat1 = malloc(v.ss);
+    uint8_t* fat2 = malloc(v.ss);
+    uint64_t fat1_ofs = v.base + (uint64_t)v.reserved * v.ss;
+    uint64_t fat2_ofs = fat1_ofs + (uint64_t)v.fsize * v.ss;
+    uint32_t bad = 0, run_start = 0, in_run = 0;
+    int rc = 0;
+    for (uint32_t i = 0; i <= v.fsize; i++) {
+        int differs = 0;
+        if (i < v.fsize) {
+            if (!read_at(f, fat1_ofs + (uint64_t)i * v.ss, fat1, v.ss) ||
+                !read_at(f, fat2_ofs + (uint64_t)i * v.ss, fat2, v.ss)) {
+                fprintf(stderr, "read error at FAT sector %u\n", i);
+                rc = 2;
+                break;
+            }
+            differs = memcmp(fat1, fat2, v.ss) != 0;
+        }
+        if (differs) {
+            bad++;
+            if (!in_run) run_start = i;
+            in_run = 1;
+            if (repair && !write_at(f, fat2_ofs + (uint64_t)i * v.ss, fat1, v.ss)) {
+                fprintf(stderr, "write error at FAT sector %u\n", i);
+                rc = 2;
+                break;
+            }
+        } else if (in_run) {
+            printf("differ: FAT sectors %u..%u\n", run_start, i - 1);
+            in_run = 0;
+        }
+    }
+    free(fat1);
+    free(fat2);
+    if (fclose(f) != 0) rc = 2;
+    if (rc) return rc;
+
+    if (bad == 0) {
+        printf("FAT1 == FAT2\n");
+        return 0;
+    }
+    printf("%u sector(s) differ%s\n", bad, repair ? ", copied FAT1 over FAT2" : "");
+    return repair ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+/*******************************************************************************
+ alloc_bench - FAT32 cluster allocation cost vs fill level, with the free map
+ Build: tools/ff_host/build.sh   (builds alloc_bench with the ffconf.h free map
+        and alloc_bench_nomap with FF_FAT_FREEMAP=0)
+ Usage: alloc_bench [allocations]   (default: 300)
+
+ First a check of the free map against f_getfree(). A 64 MB FAT32 image with
+ 512-byte clusters is filled so that the only free clusters are the first
+ cluster of 128 free map groups (one FAT sector each), the FSInfo free count
+ is invalidated and the volume remounted. f_getfree() has to find 128 free
+ clusters, and 128 one-cluster files must then be written in full.
+ Then the benchmark: the image is filled to 50%, 90% and 99% by one
+ contiguous file, and `allocations` one-cluster files are written (every
+ third an earlier one is deleted), with fs->last_clst dropped before each
+ one as when the FSInfo hint is missing (FF_FS_NOFSINFO or a bad FSInfo
+ sector). It prints the disk_read() calls and host time per allocation, and
+ a hash of the final image: both builds must leave the same image.
+ Exit: 0 the check passed, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ramdisk.h"
+
+#define SECTORS 131072 // 64 MB
+#define AU 512
+#define HOLES 128
+
+uint64_t host_us;
+
+static uint8_t cluster[AU];
+
+static FRESULT write_file(const char *path, FSIZE_t size, UINT *written) {
+    FIL fil;
+    *written = 0;
+    FRESULT fr = f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE);
+    for (FSIZE_t done = 0; fr == FR_OK && done < size; done += AU) {
+        UINT bw;
+        fr = f_write(&fil, cluster, AU, &bw);
+        *written += bw;
+        if (bw < AU) break;
+    }
+    FRESULT fr2 = f_close(&fil);
+    return fr != FR_OK ? fr : fr2;
+}
+
+// One contiguous file of `clusters` clusters (0: nothing)
+static FRESULT expand_file(const char *path, DWORD clusters) {
+    FIL fil;
+    if (clusters == 0) return FR_OK;
+    FRESULT fr = f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fr == FR_OK) fr = f_expand(&fil, (FSIZE_t)clusters * AU, 1);
+    FRESULT fr2 = f_close(&fil);
+    return fr != FR_OK ? fr : fr2;
+}
+
+static uint32_t image_hash(void) {
+    uint32_t h = 2166136261u;
+    for (uint64_t i = 0; i < (uint64_t)rd_sectors * FF_MAX_SS; i++) {
+        h = (h ^ rd_image[i]) * 16777619u;
+    }
+    return h;
+}
+
+// Remount with the FSInfo free count and next-free hint set to "unknown"
+static FRESULT remount_without_fsinfo(FATFS *fs) {
+    f_mount(NULL, "", 0);
+    uint8_t *fsi = rd_image + (size_t)(rd_image[48] | rd_image[49] << 8) * FF_MAX_SS;
+    memset(fsi + 488, 0xFF, 8);
+    return f_mount(fs, "", 1);
+}
+
+// f_getfree() must count a free cluster that is the first of its group
+static int setup_failed(int line) {
+    printf("check: setting up the image failed (alloc_bench.c:%d)\n", line);
+    return 1;
+}
+
+static int check_group_tops(void) {
+    static FATFS fs;
+    char path[16];
+    UINT bw;
+    rd_create(SECTORS);
+    if (rd_format(FM_FAT32, AU) != FR_OK || f_mount(&fs, "", 1) != FR_OK) return setup_failed(__LINE__);
+
+    // Every directory entry first, so the root does not take a cluster later
+    for (int g = 0; g < HOLES; g++) {
+        snprintf(path, sizeof(path), "H%03d", g);
+        if (write_file(path, 0, &bw) != FR_OK) return setup_failed(__LINE__);
+        snprintf(path, sizeof(path), "F%03d", g);
+        if (write_file(path, 0, &bw) != FR_OK) return setup_failed(__LINE__);
+    }
+    if (write_file("REST", 0, &bw) != FR_OK) return setup_failed(__LINE__);
+    // A one-cluster file at the top of each of HOLES groups, the clusters
+    // between them taken by fillers; then the rest of the volume
+    DWORD group = FF_MAX_SS / 4; // Clusters per FAT sector, one free map group here
+    DWORD top = (fs.last_clst / group + 1) * group;
+    for (int g = 0; g < HOLES; g++, top += group) {
+        snprintf(path, sizeof(path), "F%03d", g);
+        if (expand_file(path, top - fs.last_clst - 1) != FR_OK) return setup_failed(__LINE__);
+        snprintf(path, sizeof(path), "H%03d", g);
+        if (write_file(path, AU, &bw) != FR_OK || fs.last_clst != top) {
+            printf("check: hole %d not at cluster %lu\n", g, (unsigned long)top);
+            return setup_failed(__LINE__);
+        }
+    }
+    DWORD free_clst;
+    FATFS *pfs;
+    if (expand_file("REST", fs.n_fatent - 1 - fs.last_clst) != FR_OK ||
+        f_getfree("", &free_clst, &pfs) != FR_OK || free_clst != 0) {
+        return setup_failed(__LINE__);
+    }
+    for (int g = 0; g < HOLES; g++) {
+        snprintf(path, sizeof(path), "H%03d", g);
+        if (f_unlink(path) != FR_OK) return setup_failed(__LINE__);
+    }
+
+    if (remount_without_fsinfo(&fs) != FR_OK || f_getfree("", &free_clst, &pfs) != FR_OK) return setup_failed(__LINE__);
+    int bad = free_clst != HOLES;
+    if (bad) printf("check: f_getfree() finds %lu free clusters, %d expected\n", (unsigned long)free_clst, HOLES);
+    for (int g = 0; g < HOLES; g++) {
+        snprintf(path, sizeof(path), "N%03d", g);
+        FRESULT fr = write_file(path, AU, &bw);
+        if (fr != FR_OK || bw != AU) {
+            if (bad++ < 3) printf("check: one-cluster file %d: result %d, %u bytes written\n", g, fr, bw);
+        }
+    }
+    if (f_getfree("", &free_clst, &pfs) != FR_OK || free_clst != 0) bad++;
+    printf("check: %s\n", bad ? "FAIL" : "ok, every free group top found and allocated");
+    f_mount(NULL, "", 0);
+    return bad ? 1 : 0;
+}
+
+static void bench(int percent, int allocations) {
+    static FATFS fs;
+    char path[16];
+    UINT bw;
+    rd_create(SECTORS);
+    if (rd_format(FM_FAT32, AU) != FR_OK || f_mount(&fs, "", 1) != FR_OK) return;
+    DWORD free_clst;
+    FATFS *pfs;
+    f_getfree("", &free_clst, &pfs);
+    if (expand_file("FILL", (DWORD)((uint64_t)free_clst * percent / 100)) != FR_OK) return;
+    f_mount(NULL, "", 0);
+    f_mount(&fs, "", 1);
+
+    rd_stats_t before = rd_stats;
+    uint64_t start = rd_clock_us();
+    for (int i = 0; i < allocations; i++) {
+        fs.last_clst = 0xFFFFFFFF;
+        snprintf(path, sizeof(path), "S%d", i);
+        if (write_file(path, AU, &bw) != FR_OK || bw != AU) {
+            printf("fill %d%%: allocation %d failed\n", percent, i);
+            return;
+        }
+        if (i % 3 == 0) {
+            snprintf(path, sizeof(path), "S%d", i / 3);
+            f_unlink(path);
+        }
+    }
+    uint64_t us = rd_clock_us() - start;
+    printf("fill %2d%%: %7.1f disk_read and %6.1f us per allocation  image %08x\n", percent,
+           (double)(rd_stats.reads - before.reads) / allocations, (double)us / allocations,
+           (unsigned)image_hash());
+    f_mount(NULL, "", 0);
+}
+
+int main(int argc, char **argv) {
+    int allocations = argc > 1 ? atoi(argv[1]) : 300;
+    printf("FF_FAT_FREEMAP %d\n", FF_FAT_FREEMAP);
+    int bad = check_group_tops();
+    static const int fills[] = {50, 90, 99};
+    for (size_t i = 0; i < sizeof(fills) / sizeof(fills[0]); i++) bench(fills[i], allocations);
+    return bad;
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ append_bench - Disk accesses of the log append path with the window cache
+ Build: tools/ff_host/build.sh   (builds append_bench with the ffconf.h cache
+        and append_bench_nocache with FF_WIN_CACHE_WAYS=0)
+ Usage: append_bench [lines]      (default: 5000)
+
+ Appends `lines` log lines to log.txt the way main.c does (f_open with
+ FA_OPEN_APPEND, one f_write, f_close per line) on a 64 MB RAM card image,
+ with every 10th line also appended to a second file, in a root directory
+ that already holds 40 files. Run once on FAT16 and once on FAT32 (512-byte
+ clusters, so the chain grows often). It prints the disk_read()/disk_write()
+ calls and sectors of the append loop and a hash of the final image: both
+ builds must leave the same image.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ramdisk.h"
+
+#define SECTORS 131072 // 64 MB
+
+uint64_t host_us;
+
+static FRESULT append(const char *path, const char *line) {
+    FIL fil;
+    UINT bw;
+    FRESULT fr = f_open(&fil, path, FA_OPEN_APPEND | FA_WRITE);
+    if (fr != FR_OK) return fr;
+    fr = f_write(&fil, line, (UINT)strlen(line), &bw);
+    FRESULT fr2 = f_close(&fil);
+    return fr != FR_OK ? fr : fr2;
+}
+
+// FNV-1a of the whole image
+static uint32_t image_hash(void) {
+    uint32_t h = 2166136261u;
+    for (uint64_t i = 0; i < (uint64_t)rd_sectors * FF_MAX_SS; i++) {
+        h = (h ^ rd_image[i]) * 16777619u;
+    }
+    return h;
+}
+
+static int run(BYTE fmt, DWORD au, const char *name, uint32_t lines) {
+    static FATFS fs;
+    rd_create(SECTORS);
+    if (rd_format(fmt, au) != FR_OK || f_mount(&fs, "", 1) != FR_OK) {
+        printf("%s: format failed\n", name);
+        return 1;
+    }
+    for (int i = 0; i < 40; i++) {
+        char path[16];
+        snprintf(path, sizeof(path), "F%02d.DAT", i);
+        if (append(path, "x") != FR_OK) return 1;
+    }
+
+    rd_stats_t before = rd_stats;
+    for (uint32_t i = 0; i < lines; i++) {
+        char line[80];
+        snprintf(line, sizeof(line), "2026-01-01T08:%02u:%02u.%03u [DOOR%u] ACCESS: GRANTED UID 22%06X\n",
+                 (unsigned)(i / 60 % 60), (unsigned)(i % 60), (unsigned)(i % 1000), (unsigned)(i % 4 + 1),
+                 (unsigned)(i * 2654435761u & 0xFFFFFF));
+        if (append("log.txt", line) != FR_OK || (i % 10 == 0 && append("events.csv", line) != FR_OK)) {
+            printf("%s: append failed at line %u\n", name, (unsigned)i);
+            return 1;
+        }
+    }
+    printf("%-5s disk_read %7llu (%7llu sectors)  disk_write %7llu (%7llu sectors)  image %08x\n", name,
+           (unsigned long long)(rd_stats.reads - before.reads),
+           (unsigned long long)(rd_stats.sectors_read - before.sectors_read),
+           (unsigned long long)(rd_stats.writes - before.writes),
+           (unsigned long long)(rd_stats.sectors_written - before.sectors_written), (unsigned)image_hash());
+    f_mount(NULL, "", 0);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t lines = argc > 1 ? (uint32_t)atoi(argv[1]) : 5000;
+    printf("%u lines, FF_WIN_CACHE_WAYS %d, FF_WIN_CACHE_SETS %d\n", (unsigned)lines, FF_WIN_CACHE_WAYS,
+           FF_WIN_CACHE_SETS);
+    int bad = run(FM_FAT, 0, "FAT16", lines);
+    bad += run(FM_FAT32, 512, "FAT32", lines);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+#!/bin/sh
+# Builds the FatFs host tools: tools/ff_host/build.sh [outdir]
+# Each tool links the FatFs sources of the tree with a RAM card image
+# (ramdisk.c). The Pico SDK headers the logger includes map to pico_host.h.
+# Extra compiler flags come from $CFLAGS, e.g. CFLAGS=-DFF_WIN_CACHE_WAYS=0 to
+# build against another ffconf.h setting.
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$HERE/../..
+FF=$ROOT/lib/FatFs_SPI
+OUT=${1:-$HERE}
+mkdir -p "$OUT"
+INC=$(mktemp -d)
+trap 'rm -rf "$INC"' EXIT
+
+mkdir -p "$INC/hardware" "$INC/pico/util"
+for h in hardware/rtc.h pico/stdlib.h pico/util/datetime.h rtc.h; do
+    echo '#include "pico_host.h"' > "$INC/$h"
+done
+
+FATFS="$FF/ff15/source/ff.c $FF/ff15/source/ffunicode.c $FF/ff15/source/ffsystem.c $HERE/ramdisk.c"
+LOGGER="$ROOT/lib_logger/log_binary.c $ROOT/lib_logger/log_journal.c $ROOT/lib_logger/log_rotate.c \
+        $ROOT/lib_logger/log_query.c \
+        $ROOT/lib_logger/log_time.c $ROOT/lib_logger/log_fixed.c $FF/sd_driver/crc.c"
+build() {
+    out=$1
+    shift
+    ${CC:-cc} -O2 -g -Wall -Wno-format $CFLAGS -I"$INC" -I"$HERE" -I"$FF/ff15/source" \
+        -I"$FF/include" -I"$FF/sd_driver" -I"$ROOT/lib_logger" -o "$OUT/$out" "$@" $FATFS
+}
+
+build log_powercut "$HERE/log_powercut.c" $LOGGER
+build log_query_bench "$HERE/log_query_bench.c" $LOGGER
+build append_bench "$HERE/append_bench.c"
+CFLAGS="$CFLAGS -DFF_WIN_CACHE_WAYS=0" build append_bench_nocache "$HERE/append_bench.c"
+CFLAGS="$CFLAGS -DFF_FAT2_DEFER=1" build fat2_powercut "$HERE/fat2_powercut.c"
+build alloc_bench "$HERE/alloc_bench.c"
+CFLAGS="$CFLAGS -DFF_FAT_FREEMAP=0" build alloc_bench_nomap "$HERE/alloc_bench.c"
+CFLAGS="$CFLAGS -DFF_WIN_CACHE_WAYS=0" build open_bench "$HERE/open_bench.c"
+CFLAGS="$CFLAGS -DFF_WIN_CACHE_WAYS=0 -DFF_DIR_CACHE=0" build open_bench_nocache "$HERE/open_bench.c"
+CFLAGS="$CFLAGS -DNDEBUG" build gets_bench "$HERE/gets_bench.c" $FF/src/ff_stdio.c $FF/src/f_util.c
+CFLAGS="$CFLAGS -DNDEBUG" build stdio_bench "$HERE/stdio_bench.c" $FF/src/ff_stdio.c $FF/src/f_util.c
+build span_check "$HERE/span_check.c"
@@ -0,0 +1,266 @@
+/*******************************************************************************
+ fat2_powercut - Power-cut fuzz test of the deferred 2nd FAT (FF_FAT2_DEFER=1)
+ Build: tools/ff_host/build.sh   (built with -DFF_FAT2_DEFER=1)
+ Usage: fat2_powercut [runs] [seed]
+
+ Each run formats a RAM card image with two FATs (FAT16, then FAT32 with
+ 512-byte clusters, in turn) and appends random amounts to six files at once,
+ so their clusters interleave and the 1st FAT changes in more places than
+ FF_FAT2_RANGES. Files are synced and closed at random. The run checks that:
+   - after every f_sync()/f_close() of a file with unsynced writes, the 2nd
+     FAT on the card equals the 1st;
+   - in half the runs, the power is cut after a random number of sector writes
+     (also inside the 2nd FAT copy of a sync). After a remount, every file
+     that was synced before the cut exists with at least its synced size, all
+     of it reads back, and the 1st FAT chain over its size is valid: each
+     link points to a used cluster inside the volume and no cluster is
+     shared between files. The 2nd FAT may be stale here;
+   - the other runs close every file and unmount: the two FATs must match and
+     the free clusters of the 1st FAT must be exactly those no file holds.
+ Exit: 0 all runs passed, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ramdisk.h"
+
+#if !FF_FAT2_DEFER
+#error "build with -DFF_FAT2_DEFER=1"
+#endif
+
+#define SECTORS 131072 // 64 MB
+#define NFILES 6
+
+uint64_t host_us;
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd(uint32_t lo, uint32_t hi) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return lo + (uint32_t)(rng % (hi - lo + 1));
+}
+
+static int fails, stale; // stale: cuts that left the 2nd FAT behind the 1st
+static void fail(int run, const char *what, unsigned long a, unsigned long b) {
+    printf("run %d: %s (%lu, %lu)\n", run, what, a, b);
+    fails++;
+}
+
+typedef struct {
+    char path[8];
+    FIL fil;
+    bool open;
+    bool durable;  // Synced or closed at least once: the file must survive a cut
+    FSIZE_t size;  // Bytes written
+    FSIZE_t synced; // Size at the last f_sync()/f_close() that returned FR_OK
+} file_t;
+
+static FATFS fs;
+static file_t files[NFILES];
+static uint8_t buf[24576], back[24576];
+static uint8_t *used; // One byte per cluster: held by a file
+
+// Byte at offset ofs of file i
+static uint8_t byte_at(int i, FSIZE_t ofs) {
+    return (uint8_t)((ofs * 2654435761u >> 13) ^ (uint32_t)i * 31);
+}
+
+// Entry clst of the 1st FAT, read from the card image
+static DWORD fat1_get(DWORD clst) {
+    const uint8_t *fat = rd_image + (size_t)fs.fatbase * FF_MAX_SS;
+    if (fs.fs_type == FS_FAT16) return (DWORD)(fat[clst * 2] | fat[clst * 2 + 1] << 8);
+    const uint8_t *p = fat + clst * 4;
+    return ((DWORD)p[0] | (DWORD)p[1] << 8 | (DWORD)p[2] << 16 | (DWORD)p[3] << 24) & 0x0FFFFFFF;
+}
+
+// Compares the two FATs on the card; returns the first sector that differs or -1
+static long fat2_differs(void) {
+    const uint8_t *fat1 = rd_image + (size_t)fs.fatbase * FF_MAX_SS;
+    for (DWORD s = 0; s < fs.fsize; s++) {
+        if (memcmp(fat1 + (size_t)s * FF_MAX_SS, fat1 + ((size_t)fs.fsize + s) * FF_MAX_SS, FF_MAX_SS)) {
+            return (long)s;
+        }
+    }
+    return -1;
+}
+
+// Walks up to limit clusters of the 1st FAT chain from sclust, marking used[];
+// returns the clusters walked, or -1 if a link is free, outside the volume or
+// already held
+static long walk_chain(DWORD sclust, long limit) {
+    DWORD eoc = fs.fs_type == FS_FAT16 ? 0xFFF8 : 0x0FFFFFF8;
+    long n = 0;
+    for (DWORD c = sclust; c != 0 && n < limit;) {
+        if (c < 2 || c >= fs.n_fatent || used[c]) return -1;
+        used[c] = 1;
+        n++;
+        DWORD next = fat1_get(c);
+        if (next >= eoc) break;
+        if (next < 2 && n < limit) return -1; // Free cluster inside a chain
+        c = next;
+    }
+    return n;
+}
+
+// Opens the file on the remounted volume, reads it back and walks its chain.
+// After a cut only the clusters inside the file size are walked: links past
+// them were being allocated when the power went and may be torn.
+static bool check_file(int run, int i, bool must_exist, bool cut) {
+    file_t *f = &files[i];
+    FIL fil;
+    FRESULT fr = f_open(&fil, f->path, FA_READ);
+    if (fr == FR_NO_FILE && !must_exist) return true;
+    if (fr != FR_OK) {
+        fail(run, "synced file missing (file, result)", (unsigned long)i, fr);
+        return false;
+    }
+    FSIZE_t size = f_size(&fil);
+    if (size < f->synced || size > f->size) {
+        fail(run, "file size (size, synced)", (unsigned long)size, (unsigned long)f->synced);
+        f_close(&fil);
+        return false;
+    }
+    for (FSIZE_t ofs = 0; ofs < size;) {
+        UINT br, len = (UINT)(size - ofs < sizeof(back) ? size - ofs : sizeof(back));
+        fr = f_read(&fil, back, len, &br);
+        bool same = fr == FR_OK && br == len;
+        for (UINT k = 0; same && k < len; k++) same = back[k] == byte_at(i, ofs + k);
+        if (!same) {
+            fail(run, "file differs (file, offset)", (unsigned long)i, (unsigned long)ofs);
+            f_close(&fil);
+            return false;
+        }
+        ofs += len;
+    }
+    DWORD cluster_bytes = (DWORD)fs.csize * FF_MAX_SS;
+    long need = (long)((size + cluster_bytes - 1) / cluster_bytes);
+    long clusters = walk_chain(fil.obj.sclust, cut ? need : (long)fs.n_fatent);
+    f_close(&fil);
+    if (clusters != need) {
+        fail(run, "bad 1st FAT chain (file, clusters)", (unsigned long)i, (unsigned long)clusters);
+        return false;
+    }
+    return true;
+}
+
+// f_sync() or f_close() of file i; the 2nd FAT must be current afterwards.
+// A file with nothing to write back is not synced at all, and the 1st FAT
+// may hold allocations of other open files, so it is only compared then.
+static bool sync_file(int run, int i, bool close) {
+    file_t *f = &files[i];
+    bool modified = f->size != f->synced || !f->durable;
+    FRESULT fr = close ? f_close(&f->fil) : f_sync(&f->fil);
+    if (close) f->open = false;
+    if (fr != FR_OK) return false;
+    f->synced = f->size;
+    f->durable = true;
+    long s = modified ? fat2_differs() : -1;
+    if (s >= 0) {
+        fail(run, close ? "2nd FAT stale after f_close (sector, file)" : "2nd FAT stale after f_sync (sector, file)",
+             (unsigned long)s, (unsigned long)i);
+        return false;
+    }
+    return true;
+}
+
+static void run_once(int run) {
+    static const BYTE fmts[] = {FM_FAT, FM_FAT32};
+    BYTE fmt = fmts[run % 2];
+    rd_create(SECTORS);
+    if (rd_format(fmt, fmt == FM_FAT32 ? 512 : 0) != FR_OK || f_mount(&fs, "", 1) != FR_OK) {
+        fail(run, "format", fmt, 0);
+        return;
+    }
+    free(used);
+    used = calloc(fs.n_fatent, 1);
+    for (int i = 0; i < NFILES; i++) {
+        snprintf(files[i].path, sizeof(files[i].path), "F%d.BIN", i);
+        files[i].open = files[i].durable = false;
+        files[i].size = files[i].synced = 0;
+    }
+
+    bool cut = run / 2 % 2 == 0;
+    uint32_t ops = rnd(50, 600);
+    uint32_t cut_at = rnd(0, ops - 1);
+    uint32_t syncs = 0;
+    bool ok = true;
+    for (uint32_t op = 0; op < ops && ok && !rd_power_off; op++) {
+        if (cut && op == cut_at) rd_write_budget = rnd(0, 64);
+        int i = (int)rnd(0, NFILES - 1);
+        file_t *f = &files[i];
+        if (!f->open) {
+            if (f_open(&f->fil, f->path, FA_OPEN_APPEND | FA_WRITE) != FR_OK) break;
+            f->open = true;
+        }
+        UINT len = rnd(1, sizeof(buf)), bw;
+        for (UINT k = 0; k < len; k++) buf[k] = byte_at(i, f->size + k);
+        if (f_write(&f->fil, buf, len, &bw) != FR_OK || bw != len) break;
+        f->size += len;
+        uint32_t r = rnd(0, 15);
+        if (r < 2) {
+            ok = sync_file(run, i, r == 1) || rd_power_off;
+            syncs++;
+        }
+    }
+    if (!ok) return;
+
+    const char *end = rd_power_off ? "power cut" : cut ? "cut never reached" : "unmounted";
+    if (!rd_power_off && !cut) {
+        // Clean unmount: close everything, then both FATs match
+        for (int i = 0; i < NFILES; i++) {
+            if (files[i].open && !sync_file(run, i, true)) return;
+        }
+        f_mount(NULL, "", 0);
+        long s = fat2_differs();
+        if (s >= 0) fail(run, "2nd FAT stale after unmount (sector)", (unsigned long)s, 0);
+        if (f_mount(&fs, "", 1) != FR_OK) {
+            fail(run, "remount", 0, 0);
+            return;
+        }
+        long held = 0;
+        if (fs.fs_type == FS_FAT32) walk_chain((DWORD)fs.dirbase, (long)fs.n_fatent); // Root directory
+        for (int i = 0; i < NFILES; i++) {
+            if (!check_file(run, i, files[i].durable, false)) return;
+        }
+        for (DWORD c = 2; c < fs.n_fatent; c++) held += used[c];
+        DWORD free_clst = 0;
+        for (DWORD c = 2; c < fs.n_fatent; c++) free_clst += fat1_get(c) == 0;
+        if (free_clst != fs.n_fatent - 2 - held) {
+            fail(run, "free clusters after unmount (free, expected)", free_clst,
+                 (unsigned long)(fs.n_fatent - 2 - held));
+        }
+    } else {
+        // Reboot after the cut: only the 1st FAT is trusted
+        if (rd_power_off && fat2_differs() >= 0) stale++;
+        rd_power_on();
+        f_mount(NULL, "", 0);
+        if (f_mount(&fs, "", 1) != FR_OK) {
+            fail(run, "remount after the cut", 0, 0);
+            return;
+        }
+        for (int i = 0; i < NFILES; i++) {
+            if (!check_file(run, i, files[i].durable, true)) return;
+        }
+        DWORD free_clst;
+        FATFS *pfs;
+        if (f_getfree("", &free_clst, &pfs) != FR_OK) fail(run, "f_getfree", 0, 0);
+    }
+    if (run % 25 == 0) {
+        long s = fat2_differs();
+        printf("run %d: %s, %lu ops, %lu syncs, %s, 2nd FAT %s\n", run,
+               fs.fs_type == FS_FAT32 ? "FAT32" : "FAT16", (unsigned long)ops, (unsigned long)syncs,
+               end, s < 0 ? "matches" : "stale");
+    }
+    f_mount(NULL, "", 0);
+}
+
+int main(int argc, char **argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : 300;
+    if (argc > 2) rng = strtoull(argv[2], NULL, 0) | 1;
+    for (int run = 0; run < runs; run++) run_once(run);
+    printf("%d runs, %d failures, 2nd FAT stale after %d power cuts\n", runs, fails, stale);
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ gets_bench - Lines per second of f_gets() and ff_fgets(), unbuffered and with
+              a stream buffer
+ Build: tools/ff_host/build.sh
+ Usage: gets_bench [passes]      (default: 5)
+
+ A 40000-line CSV of access events (some lines with UTF-8 names) is written to
+ a FAT32 RAM card image, then read line by line `passes` times each with
+ f_gets(), ff_fgets() on an unbuffered stream and ff_fgets() after
+ ff_setvbuf() with a 512- and a 4096-byte buffer, into a 1024-, 300- and 64-byte
+ line buffer (the last splits the longer lines). It prints lines per second
+ and the sectors read per pass: an unbuffered ff_fgets() must not read more
+ sectors than f_gets(), so giving back the bytes past the newline costs no
+ disk access. Every reader must return the same bytes.
+ Exit: 0 every reader returned the file, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff_stdio.h"
+#include "ramdisk.h"
+
+#define SECTORS 131072 // 64 MB
+#define LINES 40000
+
+uint64_t host_us;
+
+static const char *const names[] = {"Anna Meier", "Jürgen Groß", "Zoë Lefèvre", "Bob Smith", "Łukasz Żak"};
+
+// FNV-1a, continued from h
+static uint32_t hash(uint32_t h, const char *p) {
+    while (*p) h = (h ^ (uint8_t)*p++) * 16777619u;
+    return h;
+}
+
+static FRESULT make_csv(uint32_t *h, FSIZE_t *size) {
+    FIL fil;
+    FRESULT fr = f_open(&fil, "events.csv", FA_CREATE_ALWAYS | FA_WRITE);
+    *h = 2166136261u;
+    for (uint32_t i = 0; fr == FR_OK && i < LINES; i++) {
+        char line[128];
+        UINT bw;
+        int n = snprintf(line, sizeof(line), "2026-01-01T%02u:%02u:%02u,DOOR%u,%s,22%06X,%s\n",
+                         (unsigned)(i / 3600 % 24), (unsigned)(i / 60 % 60), (unsigned)(i % 60),
+                         (unsigned)(i % 4 + 1), i % 7 ? "GRANTED" : "DENIED",
+                         (unsigned)(i * 2654435761u & 0xFFFFFF), names[i % 5]);
+        fr = f_write(&fil, line, (UINT)n, &bw);
+        *h = hash(*h, line);
+    }
+    *size = f_size(&fil);
+    FRESULT fr2 = f_close(&fil);
+    return fr != FR_OK ? fr : fr2;
+}
+
+// Reads the file `passes` times with the given reader; vbuf 0: f_gets(), else
+// ff_fgets() with a stream buffer of vbuf bytes, -1 for none. Returns the
+// sectors read per pass, 0 if the bytes differ from the file.
+static uint64_t run(const char *name, int vbuf, size_t linesize, int passes, uint32_t want) {
+    char line[1024];
+    uint32_t lines = 0, h = 0;
+    uint64_t sectors = 0, us = 0;
+    for (int p = 0; p < passes; p++) {
+        FIL fil;
+        FF_FILE *stream = NULL;
+        if (vbuf) {
+            stream = ff_fopen("events.csv", "r");
+            if (!stream || (vbuf > 0 && ff_setvbuf(stream, NULL, _IOFBF, (size_t)vbuf))) return 0;
+        } else if (f_open(&fil, "events.csv", FA_READ) != FR_OK) {
+            return 0;
+        }
+        uint64_t before = rd_stats.sectors_read, start = rd_clock_us();
+        h = 2166136261u;
+        lines = 0;
+        while (vbuf ? ff_fgets(line, linesize, stream) != NULL : f_gets(line, (int)linesize, &fil) != NULL) {
+            h = hash(h, line);
+            if (strchr(line, '\n')) lines++;
+        }
+        us += rd_clock_us() - start;
+        sectors += rd_stats.sectors_read - before;
+        if (vbuf) ff_fclose(stream);
+        else f_close(&fil);
+    }
+    printf("%-22s %3u-byte line: %6.2fM lines/s  %5llu sectors per pass%s\n", name, (unsigned)linesize,
+           (double)lines * passes / (double)(us ? us : 1), (unsigned long long)(sectors / passes),
+           h == want ? "" : "  WRONG BYTES");
+    return h == want ? sectors / passes : 0;
+}
+
+int main(int argc, char **argv) {
+    static FATFS fs;
+    int passes = argc > 1 ? atoi(argv[1]) : 5;
+    uint32_t want;
+    FSIZE_t size;
+    rd_create(SECTORS);
+    if (rd_format(FM_FAT32, 0) != FR_OK || f_mount(&fs, "", 1) != FR_OK || make_csv(&want, &size) != FR_OK) {
+        printf("setup failed\n");
+        return 1;
+    }
+    printf("%d lines, %llu bytes, %llu sectors\n", LINES, (unsigned long long)size,
+           (unsigned long long)((size + FF_MAX_SS - 1) / FF_MAX_SS));
+    static const size_t linesizes[] = {1024, 300, 64};
+    int bad = 0;
+    for (size_t i = 0; i < sizeof(linesizes) / sizeof(linesizes[0]); i++) {
+        uint64_t sectors = run("f_gets", 0, linesizes[i], passes, want);
+        uint64_t unbuffered = run("ff_fgets unbuffered", -1, linesizes[i], passes, want);
+        bad += !sectors || !unbuffered || unbuffered > sectors;
+        bad += !run("ff_fgets 512 buffer", 512, linesizes[i], passes, want);
+        bad += !run("ff_fgets 4096 buffer", 4096, linesizes[i], passes, want);
+    }
+    f_mount(NULL, "", 0);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+/*******************************************************************************
+ log_powercut - Power-cut fuzz test of the journaled binary log (lib_logger)
+ Build: tools/ff_host/build.sh   (links log_rotate.c, log_journal.c and FatFs)
+ Usage: log_powercut [runs] [seed]
+
+ Each run formats a RAM card image (FAT16, FAT32 or exFAT in turn), appends
+ numbered records through log_rotate_append()/log_rotate_poll() with random
+ gaps (so segments rotate on size and at midnight), and cuts the power after a
+ random number of sector writes: the write that crosses the limit is torn and
+ every later access fails. The volume is then remounted and log_rotate_init()
+ recovers, as initialize_sd() does at boot. The run checks that:
+   - the records found on the card are 0, 1, 2 ... k-1 with no gap and no
+     duplicate, k at least the number of records flushed before the cut;
+   - logging continues after recovery and every segment decodes to the
+     record and byte counts of its index slot once closed;
+   - the volume still mounts and f_getfree() works.
+ Exit: 0 all runs passed, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_binary.h"
+#include "log_conf.h"
+#include "log_rotate.h"
+#include "ramdisk.h"
+
+#define SECTORS 131072 // 64 MB
+#define MAX_IDS 200000
+
+uint64_t host_us;
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd(uint32_t lo, uint32_t hi) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return lo + (uint32_t)(rng % (hi - lo + 1));
+}
+
+static int fails;
+static void fail(int run, const char *what, unsigned long a, unsigned long b) {
+    printf("run %d: %s (%lu, %lu)\n", run, what, a, b);
+    fails++;
+}
+
+static log_record_t make_record(uint32_t id, uint64_t time_ms) {
+    log_record_t rec = {.time_ms = time_ms, .type = LOG_BIN_ACCESS, .door = id % 4,
+                        .status = LOG_STATUS_GRANTED, .len = 4};
+    memcpy(rec.data, &id, 4);
+    return rec;
+}
+
+static uint8_t seg_buf[LOG_SEGMENT_MAX_BYTES];
+
+// Decodes the first `length` bytes of a segment, appending record ids to ids[]
+static bool read_segment(const char *name, uint32_t length, uint32_t *ids, uint32_t *n_ids,
+                         uint32_t *records) {
+    char path[32];
+    FIL f;
+    UINT br;
+    log_segment_path(name, path);
+    if (f_open(&f, path, FA_READ) != FR_OK) return false;
+    FRESULT fr = f_read(&f, seg_buf, length, &br);
+    f_close(&f);
+    uint16_t nonce;
+    if (fr != FR_OK || br != length || !log_bin_check_header(seg_buf, br, &nonce)) return false;
+
+    log_bin_reader_t rd;
+    log_bin_reader_init(&rd, nonce);
+    *records = 0;
+    for (uint32_t pos = LOG_BIN_HEADER_SIZE; pos < length;) {
+        log_record_t rec;
+        int k = log_bin_decode(&rd, seg_buf + pos, length - pos, &rec);
+        if (k <= 0) return false;
+        pos += k;
+        if (rec.type == LOG_BIN_PAD || rec.type == LOG_BIN_SYNC) continue;
+        (*records)++;
+        uint32_t id;
+        memcpy(&id, rec.data, 4);
+        if (*n_ids < MAX_IDS) ids[(*n_ids)++] = id;
+    }
+    return true;
+}
+
+// Collects the ids of every segment in index order; the open segment (if
+// any) is read up to its recovered length
+static bool collect(const log_rotator_t *r, uint32_t *ids, uint32_t *n_ids, bool check_slots,
+                    int run) {
+    *n_ids = 0;
+    uint32_t count = log_index_count();
+    for (uint32_t s = 0; s < count; s++) {
+        log_index_entry_t e;
+        if (log_index_read(s, &e) != FR_OK) return false;
+        bool open = r->open && s == r->slot;
+        uint32_t length = open ? r->journal.length : e.bytes;
+        uint32_t records;
+        if (!read_segment(e.name, length, ids, n_ids, &records)) {
+            fail(run, "segment does not decode", s, length);
+            return false;
+        }
+        if (check_slots && !open && records != e.records) {
+            fail(run, "index slot record count", records, e.records);
+        }
+    }
+    return true;
+}
+
+static uint32_t ids[MAX_IDS];
+
+static void run_once(int run) {
+    static const BYTE fmts[] = {FM_FAT, FM_FAT32, FM_EXFAT};
+    static FATFS fs;
+    rd_create(SECTORS);
+    if (rd_format(fmts[run % 3], fmts[run % 3] == FM_FAT32 ? 512 : 0) != FR_OK ||
+        f_mount(&fs, "", 1) != FR_OK) {
+        fail(run, "format", run % 3, 0);
+        return;
+    }
+
+    log_rotator_t r;
+    if (log_rotate_init(&r) != FR_OK) {
+        fail(run, "init", 0, 0);
+        return;
+    }
+    // Start a few minutes before a midnight, some runs cross it
+    uint64_t now_ms = (20000ull + rnd(0, 1000)) * 86400000u - rnd(0, 600) * 1000u;
+    uint32_t total = rnd(10, 60000);
+    uint32_t cut_at = rnd(0, total);
+    uint32_t appended = 0, durable = 0;
+    for (uint32_t id = 0; id < total && !rd_power_off; id++) {
+        if (id == cut_at) rd_write_budget = rnd(0, 4);
+        now_ms += rnd(0, 20) == 0 ? rnd(60000, 120000) : rnd(0, 3000);
+        log_record_t rec = make_record(id, now_ms);
+        if (log_rotate_append(&r, &rec) != FR_OK) break;
+        appended++;
+        if (log_rotate_poll(&r, now_ms) != FR_OK) break;
+        if (!r.journal.dirty && !r.journal.pending) durable = appended;
+    }
+
+    // Reboot: the RAM copy of the tail is gone, the card keeps what was written
+    rd_power_on();
+    f_mount(NULL, "", 0);
+    if (f_mount(&fs, "", 1) != FR_OK) {
+        fail(run, "remount", 0, 0);
+        return;
+    }
+    if (log_rotate_init(&r) != FR_OK) {
+        fail(run, "recovery", 0, 0);
+        return;
+    }
+    uint32_t n;
+    if (!collect(&r, ids, &n, false, run)) return;
+    for (uint32_t i = 0; i < n; i++) {
+        if (ids[i] != i) {
+            fail(run, "record out of order after recovery", i, ids[i]);
+            return;
+        }
+    }
+    if (n < durable || n > appended) fail(run, "records recovered (recovered, flushed)", n, durable);
+
+    // Keep logging after the recovery, then close and check every segment
+    for (uint32_t id = n; id < n + 100; id++) {
+        now_ms += rnd(0, 3000);
+        log_record_t rec = make_record(id, now_ms);
+        if (log_rotate_append(&r, &rec) != FR_OK) {
+            fail(run, "append after recovery", id, 0);
+            return;
+        }
+    }
+    if (log_rotate_close(&r) != FR_OK) fail(run, "close", 0, 0);
+    uint32_t recovered = n;
+    if (!collect(&r, ids, &n, true, run)) return;
+    for (uint32_t i = 0; i < n; i++) {
+        if (ids[i] != i) {
+            fail(run, "record out of order after close", i, ids[i]);
+            return;
+        }
+    }
+    if (n != recovered + 100) fail(run, "records after close", n, recovered + 100);
+    DWORD free_clst;
+    FATFS *pfs;
+    if (f_getfree("", &free_clst, &pfs) != FR_OK) fail(run, "f_getfree", 0, 0);
+    if (run % 50 == 0) {
+        printf("run %d: %s, %lu appended, cut at %lu, %lu flushed, %lu recovered, %lu segments\n",
+               run, fs.fs_type == FS_EXFAT ? "exFAT" : fs.fs_type == FS_FAT32 ? "FAT32" : "FAT16",
+               (unsigned long)appended, (unsigned long)cut_at, (unsigned long)durable,
+               (unsigned long)recovered, (unsigned long)log_index_count());
+    }
+    f_mount(NULL, "", 0);
+}
+
+int main(int argc, char **argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : 300;
+    if (argc > 2) rng = strtoull(argv[2], NULL, 0) | 1;
+    for (int run = 0; run < runs; run++) run_once(run);
+    printf("%d runs, %d failures\n", runs, fails);
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+/*******************************************************************************
+ log_query_bench - Cost of log_query_run() over a large binary log (lib_logger)
+ Build: tools/ff_host/build.sh   (links log_query.c, log_rotate.c and FatFs)
+ Usage: log_query_bench [MB] [queries]     (default: 1024 MB, 20 queries per kind)
+
+ Fills a FAT32 RAM card image with MB megabytes of rotated segments (access
+ records from 256 badges on 4 doors and PIR events, 0-200 ms apart, so about
+ 13 MB and 50 segments per day), then runs time-range queries of 1 minute,
+ 1 hour and 1 day and a 1-day single-UID query at random points. For each
+ kind it prints the average disk_read() calls, sectors read, records decoded
+ and host time per query, next to a linear scan of every segment (reading the
+ whole log, as the text log had to be searched). The first 2 queries of each
+ kind are checked against the linear scan.
+ Before that, a small log has its clock set back 10 minutes part way through a
+ day; every 1-minute query over the stepped range must find the same records
+ as the linear scan and as the list of what was written.
+ Sector counts are what the SD card has to send; at 12.5 MHz SPI one sector
+ takes about 0.33 ms on the wire, before the card's own read latency.
+ Exit: 0 all checked queries matched the linear scan, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_binary.h"
+#include "log_conf.h"
+#include "log_query.h"
+#include "log_rotate.h"
+#include "ramdisk.h"
+
+#define UIDS 256
+#define START_MS 1767225600000ull // 2026-01-01T00:00:00Z
+#define STEP_RECORDS 10000         // Records of the clock step check
+
+uint64_t host_us;
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd(uint32_t lo, uint32_t hi) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return lo + (uint32_t)(rng % (hi - lo + 1));
+}
+
+static void badge(uint32_t n, uint8_t* uid) {
+    uid[0] = 0x22;
+    uid[1] = (uint8_t)(n * 37);
+    uid[2] = (uint8_t)n;
+    uid[3] = 0x04;
+}
+
+// Same filter as log_query.c
+static bool matches(const log_query_t* q, const log_record_t* rec) {
+    if (rec->type == LOG_BIN_SYNC || rec->type == LOG_BIN_PAD) return false;
+    if (rec->time_ms < q->from_ms || rec->time_ms > q->to_ms) return false;
+    if (q->access_only && rec->type != LOG_BIN_ACCESS) return false;
+    if (q->doors && !(q->doors & (1u << rec->door))) return false;
+    if (q->uid_len == 0) return true;
+    return rec->type == LOG_BIN_ACCESS && rec->len == q->uid_len &&
+           memcmp(rec->data, q->uid, q->uid_len) == 0;
+}
+
+static bool count_match(const log_record_t* rec, void* ctx) {
+    (void)rec;
+    (*(uint32_t*)ctx)++;
+    return true;
+}
+
+typedef struct {
+    uint64_t reads, sectors, records, us;
+    uint32_t matches;
+} cost_t;
+
+static uint8_t seg_buf[LOG_SEGMENT_MAX_BYTES];
+
+// Reads every segment from start to end and filters each record
+static cost_t linear_scan(const log_query_t* q) {
+    cost_t c = {0};
+    rd_stats_t before = rd_stats;
+    uint64_t start = rd_clock_us();
+    static FIL index;
+    if (f_open(&index, LOG_INDEX_FILE, FA_READ) != FR_OK) return c;
+    log_index_entry_t e;
+    UINT br;
+    while (f_read(&index, &e, sizeof(e), &br) == FR_OK && br == sizeof(e)) {
+        char path[32];
+        FIL f;
+        log_segment_path(e.name, path);
+        if (f_open(&f, path, FA_READ) != FR_OK) continue;
+        FRESULT fr = f_read(&f, seg_buf, sizeof(seg_buf), &br);
+        f_close(&f);
+        uint16_t nonce;
+        if (fr != FR_OK || !log_bin_check_header(seg_buf, br, &nonce)) continue;
+        log_bin_reader_t rd;
+        log_bin_reader_init(&rd, nonce);
+        for (uint32_t pos = LOG_BIN_HEADER_SIZE; pos < br;) {
+            log_record_t rec;
+            int n = log_bin_decode(&rd, seg_buf + pos, br - pos, &rec);
+            if (n <= 0) break;
+            pos += n;
+            c.records++;
+            if (matches(q, &rec)) c.matches++;
+        }
+    }
+    f_close(&index);
+    c.us = rd_clock_us() - start;
+    c.reads = rd_stats.reads - before.reads;
+    c.sectors = rd_stats.sectors_read - before.sectors_read;
+    return c;
+}
+
+static cost_t indexed(const log_query_t* q) {
+    cost_t c = {0};
+    log_query_stats_t st;
+    rd_stats_t before = rd_stats;
+    uint64_t start = rd_clock_us();
+    if (log_query_run(q, NULL, count_match, &c.matches, &st) != FR_OK) c.matches = UINT32_MAX;
+    c.us = rd_clock_us() - start;
+    c.reads = rd_stats.reads - before.reads;
+    c.sectors = rd_stats.sectors_read - before.sectors_read;
+    c.records = st.records;
+    return c;
+}
+
+// Record i: ACCESS of badge i % UIDS at time t
+static log_record_t step_record(uint32_t i, uint64_t t) {
+    log_record_t rec = {.time_ms = t, .door = (uint8_t)(i % 4 + 1), .type = LOG_BIN_ACCESS,
+                        .status = LOG_STATUS_GRANTED, .len = 4};
+    badge(i % UIDS, rec.data);
+    return rec;
+}
+
+// Writes 5000 records from 12:00, sets the clock back 10 minutes and writes
+// 5000 more (the same day), then checks 1-minute queries from 11:54 to 12:10
+static int clock_step_check(void) {
+    static uint64_t times[STEP_RECORDS];
+    static FATFS fs;
+    rd_create(131072); // 64 MB
+    log_rotator_t r;
+    if (rd_format(FM_FAT32, 0) != FR_OK || f_mount(&fs, "", 1) != FR_OK || log_rotate_init(&r) != FR_OK) {
+        printf("clock step: setup failed\n");
+        return 1;
+    }
+    uint64_t t = START_MS + 12 * 3600000ull;
+    for (uint32_t i = 0; i < STEP_RECORDS; i++) {
+        if (i == STEP_RECORDS / 2) t -= 10 * 60000;
+        t += rnd(0, 200);
+        times[i] = t;
+        log_record_t rec = step_record(i, t);
+        if (log_rotate_append(&r, &rec) != FR_OK) {
+            printf("clock step: append failed\n");
+            return 1;
+        }
+    }
+    if (log_rotate_close(&r) != FR_OK) return 1;
+
+    int bad = 0;
+    uint64_t from = START_MS + 12 * 3600000ull - 6 * 60000;
+    for (int m = 0; m < 16; m++) {
+        log_query_t q = {.from_ms = from + m * 60000ull, .to_ms = from + (m + 1) * 60000ull - 1};
+        uint32_t want = 0;
+        for (uint32_t i = 0; i < STEP_RECORDS; i++) want += times[i] >= q.from_ms && times[i] <= q.to_ms;
+        cost_t c = indexed(&q), s = linear_scan(&q);
+        if (c.matches != want || s.matches != want) {
+            printf("clock step: minute %d: %u matches, linear scan finds %u, %u written\n", m, c.matches,
+                   s.matches, want);
+            bad++;
+        }
+    }
+    printf("clock set back 10 minutes: %u segments, %s\n", log_index_count(), bad ? "FAILED" : "ok");
+    f_mount(NULL, "", 0);
+    return bad;
+}
+
+static void print_cost(const char* what, const cost_t* c, int n) {
+    printf("  %-12s %10.0f disk_read %10.0f sectors %11.0f records %9.1f ms  %8.1f matches\n", what,
+           (double)c->reads / n, (double)c->sectors / n, (double)c->records / n,
+           (double)c->us / n / 1000, (double)c->matches / n);
+}
+
+int main(int argc, char** argv) {
+    uint32_t mb = argc > 1 ? (uint32_t)atoi(argv[1]) : 1024;
+    int queries = argc > 2 ? atoi(argv[2]) : 20;
+    static FATFS fs;
+    int bad = clock_step_check();
+    rd_create((LBA_t)(mb + mb / 8 + 16) * 2048);
+    if (rd_format(FM_FAT32, 0) != FR_OK || f_mount(&fs, "", 1) != FR_OK) {
+        printf("format failed\n");
+        return 1;
+    }
+
+    log_rotator_t r;
+    if (log_rotate_init(&r) != FR_OK) return 1;
+    uint64_t now_ms = START_MS;
+    uint64_t records = 0;
+    uint32_t segments = (uint32_t)((uint64_t)mb * 1024 * 1024 / LOG_SEGMENT_MAX_BYTES);
+    uint64_t start = rd_clock_us();
+    while (log_index_count() <= segments) {
+        // Batch between index checks: an append only touches index.bin on rotation
+        for (int i = 0; i < 10000; i++) {
+            now_ms += rnd(0, 200);
+            log_record_t rec = {.time_ms = now_ms, .door = (uint8_t)rnd(1, 4)};
+            if (rnd(0, 7) == 0) {
+                rec.type = LOG_BIN_PIR;
+                rec.status = LOG_PIR_MOTION;
+            } else {
+                rec.type = LOG_BIN_ACCESS;
+                rec.status = rnd(0, 9) ? LOG_STATUS_GRANTED : LOG_STATUS_DENIED;
+                rec.len = 4;
+                badge(rnd(0, UIDS - 1), rec.data);
+            }
+            if (log_rotate_append(&r, &rec) != FR_OK || log_rotate_poll(&r, now_ms) != FR_OK) {
+                printf("append failed after %llu records\n", (unsigned long long)records);
+                return 1;
+            }
+            records++;
+        }
+    }
+    log_rotate_close(&r);
+    uint64_t end_ms = now_ms;
+    printf("%llu records in %u segments over %.1f days, written in %.1f s\n",
+           (unsigned long long)records, log_index_count(), (end_ms - START_MS) / 86400000.0,
+           (rd_clock_us() - start) / 1e6);
+
+    static const struct {
+        const char* name;
+        uint64_t span_ms;
+        bool uid;
+    } kinds[] = {
+        {"1 minute", 60000, false},
+        {"1 hour", 3600000, false},
+        {"1 day", 86400000, false},
+        {"1 day, UID", 86400000, true},
+    };
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        cost_t sum = {0}, scan_sum = {0};
+        int scans = 0;
+        for (int i = 0; i < queries; i++) {
+            log_query_t q = {0};
+            uint64_t span = end_ms - START_MS - kinds[k].span_ms;
+            q.from_ms = START_MS + (uint64_t)rnd(0, (uint32_t)(span / 1000)) * 1000;
+            q.to_ms = q.from_ms + kinds[k].span_ms - 1;
+            if (kinds[k].uid) {
+                q.uid_len = 4;
+                badge(rnd(0, UIDS - 1), q.uid);
+            }
+            cost_t c = indexed(&q);
+            sum.reads += c.reads;
+            sum.sectors += c.sectors;
+            sum.records += c.records;
+            sum.us += c.us;
+            sum.matches += c.matches;
+            if (i < 2) {
+                cost_t s = linear_scan(&q);
+                if (s.matches != c.matches) {
+                    printf("%s query %d: %u matches, linear scan finds %u\n", kinds[k].name, i,
+                           c.matches, s.matches);
+                    bad++;
+                }
+                scan_sum.reads += s.reads;
+                scan_sum.sectors += s.sectors;
+                scan_sum.records += s.records;
+                scan_sum.us += s.us;
+                scan_sum.matches += s.matches;
+                scans++;
+            }
+        }
+        printf("%s:\n", kinds[k].name);
+        print_cost("log_query", &sum, queries);
+        if (scans) print_cost("linear scan", &scan_sum, scans);
+    }
+    return bad ? 1 : 0;
+}
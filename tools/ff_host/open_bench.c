@@ -0,0 +1,102 @@
+/*******************************************************************************
+ open_bench - disk_read() calls per f_open() of hot paths in large directories
+ Build: tools/ff_host/build.sh   (builds open_bench with the ffconf.h directory
+        cache and open_bench_nocache with FF_DIR_CACHE=0)
+ Usage: open_bench [opens]       (default: 10000 per directory size)
+
+ A FAT32 RAM card image gets a directory of N files (N = 16, 256, 2048) with
+ long names, like a day's worth of rotated logs, and the hot files the
+ firmware opens over and over (log.txt, index.bin and a config file) are
+ created last, at the end of the directory. Then `opens` f_open()/f_close()
+ pairs in read mode cycle over the hot paths, and it prints disk_read() calls
+ and host time per open. The window cache is disabled in both builds
+ (FF_WIN_CACHE_WAYS=0), so every directory sector scanned is a disk read as
+ on a card. Every 100 opens one file of the directory is renamed and one
+ other deleted and recreated (not counted; each drops the whole directory
+ cache), and each open checks it found the right file by its size, so a
+ stale cache entry would show.
+ Exit: 0 every open found its file, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ramdisk.h"
+
+#define SECTORS 131072 // 64 MB
+
+uint64_t host_us;
+
+static const char *const hot[] = {"/logs/log.txt", "/logs/index.bin", "/logs/door_config.txt"};
+#define HOT (sizeof(hot) / sizeof(hot[0]))
+
+// Creates path with `size` bytes
+static FRESULT make_file(const char *path, UINT size) {
+    static const char fill[64];
+    FIL fil;
+    UINT bw;
+    FRESULT fr = f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fr == FR_OK) fr = f_write(&fil, fill, size, &bw);
+    FRESULT fr2 = f_close(&fil);
+    return fr != FR_OK ? fr : fr2;
+}
+
+static int run(int files, int opens) {
+    static FATFS fs;
+    char path[64], other[64];
+    int bad = 0;
+    rd_create(SECTORS);
+    if (rd_format(FM_FAT32, 0) != FR_OK || f_mount(&fs, "", 1) != FR_OK || f_mkdir("/logs") != FR_OK) {
+        printf("format failed\n");
+        return 1;
+    }
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "/logs/segment_%05d.bin", i);
+        if (make_file(path, 1) != FR_OK) return 1;
+    }
+    for (size_t h = 0; h < HOT; h++) {
+        if (make_file(hot[h], (UINT)(10 + h)) != FR_OK) return 1;
+    }
+    f_mount(NULL, "", 0);
+    f_mount(&fs, "", 1);
+
+    uint64_t reads = 0, us = 0;
+    for (int i = 0; i < opens; i++) {
+        if (i % 100 == 99) {
+            // Churn elsewhere in the directory: a rename, a delete and a create
+            int a = (i / 100) % files, b = (i / 100 + files / 2) % files;
+            snprintf(path, sizeof(path), "/logs/segment_%05d.bin", a);
+            snprintf(other, sizeof(other), "/logs/renamed_%05d.bin", a);
+            f_rename(path, other);
+            f_rename(other, path);
+            snprintf(path, sizeof(path), "/logs/segment_%05d.bin", b);
+            f_unlink(path);
+            make_file(path, 1);
+        }
+        size_t h = (size_t)i % HOT;
+        FIL fil;
+        uint64_t before = rd_stats.reads, start = rd_clock_us();
+        FRESULT fr = f_open(&fil, hot[h], FA_READ);
+        FSIZE_t size = f_size(&fil);
+        f_close(&fil);
+        reads += rd_stats.reads - before;
+        us += rd_clock_us() - start;
+        if (fr != FR_OK || size != 10 + h) {
+            if (bad++ < 3) printf("%d files: open %d of %s found the wrong file\n", files, i, hot[h]);
+        }
+    }
+    printf("%5d files: %7.2f disk_read and %6.2f us per open\n", files, (double)reads / opens,
+           (double)us / opens);
+    f_mount(NULL, "", 0);
+    return bad;
+}
+
+int main(int argc, char **argv) {
+    int opens = argc > 1 ? atoi(argv[1]) : 10000;
+    printf("FF_DIR_CACHE %d, FF_WIN_CACHE_WAYS %d\n", FF_DIR_CACHE, FF_WIN_CACHE_WAYS);
+    static const int sizes[] = {16, 256, 2048};
+    int bad = 0;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) bad += run(sizes[i], opens);
+    return bad ? 1 : 0;
+}
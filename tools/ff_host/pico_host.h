@@ -0,0 +1,20 @@
+/* pico_host.h
+Just enough of the Pico SDK to build the lib_logger sources on a host (see
+build.sh). The RTC is never set and time_us_64() returns host_us, which the
+tools advance themselves.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    int16_t year;
+    int8_t month, day, dotw, hour, min, sec;
+} datetime_t;
+
+extern uint64_t host_us;
+static inline uint64_t time_us_64(void) { return host_us; }
+static inline bool rtc_get_datetime(datetime_t *t) { (void)t; return false; }
+static inline bool rtc_set_datetime(datetime_t *t) { (void)t; return true; }
+static inline void time_init(void) {}
@@ -0,0 +1,100 @@
+/* ramdisk.c
+RAM card image for the FatFs host tools (see ramdisk.h).
+*/
+#include "ramdisk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "diskio.h"
+
+uint8_t *rd_image;
+LBA_t rd_sectors;
+rd_stats_t rd_stats;
+int64_t rd_write_budget = -1;
+bool rd_power_off;
+
+void rd_create(LBA_t sectors) {
+    free(rd_image);
+    rd_image = calloc((size_t)sectors, FF_MAX_SS);
+    if (!rd_image) {
+        fprintf(stderr, "no memory for a %llu-sector image\n", (unsigned long long)sectors);
+        exit(2);
+    }
+    rd_sectors = sectors;
+    rd_power_on();
+}
+
+FRESULT rd_format(BYTE fmt, DWORD au) {
+    static BYTE work[FF_MAX_SS * 8];
+    MKFS_PARM opt = {(BYTE)(fmt | FM_SFD), 2, 0, 0, au};  // Two FATs, like SD cards
+    return f_mkfs("", &opt, work, sizeof(work));
+}
+
+void rd_power_on(void) {
+    rd_write_budget = -1;
+    rd_power_off = false;
+    memset(&rd_stats, 0, sizeof(rd_stats));
+}
+
+uint64_t rd_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+DSTATUS disk_initialize(BYTE pdrv) {
+    return pdrv == 0 && rd_image && !rd_power_off ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_status(BYTE pdrv) {
+    return disk_initialize(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    if (pdrv != 0 || sector + count > rd_sectors) return RES_PARERR;
+    if (rd_power_off) return RES_NOTRDY;
+    memcpy(buff, rd_image + (size_t)sector * FF_MAX_SS, (size_t)count * FF_MAX_SS);
+    rd_stats.reads++;
+    rd_stats.sectors_read += count;
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    if (pdrv != 0 || sector + count > rd_sectors) return RES_PARERR;
+    if (rd_power_off) return RES_NOTRDY;
+    UINT n = count;
+    if (rd_write_budget >= 0 && (int64_t)n > rd_write_budget) {
+        n = (UINT)rd_write_budget;  // The rest of the transfer never reaches the card
+        rd_power_off = true;
+    }
+    if (rd_write_budget >= 0) rd_write_budget -= n;
+    memcpy(rd_image + (size_t)sector * FF_MAX_SS, buff, (size_t)n * FF_MAX_SS);
+    rd_stats.writes++;
+    rd_stats.sectors_written += n;
+    return rd_power_off ? RES_NOTRDY : RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    if (pdrv != 0) return RES_PARERR;
+    switch (cmd) {
+        case CTRL_SYNC:
+            return rd_power_off ? RES_NOTRDY : RES_OK;
+        case GET_SECTOR_COUNT:
+            *(LBA_t *)buff = rd_sectors;
+            return RES_OK;
+        case GET_SECTOR_SIZE:
+            *(WORD *)buff = FF_MAX_SS;
+            return RES_OK;
+        case GET_BLOCK_SIZE:
+            *(DWORD *)buff = 1;
+            return RES_OK;
+    }
+    return RES_PARERR;
+}
+
+DWORD get_fattime(void) {
+    return ((DWORD)(2026 - 1980) << 25) | (10u << 21) | (18u << 16);
+}
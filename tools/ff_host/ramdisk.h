@@ -0,0 +1,41 @@
+/* ramdisk.h
+A card image in RAM behind the FatFs disk I/O interface (diskio.h), for the
+host tools in this directory. Every disk_read()/disk_write() is counted, and
+power can be cut after a given number of sector writes.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ff.h"
+
+typedef struct {
+    uint64_t reads;          // disk_read() calls
+    uint64_t writes;         // disk_write() calls
+    uint64_t sectors_read;
+    uint64_t sectors_written;
+} rd_stats_t;
+
+extern uint8_t *rd_image;    // rd_sectors * FF_MAX_SS bytes
+extern LBA_t rd_sectors;
+extern rd_stats_t rd_stats;
+
+// Sector writes left before the power goes off; negative: no cut. A write
+// that crosses the limit stores only its first sectors. With the power off
+// every disk access fails with RES_NOTRDY until rd_power_on().
+extern int64_t rd_write_budget;
+extern bool rd_power_off;
+
+// Allocates a zeroed image of `sectors` sectors (replacing any previous one)
+void rd_create(LBA_t sectors);
+
+// Creates a volume with f_mkfs(); fmt is FM_FAT, FM_FAT32 or FM_EXFAT, au the
+// cluster size in bytes (0: FatFs default). Returns the f_mkfs() result.
+FRESULT rd_format(BYTE fmt, DWORD au);
+
+// Restores power and clears the counters
+void rd_power_on(void);
+
+// Elapsed wall-clock time in microseconds, for throughput figures
+uint64_t rd_clock_us(void);
@@ -0,0 +1,189 @@
+/*******************************************************************************
+ span_check - Large f_write()s across cluster boundaries on FAT32 and exFAT
+ Build: tools/ff_host/build.sh
+ Usage: span_check
+
+ f_write() sends a sector-aligned write that runs past the current cluster
+ as one disk_write() over all physically adjacent clusters. This runs the
+ writes that cross clusters on a 64 MB RAM card image: 64 KiB into a new
+ file, a 16 KiB append after 4 KiB, twenty 70000-byte appends with the file
+ reopened each time, 64 KiB writes into fragmented free space, and a 64 KiB
+ overwrite in place. It runs on FAT16 with 2 KiB clusters, FAT32 with
+ 512-byte clusters and exFAT with 512-byte and 4 KiB clusters. After each
+ step every file is read back, and a remount with a full free-cluster count
+ (f_getfree()) checks that no cluster was leaked or lost: the free count must
+ drop by exactly the clusters the files hold. It prints the disk_write()
+ calls and sectors of each run.
+ Exit: 0 every write, read back and free count was right, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ramdisk.h"
+
+#define SECTORS 131072 // 64 MB
+#define FRAGS 64       // One-cluster files, every other one deleted
+
+uint64_t host_us;
+
+static FATFS fs;
+static DWORD cluster_bytes, free0, frag_held;
+static uint8_t pattern[70000], back[70000];
+
+typedef struct {
+    const char *path;
+    FSIZE_t size; // Bytes written so far
+} file_t;
+
+static file_t files[] = {{"BIG.BIN", 0}, {"APP.BIN", 0}, {"LOG.BIN", 0}, {"FRAG.BIN", 0}};
+#define NFILES (sizeof(files) / sizeof(files[0]))
+
+// Byte at offset ofs of every file
+static uint8_t byte_at(FSIZE_t ofs) {
+    return (uint8_t)(ofs * 2654435761u >> 13);
+}
+
+static void fill(FSIZE_t ofs, UINT len) {
+    for (UINT i = 0; i < len; i++) pattern[i] = byte_at(ofs + i);
+}
+
+static int failed(const char *name, const char *step, FRESULT fr, UINT got, UINT want) {
+    printf("%s: %s: result %d, %u of %u bytes\n", name, step, fr, got, want);
+    return 1;
+}
+
+// Writes len bytes at ofs of f
+static int write_at(const char *name, const char *step, file_t *f, FSIZE_t ofs, UINT len) {
+    FIL fil;
+    UINT bw = 0;
+    FRESULT fr = f_open(&fil, f->path, FA_OPEN_EXISTING | FA_WRITE);
+    if (fr == FR_OK) fr = f_lseek(&fil, ofs);
+    fill(ofs, len);
+    if (fr == FR_OK) fr = f_write(&fil, pattern, len, &bw);
+    FRESULT fr2 = f_close(&fil);
+    if (fr == FR_OK) fr = fr2;
+    if (fr != FR_OK || bw != len) return failed(name, step, fr, bw, len);
+    if (ofs + len > f->size) f->size = ofs + len;
+    return 0;
+}
+
+static int check(const char *name, const char *step) {
+    f_mount(NULL, "", 0);
+    if (fs.fs_type == FS_FAT32) {
+        uint8_t *fsi = rd_image + (size_t)(rd_image[48] | rd_image[49] << 8) * FF_MAX_SS;
+        memset(fsi + 488, 0xFF, 8); // Free count unknown: f_getfree() scans the FAT
+    }
+    FATFS *pfs;
+    DWORD free_clst, held = 0;
+    if (f_mount(&fs, "", 1) != FR_OK || f_getfree("", &free_clst, &pfs) != FR_OK) {
+        return failed(name, step, FR_DISK_ERR, 0, 0);
+    }
+    for (size_t i = 0; i < NFILES; i++) {
+        FIL fil;
+        FRESULT fr = f_open(&fil, files[i].path, FA_READ);
+        if (fr != FR_OK || f_size(&fil) != files[i].size) {
+            printf("%s: %s: %s has %llu bytes, %llu expected\n", name, step, files[i].path,
+                   (unsigned long long)f_size(&fil), (unsigned long long)files[i].size);
+            return 1;
+        }
+        for (FSIZE_t ofs = 0; ofs < files[i].size;) {
+            UINT br, len = (UINT)(files[i].size - ofs < sizeof(back) ? files[i].size - ofs : sizeof(back));
+            fr = f_read(&fil, back, len, &br);
+            fill(ofs, len);
+            if (fr != FR_OK || br != len || memcmp(back, pattern, len)) {
+                printf("%s: %s: %s differs after byte %llu\n", name, step, files[i].path, (unsigned long long)ofs);
+                return 1;
+            }
+            ofs += len;
+        }
+        f_close(&fil);
+        held += (DWORD)((files[i].size + cluster_bytes - 1) / cluster_bytes);
+    }
+    held += frag_held;
+    if (free_clst != free0 - held) {
+        printf("%s: %s: %lu free clusters, %lu expected\n", name, step, (unsigned long)free_clst,
+               (unsigned long)(free0 - held));
+        return 1;
+    }
+    return 0;
+}
+
+static int run(BYTE fmt, DWORD au, const char *name) {
+    char path[16];
+    FATFS *pfs;
+    rd_create(SECTORS);
+    if (rd_format(fmt, au) != FR_OK || f_mount(&fs, "", 1) != FR_OK) {
+        printf("%s: format failed\n", name);
+        return 1;
+    }
+    cluster_bytes = (DWORD)fs.csize * FF_MAX_SS;
+    // Every directory entry first, so the root does not take a cluster later
+    for (size_t i = 0; i < NFILES; i++) {
+        FIL fil;
+        files[i].size = 0;
+        if (f_open(&fil, files[i].path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK || f_close(&fil) != FR_OK) return 1;
+    }
+    for (int i = 0; i < FRAGS; i++) {
+        FIL fil;
+        snprintf(path, sizeof(path), "F%02d", i);
+        if (f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK || f_close(&fil) != FR_OK) return 1;
+    }
+    frag_held = 0;
+    if (f_getfree("", &free0, &pfs) != FR_OK) return 1;
+    rd_stats_t before = rd_stats;
+
+    if (write_at(name, "64 KiB into a new file", &files[0], 0, 65536) ||
+        check(name, "64 KiB into a new file")) {
+        return 1;
+    }
+    if (write_at(name, "4 KiB", &files[1], 0, 4096) || write_at(name, "16 KiB append", &files[1], 4096, 16384) ||
+        check(name, "16 KiB append")) {
+        return 1;
+    }
+    for (int i = 0; i < 20; i++) {
+        if (write_at(name, "70000-byte append", &files[2], files[2].size, 70000)) return 1;
+    }
+    if (check(name, "70000-byte appends")) return 1;
+
+    // Free space in one-cluster holes, then clusters after the last file
+    for (int i = 0; i < FRAGS; i++) {
+        FIL fil;
+        UINT bw;
+        snprintf(path, sizeof(path), "F%02d", i);
+        if (f_open(&fil, path, FA_OPEN_EXISTING | FA_WRITE) != FR_OK ||
+            f_write(&fil, pattern, cluster_bytes, &bw) != FR_OK ||
+            f_close(&fil) != FR_OK) {
+            return 1;
+        }
+    }
+    for (int i = 0; i < FRAGS; i += 2) {
+        snprintf(path, sizeof(path), "F%02d", i);
+        FIL fil;
+        if (f_open(&fil, path, FA_OPEN_EXISTING | FA_WRITE) != FR_OK || f_truncate(&fil) != FR_OK ||
+            f_close(&fil) != FR_OK) {
+            return 1;
+        }
+    }
+    frag_held = FRAGS / 2;
+    fs.last_clst = 0; // Allocate from the start of the volume, through the holes
+    for (int i = 0; i < 4; i++) {
+        if (write_at(name, "64 KiB into fragmented space", &files[3], files[3].size, 65536)) return 1;
+    }
+    if (check(name, "fragmented space")) return 1;
+    if (write_at(name, "64 KiB overwrite", &files[3], 1000, 65536) || check(name, "64 KiB overwrite")) return 1;
+
+    printf("%-12s ok  disk_write %6llu (%6llu sectors)\n", name, (unsigned long long)(rd_stats.writes - before.writes),
+           (unsigned long long)(rd_stats.sectors_written - before.sectors_written));
+    f_mount(NULL, "", 0);
+    return 0;
+}
+
+int main(void) {
+    int bad = run(FM_FAT, 2048, "FAT16 2048");
+    bad += run(FM_FAT32, 512, "FAT32 512");
+    bad += run(FM_EXFAT, 512, "exFAT 512");
+    bad += run(FM_EXFAT, 4096, "exFAT 4096");
+    return bad ? 1 : 0;
+}
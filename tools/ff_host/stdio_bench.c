@@ -0,0 +1,74 @@
+/*******************************************************************************
+ stdio_bench - Write throughput of ff_fputc()/ff_fwrite() with and without a
+               stream buffer
+ Build: tools/ff_host/build.sh
+ Usage: stdio_bench [kbytes]      (default: 2048)
+
+ Writes `kbytes` KB to a new file on a FAT32 RAM card image in 1-byte
+ ff_fputc() calls and in 64- and 4096-byte ff_fwrite() calls, each on an
+ unbuffered stream and after ff_setvbuf() with a 512-byte _IOFBF, a 4096-byte
+ _IOFBF and a 512-byte _IOLBF buffer. It prints MB/s and the disk_write()
+ calls per run. Every file is then read back after ff_rewind() through the
+ same stream and compared with what was written.
+ Exit: 0 every file read back intact, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff_stdio.h"
+#include "ramdisk.h"
+
+#define SECTORS 131072 // 64 MB
+
+uint64_t host_us;
+
+static uint8_t *data, *back;
+
+static int run(size_t chunk, const char *name, int mode, size_t vbuf, size_t total) {
+    FF_FILE *stream = ff_fopen("out.bin", "w+");
+    if (!stream || (vbuf && ff_setvbuf(stream, NULL, mode, vbuf))) return 1;
+    uint64_t writes = rd_stats.writes, start = rd_clock_us();
+    size_t done = 0;
+    for (; done < total; done += chunk) {
+        if (chunk == 1) {
+            if (ff_fputc(data[done], stream) != data[done]) break;
+        } else if (ff_fwrite(data + done, 1, chunk, stream) != chunk) {
+            break;
+        }
+    }
+    int bad = done < total || ff_fflush(stream) != 0;
+    uint64_t us = rd_clock_us() - start;
+    writes = rd_stats.writes - writes;
+    memset(back, 0, total);
+    bad |= ff_rewind(stream) != 0 || ff_fread(back, 1, total, stream) != total || memcmp(back, data, total);
+    bad |= ff_fclose(stream) != 0;
+    printf("%4u-byte %-8s %-12s %8.1f MB/s  %6llu disk_write%s\n", (unsigned)chunk,
+           chunk == 1 ? "ff_fputc" : "ff_fwrite", name, (double)total / (double)(us ? us : 1),
+           (unsigned long long)writes, bad ? "  FAILED" : "");
+    return bad;
+}
+
+int main(int argc, char **argv) {
+    static FATFS fs;
+    size_t total = (size_t)(argc > 1 ? atoi(argv[1]) : 2048) * 1024;
+    data = malloc(total);
+    back = malloc(total);
+    rd_create(SECTORS);
+    if (!data || !back || rd_format(FM_FAT32, 0) != FR_OK || f_mount(&fs, "", 1) != FR_OK) {
+        printf("setup failed\n");
+        return 1;
+    }
+    for (size_t i = 0; i < total; i++) data[i] = i % 61 == 60 ? '\n' : (uint8_t)('a' + i % 26);
+    static const size_t chunks[] = {1, 64, 4096};
+    int bad = 0;
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        bad += run(chunks[i], "unbuffered", _IONBF, 0, total);
+        bad += run(chunks[i], "_IOFBF 512", _IOFBF, 512, total);
+        bad += run(chunks[i], "_IOFBF 4096", _IOFBF, 4096, total);
+        bad += run(chunks[i], "_IOLBF 512", _IOLBF, 512, total);
+    }
+    f_mount(NULL, "", 0);
+    return bad ? 1 : 0;
+}
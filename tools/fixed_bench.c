@@ -0,0 +1,112 @@
+/*******************************************************************************
+ fixed_bench - Host check and timing of lib_logger/log_fixed against float code
+ Build: cc -O2 -I lib_logger -o fixed_bench tools/fixed_bench.c lib_logger/log_fixed.c
+ Usage: fixed_bench [records]
+
+ Checks log_fixed_format() against an integer-only reference at 0-4 decimals
+ and that log_fixed_parse() reads every formatted value back, then a table of
+ rounding and rejection cases. Then it times one telemetry record both ways:
+ parse a "TEMP_C:23.45" sample and format the min/max/mean of a rollup, with
+ strtod() and "%.2f" (the code before log_fixed) and with log_fixed.
+ Host times only: the host has an FPU, the RP2040 does not, so the float path
+ is much slower there than this ratio shows.
+ For the f_printf code size with and without FF_PRINT_FLOAT/FF_PRINT_LLI:
+   cc -Os -c -DFF_PRINT_FLOAT=1 -DFF_PRINT_LLI=1 -I lib/FatFs_SPI/ff15/source \
+      lib/FatFs_SPI/ff15/source/ff.c && nm -S --size-sort ff.o | grep f_printf
+ Exit: 0 all checks passed, 1 otherwise
+*******************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log_fixed.h"
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd32(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)rng;
+}
+
+static int bad;
+static void check(int ok, const char* what, const char* text) {
+    if (!ok && bad++ < 10) printf("FAIL %s: %s\n", what, text);
+}
+
+// "%d.%0*d" on the magnitude, as an integer-only reference
+static void reference(int32_t v, uint8_t decimals, char* out) {
+    static const uint32_t pow10[] = {1, 10, 100, 1000, 10000};
+    uint32_t mag = v < 0 ? 0u - (uint32_t)v : (uint32_t)v;
+    const char* sign = v < 0 ? "-" : "";
+    if (decimals == 0) {
+        sprintf(out, "%s%" PRIu32, sign, mag);
+    } else {
+        sprintf(out, "%s%" PRIu32 ".%0*" PRIu32, sign, mag / pow10[decimals], decimals, mag % pow10[decimals]);
+    }
+}
+
+static double ns(clock_t start, long n) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / n;
+}
+
+int main(int argc, char** argv) {
+    long records = argc > 1 ? atol(argv[1]) : 1000000;
+    char text[LOG_FIXED_MAX_LEN], expected[32];
+
+    for (long i = 0; i < 1000000; i++) {
+        int32_t v = (int32_t)rnd32();
+        if (i % 3 == 0) v %= 100000; // Sensor-sized values too
+        uint8_t decimals = (uint8_t)(i % (LOG_FIXED_MAX_DECIMALS + 1));
+        size_t n = log_fixed_format(v, decimals, text);
+        reference(v, decimals, expected);
+        check(n == strlen(expected) && strcmp(text, expected) == 0, "format", expected);
+        int32_t back;
+        check(log_fixed_parse(text, decimals, &back) && back == v, "parse back", text);
+    }
+
+    static const struct {
+        const char* text;
+        uint8_t decimals;
+        int ok;
+        int32_t value;
+    } cases[] = {
+        {"23.45", 2, 1, 2345},   {"23.455", 2, 1, 2346}, {"23.454", 2, 1, 2345}, {"-0.005", 2, 1, -1},
+        {"+7", 2, 1, 700},       {"1013.25", 1, 1, 10133}, {".5", 2, 1, 50},    {"5.", 2, 1, 500},
+        {"nan", 2, 0, 0},        {"", 2, 0, 0},           {"1e3", 2, 0, 0},     {"-", 2, 0, 0},
+        {"21474836.48", 2, 0, 0}, {"-21474836.48", 2, 1, INT32_MIN},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int32_t v = 0;
+        int ok = log_fixed_parse(cases[i].text, cases[i].decimals, &v);
+        check(ok == cases[i].ok && (!ok || v == cases[i].value), "case", cases[i].text);
+    }
+    printf("%s: %d failures\n", bad ? "FAIL" : "ok", bad);
+
+    // One telemetry record: parse a sample, format min/max/mean of a rollup
+    static const char* samples[] = {"TEMP_C:23.45", "TEMP_C:-3.10", "TEMP_C:101.99", "TEMP_C:7.00"};
+    char line[64];
+    volatile size_t sink = 0;
+    clock_t start = clock();
+    for (long i = 0; i < records; i++) {
+        double t = strtod(samples[i & 3] + 7, NULL);
+        sink += (size_t)snprintf(line, sizeof(line), "min=%.2f max=%.2f mean=%.2f", t - 0.5, t + 0.5, t);
+    }
+    double float_ns = ns(start, records);
+    start = clock();
+    for (long i = 0; i < records; i++) {
+        int32_t t = 0;
+        char lo[LOG_FIXED_MAX_LEN], hi[LOG_FIXED_MAX_LEN], mean[LOG_FIXED_MAX_LEN];
+        log_fixed_parse(samples[i & 3] + 7, 2, &t);
+        log_fixed_format(t - 50, 2, lo);
+        log_fixed_format(t + 50, 2, hi);
+        log_fixed_format(t, 2, mean);
+        sink += (size_t)snprintf(line, sizeof(line), "min=%s max=%s mean=%s", lo, hi, mean);
+    }
+    double fixed_ns = ns(start, records);
+    printf("per record: strtod + %%.2f %.0f ns, log_fixed %.0f ns\n", float_ns, fixed_ns);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/*******************************************************************************
+ log_decode - Host tool that converts binary access log segments to text
+ Build: cc -O2 -I../lib_logger -I../lib/FatFs_SPI/sd_driver -I../lib/FatFs_SPI/ff15/source \
+           -o log_decode log_decode.c ../lib_logger/log_binary.c ../lib_logger/log_fixed.c \
+           ../lib/FatFs_SPI/sd_driver/crc.c
+ Usage: log_decode [--text|--csv|--json] logs/20261018-001.bin [more.bin ...]
+        log_decode --index logs/index.bin
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log_binary.h"
+#include "log_fixed.h"
+#include "log_rotate.h" // log_index_entry_t
+
+typedef enum { OUT_TEXT, OUT_CSV, OUT_JSON } out_mode_t;
+
+static void format_time(uint64_t ms, char* out, size_t size) {
+    time_t secs = (time_t)(ms / 1000);
+    struct tm tm;
+    gmtime_r(&secs, &tm);
+    size_t n = strftime(out, size, "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(out + n, size - n, ".%03u", (unsigned)(ms % 1000));
+}
+
+// Text payload of a record: hex UID for access records, rollup fields for
+// telemetry, raw text otherwise
+static void format_data(const log_record_t* rec, char* out) {
+    int32_t min, max, mean;
+    uint16_t count;
+    if (rec->type == LOG_BIN_ACCESS) {
+        log_bin_uid_to_hex(rec->data, rec->len, out);
+    } else if (rec->type == LOG_BIN_TELEMETRY && log_bin_telemetry_unpack(rec, &min, &max, &mean, &count)) {
+        char a[LOG_FIXED_MAX_LEN], b[LOG_FIXED_MAX_LEN], c[LOG_FIXED_MAX_LEN];
+        log_fixed_format(min, 2, a); // Telemetry rollups are in hundredths
+        log_fixed_format(max, 2, b);
+        log_fixed_format(mean, 2, c);
+        sprintf(out, "min=%s max=%s mean=%s n=%u", a, b, c, count);
+    } else {
+        for (uint8_t i = 0; i < rec->len; i++) {
+            char c = (char)rec->data[i];
+            out[i] = (c == '"' || c == '\\' || c < 0x20) ? '?' : c;
+        }
+        out[rec->len] = '\0';
+    }
+}
+
+static void print_record(out_mode_t mode, const log_record_t* rec, int* first) {
+    char stamp[32];
+    char data[2 * LOG_BIN_MAX_DATA + 1];
+    format_time(rec->time_ms, stamp, sizeof(stamp));
+    format_data(rec, data);
+    const char* type = log_bin_type_str(rec->type);
+    const char* status = log_bin_status_str(rec->status);
+
+    switch (mode) {
+        case OUT_CSV:
+            printf("%s,%llu,%u,%s,%s,\"%s\"\n", stamp, (unsigned long long)rec->time_ms,
+                   rec->door, type, status, data);
+            break;
+        case OUT_JSON:
+            printf("%s\n  {\"time\":\"%s\",\"epoch_ms\":%llu,\"door\":%u,\"type\":\"%s\",\"status\":\"%s\",\"data\":\"%s\"}",
+                   *first ? "" : ",", stamp, (unsigned long long)rec->time_ms, rec->door, type, status, data);
+            break;
+        default:
+            if (rec->type == LOG_BIN_ACCESS) {
+                printf("%s door%u %s: UID=%s, Status=%s\n", stamp, rec->door, type, data, status);
+            } else if (rec->type == LOG_BIN_TELEMETRY) {
+                printf("%s door%u %s: %s %s\n", stamp, rec->door, type, status, data);
+            } else if (rec->type == LOG_BIN_PIR && rec->status != LOG_PIR_OTHER) {
+                printf("%s door%u %s: %s\n", stamp, rec->door, type, status);
+            } else {
+                printf("%s door%u %s: %s\n", stamp, rec->door, type, data);
+            }
+            break;
+    }
+    *first = 0;
+}
+
+static int decode_file(const char* path, out_mode_t mode, int* first) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = malloc(size > 0 ? size : 1);
+    if (!buf || fread(buf, 1, size, f) != (size_t)size) {
+        fprintf(stderr, "%s: read error\n", path);
+        fclose(f);
+        free(buf);
+        return 1;
+    }
+    fclose(f);
+
+    uint16_t nonce;
+    if (!log_bin_check_header(buf, size, &nonce)) {
+        fprintf(stderr, "%s: not a binary log (bad header)\n", path);
+        free(buf);
+        return 1;
+    }
+
+    log_bin_reader_t reader;
+    log_bin_reader_init(&reader, nonce);
+    size_t pos = LOG_BIN_HEADER_SIZE;
+    unsigned long records = 0, skipped = 0, gaps = 0;
+    int have_seq = 0;
+    uint8_t next_seq = 0;
+    while (pos < (size_t)size) {
+        log_record_t rec;
+        int n = log_bin_decode(&reader, &buf[pos], size - pos, &rec);
+        if (n == 0) {
+            fprintf(stderr, "%s: truncated record at offset %zu\n", path, pos);
+            break;
+        }
+        if (n < 0) {
+            // Unused preallocated space of a segment that was never closed
+            size_t z = pos;
+            while (z < (size_t)size && buf[z] == 0) z++;
+            if (z == (size_t)size) break;
+            skipped++; // Corrupt byte: slide forward until a record checks out
+            pos++;
+            continue;
+        }
+        if (rec.type == LOG_BIN_PAD) {
+            pos += n;
+            continue;
+        }
+        if (have_seq && rec.seq != next_seq) gaps++;
+        have_seq = 1;
+        next_seq = rec.seq + 1;
+        pos += n;
+        if (rec.type != LOG_BIN_SYNC) {
+            print_record(mode, &rec, first);
+            records++;
+        }
+    }
+    fprintf(stderr, "%s: %lu records, %lu bytes skipped, %lu sequence gaps\n",
+            path, records, skipped, gaps);
+    free(buf);
+    return 0;
+}
+
+// Prints the segment index written by log_rotate.c as CSV
+static int print_index(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    log_index_entry_t e;
+    printf("segment,first,last,records,bytes\n");
+    while (fread(&e, sizeof(e), 1, f) == 1) {
+        char first[32], last[32];
+        e.name[LOG_SEGMENT_NAME_LEN - 1] = '\0';
+        format_time(e.first_ms, first, sizeof(first));
+        format_time(e.last_ms, last, sizeof(last));
+        printf("%s,%s,%s,%u,%u\n", e.name, first, last, e.records, e.bytes);
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "--index") == 0) {
+        return print_index(argv[2]);
+    }
+
+    out_mode_t mode = OUT_TEXT;
+    int argi = 1;
+    if (argi < argc && strncmp(argv[argi], "--", 2) == 0) {
+        if (strcmp(argv[argi], "--csv") == 0) mode = OUT_CSV;
+        else if (strcmp(argv[argi], "--json") == 0) mode = OUT_JSON;
+        else if (strcmp(argv[argi], "--text") != 0) argi = argc; // Unknown option
+        argi++;
+    }
+    if (argi >= argc) {
+        fprintf(stderr, "Usage: %s [--text|--csv|--json] segment.bin [more.bin ...]\n"
+                        "       %s --index index.bin\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    int first = 1;
+    int rc = 0;
+    if (mode == OUT_CSV) printf("time,epoch_ms,door,type,status,data\n");
+    if (mode == OUT_JSON) printf("[");
+    for (; argi < argc; argi++) {
+        rc |= decode_file(argv[argi], mode, &first);
+    }
+    if (mode == OUT_JSON) printf("\n]\n");
+    return rc;
+}
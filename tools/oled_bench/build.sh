@@ -0,0 +1,21 @@
+#!/bin/sh
+# Builds the OLED benchmarks with lib_ssd1306: tools/oled_bench/build.sh [outdir]
+# The Pico SDK headers lib_ssd1306 includes all map to pico_host.h.
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$HERE/../..
+OUT=${1:-$HERE}
+mkdir -p "$OUT"
+INC=$(mktemp -d)
+trap 'rm -rf "$INC"' EXIT
+
+mkdir -p "$INC/hardware" "$INC/pico"
+for h in _ansi.h hardware/i2c.h pico/binary_info.h pico/stdlib.h; do
+    echo '#include "pico_host.h"' > "$INC/$h"
+done
+
+SSD1306="$ROOT/lib_ssd1306/ssd1306.c $ROOT/lib_ssd1306/ssd1306_fonts.c $ROOT/lib_ssd1306/ssd1306_bitmaps.c"
+${CC:-cc} -O2 -g -Wall $CFLAGS -I"$INC" -I"$HERE" -I"$ROOT/lib_ssd1306" \
+    -o "$OUT/widget_bench" "$HERE/widget_bench.c" $SSD1306 "$ROOT/lib_ssd1306/ssd1306_widgets.c"
+${CC:-cc} -O2 -g -Wall $CFLAGS -I"$INC" -I"$HERE" -I"$ROOT/lib_ssd1306" \
+    -o "$OUT/draw_bench" "$HERE/draw_bench.c" $SSD1306 -lm
@@ -0,0 +1,326 @@
+/*******************************************************************************
+ draw_bench - Drawing primitives of lib_ssd1306 against the per-pixel code
+ Build: tools/oled_bench/build.sh   (compiles lib_ssd1306 with it)
+ Usage: draw_bench [cases] [calls]   (default: 20000 checked, 200000 timed)
+
+ The code the primitives had before the span fills and the integer arcs is
+ kept below as old_*(): FillRectangle, FillTriangle and FillCircle set one
+ pixel at a time through ssd1306_DrawPixel(), DrawRectangle and axis-aligned
+ lines go through Bresenham, and DrawArc uses sinf()/cosf() on float degrees.
+ For each primitive, `cases` random calls are drawn both ways on a random
+ background and the frames read back through ssd1306_UpdateScreen() must be
+ the same. Arcs are not compared pixel by pixel (the sine table rounds where
+ sinf() truncated); for full circles of radius 3..30 the largest distance of
+ an arc pixel from the true radius is printed for both instead. Then `calls`
+ random calls of each are timed and the primitives per second printed.
+ ssd1306_InvertRectangle() was already byte-wise and is not listed.
+ Host times only: the RP2040 has no FPU, so the old arcs are much slower
+ there than this ratio shows.
+ Exit: 0 every compared frame matched, 1 otherwise
+*******************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssd1306.h"
+
+uint64_t host_us, i2c_bytes, i2c_bus_us;
+uint8_t i2c_data[1024];
+size_t i2c_data_len;
+
+// ---------------------------------------------------------------------------
+// The primitives before the fast paths
+
+static void old_Line(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
+    int32_t deltaX = abs(x2 - x1);
+    int32_t deltaY = abs(y2 - y1);
+    int32_t signX = ((x1 < x2) ? 1 : -1);
+    int32_t signY = ((y1 < y2) ? 1 : -1);
+    int32_t error = deltaX - deltaY;
+    int32_t error2;
+
+    ssd1306_DrawPixel(x2, y2, color);
+    while ((x1 != x2) || (y1 != y2)) {
+        ssd1306_DrawPixel(x1, y1, color);
+        error2 = error * 2;
+        if (error2 > -deltaY) {
+            error -= deltaY;
+            x1 += signX;
+        }
+        if (error2 < deltaX) {
+            error += deltaX;
+            y1 += signY;
+        }
+    }
+}
+
+static void old_DrawRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
+    old_Line(x1, y1, x2, y1, color);
+    old_Line(x2, y1, x2, y2, color);
+    old_Line(x2, y2, x1, y2, color);
+    old_Line(x1, y2, x1, y1, color);
+}
+
+static void old_FillRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
+    uint8_t x_start = ((x1 <= x2) ? x1 : x2);
+    uint8_t x_end = ((x1 <= x2) ? x2 : x1);
+    uint8_t y_start = ((y1 <= y2) ? y1 : y2);
+    uint8_t y_end = ((y1 <= y2) ? y2 : y1);
+
+    for (uint8_t y = y_start; (y <= y_end) && (y < SSD1306_HEIGHT); y++) {
+        for (uint8_t x = x_start; (x <= x_end) && (x < SSD1306_WIDTH); x++) {
+            ssd1306_DrawPixel(x, y, color);
+        }
+    }
+}
+
+// Loops forever when the circle touches row or column 0 (uint8_t counters)
+static void old_FillCircle(uint8_t par_x, uint8_t par_y, uint8_t par_r, SSD1306_COLOR par_color) {
+    int32_t x = -par_r;
+    int32_t y = 0;
+    int32_t err = 2 - 2 * par_r;
+    int32_t e2;
+
+    if (par_x >= SSD1306_WIDTH || par_y >= SSD1306_HEIGHT) {
+        return;
+    }
+    do {
+        for (uint8_t _y = (par_y + y); _y >= (par_y - y); _y--) {
+            for (uint8_t _x = (par_x - x); _x >= (par_x + x); _x--) {
+                ssd1306_DrawPixel(_x, _y, par_color);
+            }
+        }
+        e2 = err;
+        if (e2 <= y) {
+            y++;
+            err = err + (y * 2 + 1);
+            if (-x == y && e2 <= x) {
+                e2 = 0;
+            }
+        }
+        if (e2 > x) {
+            x++;
+            err = err + (x * 2 + 1);
+        }
+    } while (x <= 0);
+}
+
+static inline void swap_int16(int16_t* a, int16_t* b) {
+    int16_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void old_FillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2,
+                             SSD1306_COLOR color) {
+    int16_t ax = x0, ay = y0;
+    int16_t bx = x1, by = y1;
+    int16_t cx = x2, cy = y2;
+
+    if (ay > by) { swap_int16(&ax, &bx); swap_int16(&ay, &by); }
+    if (by > cy) { swap_int16(&bx, &cx); swap_int16(&by, &cy); }
+    if (ay > by) { swap_int16(&ax, &bx); swap_int16(&ay, &by); }
+
+    int16_t dx01 = bx - ax, dy01 = by - ay;
+    int16_t dx02 = cx - ax, dy02 = cy - ay;
+    int16_t dx12 = cx - bx, dy12 = cy - by;
+    int16_t a, b, y, last;
+
+    if (by == cy) last = by;
+    else last = by - 1;
+
+    for (y = ay; y <= last; y++) {
+        a = ax + (dx01 * (y - ay)) / (dy01 ? dy01 : 1);
+        b = ax + (dx02 * (y - ay)) / (dy02 ? dy02 : 1);
+        if (a > b) { int16_t t = a; a = b; b = t; }
+        for (int16_t x = a; x <= b; x++) {
+            ssd1306_DrawPixel(x, y, color);
+        }
+    }
+    for (y = by; y <= cy; y++) {
+        a = bx + (dx12 * (y - by)) / (dy12 ? dy12 : 1);
+        b = ax + (dx02 * (y - ay)) / (dy02 ? dy02 : 1);
+        if (a > b) { int16_t t = a; a = b; b = t; }
+        for (int16_t x = a; x <= b; x++) {
+            ssd1306_DrawPixel(x, y, color);
+        }
+    }
+}
+
+static uint16_t old_NormalizeTo0_360(uint16_t par_deg) {
+    uint16_t loc_angle;
+    if (par_deg <= 360) {
+        loc_angle = par_deg;
+    } else {
+        loc_angle = par_deg % 360;
+        loc_angle = (loc_angle ? loc_angle : 360);
+    }
+    return loc_angle;
+}
+
+static void old_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep,
+                        SSD1306_COLOR color) {
+    static const uint8_t CIRCLE_APPROXIMATION_SEGMENTS = 36;
+    uint32_t loc_sweep = old_NormalizeTo0_360(sweep);
+    uint32_t count = (old_NormalizeTo0_360(start_angle) * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
+    uint32_t approx_segments = (loc_sweep * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
+    float approx_degree = loc_sweep / (float)approx_segments;
+    while (count < approx_segments) {
+        float rad = count * approx_degree * (3.14f / 180.0f);
+        uint8_t xp1 = x + (int8_t)(sinf(rad) * radius);
+        uint8_t yp1 = y + (int8_t)(cosf(rad) * radius);
+        count++;
+        rad = (count != approx_segments ? count * approx_degree : loc_sweep) * (3.14f / 180.0f);
+        uint8_t xp2 = x + (int8_t)(sinf(rad) * radius);
+        uint8_t yp2 = y + (int8_t)(cosf(rad) * radius);
+        old_Line(xp1, yp1, xp2, yp2, color);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+typedef enum { FILL_RECT, DRAW_RECT, HV_LINE, LINE, FILL_TRIANGLE, FILL_CIRCLE, DRAW_ARC, PRIMITIVES } primitive_t;
+
+static const char* const names[PRIMITIVES] = {
+    "FillRectangle", "DrawRectangle", "H/V Line", "Line", "FillTriangle", "FillCircle", "DrawArc",
+};
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd(uint32_t n) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng % n);
+}
+
+typedef struct {
+    uint8_t a, b, c, d, e, f;
+    uint16_t start, sweep;
+    SSD1306_COLOR color;
+} args_t;
+
+static args_t random_args(primitive_t p) {
+    args_t g = {rnd(SSD1306_WIDTH), rnd(SSD1306_HEIGHT), rnd(SSD1306_WIDTH), rnd(SSD1306_HEIGHT),
+                rnd(SSD1306_WIDTH), rnd(SSD1306_HEIGHT), rnd(400), rnd(400), rnd(2) ? White : Black};
+    if (p == HV_LINE) {
+        if (rnd(2)) g.d = g.b; // Horizontal
+        else g.c = g.a;        // Vertical
+    } else if (p == FILL_CIRCLE) {
+        // Off rows and columns 0, where the old code never returns
+        g.e = rnd(20);
+        g.a = g.e + 1 + rnd(SSD1306_WIDTH - 2 - 2 * g.e);
+        g.b = g.e + 1 + rnd(SSD1306_HEIGHT - 2 - 2 * g.e);
+    } else if (p == DRAW_ARC) {
+        g.a = SSD1306_WIDTH / 2;
+        g.b = SSD1306_HEIGHT / 2;
+        g.e = rnd(30);
+    }
+    return g;
+}
+
+static void draw(primitive_t p, const args_t* g, bool old) {
+    switch (p) {
+    case FILL_RECT:
+        (old ? old_FillRectangle : ssd1306_FillRectangle)(g->a, g->b, g->c, g->d, g->color);
+        break;
+    case DRAW_RECT:
+        (old ? old_DrawRectangle : ssd1306_DrawRectangle)(g->a, g->b, g->c, g->d, g->color);
+        break;
+    case HV_LINE:
+    case LINE:
+        (old ? old_Line : ssd1306_Line)(g->a, g->b, g->c, g->d, g->color);
+        break;
+    case FILL_TRIANGLE:
+        (old ? old_FillTriangle : ssd1306_FillTriangle)(g->a, g->b, g->c, g->d, g->e, g->f, g->color);
+        break;
+    case FILL_CIRCLE:
+        (old ? old_FillCircle : ssd1306_FillCircle)(g->a, g->b, g->e, g->color);
+        break;
+    case DRAW_ARC:
+        (old ? old_DrawArc : ssd1306_DrawArc)(g->a, g->b, g->e, g->start, g->sweep, g->color);
+        break;
+    default:
+        break;
+    }
+}
+
+static const uint8_t* read_frame(void) {
+    i2c_data_len = 0;
+    ssd1306_UpdateScreen();
+    return i2c_data;
+}
+
+static bool pixel(const uint8_t* frame, int x, int y) {
+    return frame[(y / 8) * SSD1306_WIDTH + x] & (1 << (y % 8));
+}
+
+// Largest distance of a set pixel from the radius, full circle around the centre
+static double arc_error(bool old, uint8_t radius) {
+    ssd1306_Fill(Black);
+    (old ? old_DrawArc : ssd1306_DrawArc)(SSD1306_WIDTH / 2, SSD1306_HEIGHT / 2, radius, 0, 360, White);
+    const uint8_t* frame = read_frame();
+    double worst = 0;
+    for (int y = 0; y < SSD1306_HEIGHT; y++) {
+        for (int x = 0; x < SSD1306_WIDTH; x++) {
+            if (!pixel(frame, x, y)) continue;
+            double d = fabs(hypot(x - SSD1306_WIDTH / 2, y - SSD1306_HEIGHT / 2) - radius);
+            if (d > worst) worst = d;
+        }
+    }
+    return worst;
+}
+
+static double per_second(primitive_t p, bool old, long calls, uint64_t seed) {
+    rng = seed;
+    ssd1306_Fill(Black);
+    clock_t start = clock();
+    for (long i = 0; i < calls; i++) {
+        args_t g = random_args(p);
+        draw(p, &g, old);
+    }
+    return calls / ((double)(clock() - start) / CLOCKS_PER_SEC);
+}
+
+int main(int argc, char** argv) {
+    long cases = argc > 1 ? atol(argv[1]) : 20000;
+    long calls = argc > 2 ? atol(argv[2]) : 200000;
+    static uint8_t background[SSD1306_BUFFER_SIZE], expected[SSD1306_BUFFER_SIZE];
+    int bad = 0;
+
+    for (int p = 0; p < DRAW_ARC; p++) {
+        long diffs = 0;
+        for (long i = 0; i < cases; i++) {
+            for (size_t k = 0; k < sizeof(background); k++) background[k] = (uint8_t)rnd(256);
+            args_t g = random_args(p);
+            ssd1306_FillBuffer(background, sizeof(background));
+            draw(p, &g, true);
+            memcpy(expected, read_frame(), sizeof(expected));
+            ssd1306_FillBuffer(background, sizeof(background));
+            draw(p, &g, false);
+            if (memcmp(expected, read_frame(), sizeof(expected)) != 0 && diffs++ < 3) {
+                printf("%s(%u, %u, %u, %u, %u, %u): frame differs\n", names[p], g.a, g.b, g.c, g.d, g.e, g.f);
+            }
+        }
+        printf("%-14s %ld of %ld frames differ\n", names[p], diffs, cases);
+        bad += diffs > 0;
+    }
+    double old_worst = 0, new_worst = 0;
+    for (uint8_t r = 3; r <= 30; r++) {
+        old_worst = fmax(old_worst, arc_error(true, r));
+        new_worst = fmax(new_worst, arc_error(false, r));
+    }
+    printf("%-14s worst radial error, radius 3..30: old %.2f px, new %.2f px\n", names[DRAW_ARC], old_worst,
+           new_worst);
+
+    printf("primitives per second (host):\n");
+    for (int p = 0; p < PRIMITIVES; p++) {
+        uint64_t seed = 0x2545F4914F6CDD1Dull + p;
+        double old = per_second(p, true, calls, seed);
+        double now = per_second(p, false, calls, seed);
+        printf("  %-14s old %10.0f  new %10.0f  x%.1f\n", names[p], old, now, now / old);
+    }
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+/* pico_host.h
+Just enough of the Pico SDK to build lib_ssd1306 on a host (see
+widget_bench.c and draw_bench.c). i2c_write_blocking() sends nothing: it
+counts the bytes, moves the virtual clock by the time the transfer takes on a
+400 kHz bus and keeps the data bytes (after a 0x40 control byte) in i2c_data.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define _BEGIN_STD_C
+#define _END_STD_C
+
+typedef unsigned int uint;
+typedef struct i2c_inst i2c_inst_t;
+typedef uint64_t absolute_time_t;
+#define i2c1 ((i2c_inst_t*)1)
+#define GPIO_FUNC_I2C 3
+
+extern uint64_t host_us;      // Virtual time, bus transfers included
+extern uint64_t i2c_bytes;    // Bytes written, address byte not counted
+extern uint64_t i2c_bus_us;   // Time the bus was busy
+extern uint8_t i2c_data[1024]; // Data bytes since i2c_data_len was last reset
+extern size_t i2c_data_len;
+
+// Start, address byte, n bytes of 9 bits (ACK) and stop: 2.5 us per bit
+static inline int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+    (void)i2c;
+    (void)addr;
+    (void)nostop;
+    if (len > 0 && src[0] == 0x40) {
+        size_t n = len - 1 < sizeof(i2c_data) - i2c_data_len ? len - 1 : sizeof(i2c_data) - i2c_data_len;
+        memcpy(i2c_data + i2c_data_len, src + 1, n);
+        i2c_data_len += n;
+    }
+    uint64_t us = ((len + 1) * 9 + 2) * 5 / 2;
+    i2c_bytes += len;
+    i2c_bus_us += us;
+    host_us += us;
+    return (int)len;
+}
+
+static inline uint i2c_init(i2c_inst_t* i2c, uint baudrate) {
+    (void)i2c;
+    return baudrate;
+}
+static inline void gpio_set_function(uint gpio, int fn) {
+    (void)gpio;
+    (void)fn;
+}
+static inline void gpio_pull_up(uint gpio) { (void)gpio; }
+static inline void sleep_ms(uint32_t ms) { host_us += (uint64_t)ms * 1000; }
+static inline absolute_time_t get_absolute_time(void) { return host_us; }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+static inline uint64_t time_us_64(void) { return host_us; }
@@ -0,0 +1,270 @@
+/*******************************************************************************
+ widget_bench - Bytes and time per OLED refresh: full frame vs retained widgets
+ Build: tools/oled_bench/build.sh   (compiles lib_ssd1306 with it)
+ Usage: widget_bench [minutes]     (default: 60 minutes of virtual time)
+
+ Replays the main loop's display refresh (every 250 ms) for both screens of
+ main.c over `minutes`, with a badge read every 20 s (UID and status line
+ change, the status goes back to waiting 3 s later), PIR motion toggling every
+ 7 s, the clock changing every minute and, on the telemetry screen, a new
+ reading every 5 s and a new sparkline point every minute. Each refresh is
+ drawn two ways:
+   full frame - the code before the widgets: ssd1306_Fill(Black), the text
+                lines through snprintf() + ssd1306_WriteString(), the
+                sparklines drawn point by point, ssd1306_UpdateScreen()
+   widgets    - the setters of display_status()/display_telemetry() and
+                ssd1306_WidgetsRender(), as main.c does now
+ and the same values are shown by both (the old header had no clock; it is
+ given one here). For each screen it prints the bytes written on the I2C bus
+ and the bus time per refresh (400 kHz, counted by the i2c_write_blocking()
+ stub in pico_host.h), the host CPU time per refresh, and how many refreshes
+ sent anything. Host CPU times only give the ratio between the two.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssd1306.h"
+#include "ssd1306_bitmaps.h"
+#include "ssd1306_fonts.h"
+#include "ssd1306_widgets.h"
+
+#define REFRESH_MS 250
+#define MINUTES 60 // Sparkline points, as TELEM_MINUTES
+
+uint64_t host_us, i2c_bytes, i2c_bus_us;
+uint8_t i2c_data[1024];
+size_t i2c_data_len;
+
+// What the screens show at one refresh
+typedef struct {
+    char clock[6];
+    char uid[16];
+    const char* pir;
+    bool motion;
+    const char* status;
+    char temp[16], press[16];
+    int32_t temp_points[MINUTES], press_points[MINUTES];
+    uint8_t points;
+} screen_state_t;
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd(uint32_t n) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng % n);
+}
+
+static void state_at(uint32_t ms, screen_state_t* s) {
+    uint32_t minute = ms / 60000;
+    snprintf(s->clock, sizeof(s->clock), "%02u:%02u", (unsigned)(8 + minute / 60) % 24, (unsigned)minute % 60);
+    uint32_t badge = ms / 20000;
+    if (badge == 0) {
+        strcpy(s->uid, "None");
+    } else {
+        snprintf(s->uid, sizeof(s->uid), "%08X", (unsigned)(badge * 0x9E3779B1u));
+    }
+    s->status = badge > 0 && ms % 20000 < 3000 ? (badge % 5 ? "ACCESS GRANTED" : "ACCESS DENIED") : "Waiting for card";
+    s->motion = (ms / 7000) % 2 == 1;
+    s->pir = s->motion ? "MOTION" : "Idle";
+    uint32_t sample = ms / 5000;
+    snprintf(s->temp, sizeof(s->temp), "%d.%02d", 21 + (int)(sample % 7) / 3, (int)(sample * 37 % 100));
+    snprintf(s->press, sizeof(s->press), "%d.%d", 1013 - (int)(sample % 5), (int)(sample % 10));
+    // A point per closed minute, last hour only
+    s->points = minute < MINUTES ? (uint8_t)minute : MINUTES;
+}
+
+// ---------------------------------------------------------------------------
+// Full frame: display_status()/display_telemetry() before the widgets
+
+static void full_status(const screen_state_t* s) {
+    char buffer[32];
+    ssd1306_Fill(Black);
+
+    ssd1306_SetCursor(0, 0);
+    snprintf(buffer, sizeof(buffer), "ACCESS MONITOR  %s", s->clock);
+    ssd1306_WriteString(buffer, Font_6x8, White);
+
+    ssd1306_SetCursor(0, 16);
+    snprintf(buffer, sizeof(buffer), "UID: %s", s->uid);
+    ssd1306_WriteString(buffer, Font_6x8, White);
+
+    ssd1306_SetCursor(0, 32);
+    snprintf(buffer, sizeof(buffer), "PIR: %s", s->pir);
+    ssd1306_WriteString(buffer, Font_6x8, White);
+    if (s->motion) {
+        ssd1306_DrawBitmap(SSD1306_WIDTH - 8, 32, motion_bitmap, 8, 8, White);
+    }
+
+    ssd1306_SetCursor(0, 48);
+    ssd1306_WriteString((char*)s->status, Font_6x8, White);
+
+    ssd1306_UpdateScreen();
+}
+
+// draw_sparkline() of the old main.c, on the same points
+static void full_sparkline(const int32_t* points, uint8_t count, uint8_t y, uint8_t height) {
+    const uint8_t step = SSD1306_WIDTH / MINUTES;
+    int32_t lo = INT32_MAX, hi = INT32_MIN;
+    for (uint8_t i = 0; i < count; i++) {
+        if (points[i] < lo) lo = points[i];
+        if (points[i] > hi) hi = points[i];
+    }
+    if (lo > hi) {
+        return;
+    }
+    int32_t range = hi - lo;
+    int prev_x = -1, prev_y = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        int x = (MINUTES - count + i) * step;
+        int py = range == 0 ? y + height / 2
+                            : y + height - 1 - (int)((int64_t)(points[i] - lo) * (height - 1) / range);
+        if (prev_x >= 0) {
+            ssd1306_Line(prev_x, prev_y, x, py, White);
+        } else {
+            ssd1306_DrawPixel(x, py, White);
+        }
+        prev_x = x;
+        prev_y = py;
+    }
+}
+
+static void full_telemetry(const screen_state_t* s) {
+    char buffer[32];
+    ssd1306_Fill(Black);
+    ssd1306_SetCursor(0, 0);
+    snprintf(buffer, sizeof(buffer), "DOOR T %s C", s->temp);
+    ssd1306_WriteString(buffer, Font_6x8, White);
+    full_sparkline(s->temp_points, s->points, 10, 20);
+    ssd1306_SetCursor(0, 32);
+    snprintf(buffer, sizeof(buffer), "P %s hPa", s->press);
+    ssd1306_WriteString(buffer, Font_6x8, White);
+    full_sparkline(s->press_points, s->points, 42, 20);
+    ssd1306_UpdateScreen();
+}
+
+// ---------------------------------------------------------------------------
+// Widgets: display_init()/display_status()/display_telemetry() of main.c
+
+static SSD1306_Widget_t header_bar, uid_label, pir_label, motion_icon, status_label;
+static SSD1306_Widget_t* const status_screen[] = {&header_bar, &uid_label, &pir_label, &motion_icon, &status_label};
+static SSD1306_Widget_t temp_label, temp_sparkline, press_label, press_sparkline;
+static SSD1306_Widget_t* const telemetry_screen[] = {&temp_label, &temp_sparkline, &press_label, &press_sparkline};
+
+static void widgets_init(void) {
+    ssd1306_WidgetStatusBar(&header_bar, 0, &Font_6x8);
+    ssd1306_WidgetLabel(&uid_label, 0, 16, SSD1306_WIDTH, &Font_6x8);
+    ssd1306_WidgetLabel(&pir_label, 0, 32, SSD1306_WIDTH - 10, &Font_6x8);
+    ssd1306_WidgetIcon(&motion_icon, SSD1306_WIDTH - 8, 32, motion_bitmap, 8, 8);
+    ssd1306_WidgetLabel(&status_label, 0, 48, SSD1306_WIDTH, &Font_6x8);
+    ssd1306_WidgetLabel(&temp_label, 0, 0, SSD1306_WIDTH, &Font_6x8);
+    ssd1306_WidgetSparkline(&temp_sparkline, 0, 10, SSD1306_WIDTH, 20);
+    ssd1306_WidgetLabel(&press_label, 0, 32, SSD1306_WIDTH, &Font_6x8);
+    ssd1306_WidgetSparkline(&press_sparkline, 0, 42, SSD1306_WIDTH, 20);
+}
+
+static void widget_status(const screen_state_t* s, bool full) {
+    char buffer[32];
+    ssd1306_WidgetSetStatus(&header_bar, "ACCESS MONITOR", s->clock);
+    snprintf(buffer, sizeof(buffer), "UID: %s", s->uid);
+    ssd1306_WidgetSetText(&uid_label, buffer);
+    snprintf(buffer, sizeof(buffer), "PIR: %s", s->pir);
+    ssd1306_WidgetSetText(&pir_label, buffer);
+    ssd1306_WidgetSetVisible(&motion_icon, s->motion);
+    ssd1306_WidgetSetText(&status_label, s->status);
+    ssd1306_WidgetsRender(status_screen, 5, full);
+}
+
+static void widget_telemetry(const screen_state_t* s, bool full) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "DOOR T %s C", s->temp);
+    ssd1306_WidgetSetText(&temp_label, buffer);
+    ssd1306_WidgetSetPoints(&temp_sparkline, s->temp_points, s->points);
+    snprintf(buffer, sizeof(buffer), "P %s hPa", s->press);
+    ssd1306_WidgetSetText(&press_label, buffer);
+    ssd1306_WidgetSetPoints(&press_sparkline, s->press_points, s->points);
+    ssd1306_WidgetsRender(telemetry_screen, 4, full);
+}
+
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t bytes, bus_us, refreshes, sent;
+    double cpu_s;
+} cost_t;
+
+typedef void (*refresh_fn)(const screen_state_t* s, bool full);
+
+static void full_status_fn(const screen_state_t* s, bool full) {
+    (void)full;
+    full_status(s);
+}
+static void full_telemetry_fn(const screen_state_t* s, bool full) {
+    (void)full;
+    full_telemetry(s);
+}
+
+// Replays `minutes` of refreshes; the sparkline points follow a random walk
+static cost_t replay(refresh_fn fn, uint32_t minutes) {
+    cost_t c = {0};
+    static screen_state_t state;
+    screen_state_t* s = &state;
+    int32_t temp = 2200, press = 101300;
+    rng = 0x9E3779B97F4A7C15ull;
+    memset(s, 0, sizeof(*s));
+    for (uint32_t ms = 0; ms < minutes * 60000u; ms += REFRESH_MS) {
+        uint8_t points = s->points;
+        state_at(ms, s);
+        if (s->points != points && s->points > 0) {
+            // A minute closed: shift in its mean
+            temp += (int32_t)rnd(41) - 20;
+            press += (int32_t)rnd(21) - 10;
+            if (s->points == MINUTES) {
+                memmove(s->temp_points, s->temp_points + 1, (MINUTES - 1) * sizeof(int32_t));
+                memmove(s->press_points, s->press_points + 1, (MINUTES - 1) * sizeof(int32_t));
+            }
+            s->temp_points[s->points - 1] = temp;
+            s->press_points[s->points - 1] = press;
+        }
+        uint64_t bytes = i2c_bytes, bus_us = i2c_bus_us;
+        clock_t start = clock();
+        fn(s, ms == 0);
+        c.cpu_s += (double)(clock() - start) / CLOCKS_PER_SEC;
+        c.refreshes++;
+        c.sent += i2c_bytes != bytes;
+        c.bytes += i2c_bytes - bytes;
+        c.bus_us += i2c_bus_us - bus_us;
+    }
+    return c;
+}
+
+static void print_cost(const char* what, const cost_t* c) {
+    printf("  %-10s %8.1f bytes %8.2f ms bus %8.2f us CPU per refresh, %llu of %llu refreshes sent\n", what,
+           (double)c->bytes / c->refreshes, (double)c->bus_us / c->refreshes / 1000,
+           c->cpu_s * 1e6 / c->refreshes, (unsigned long long)c->sent, (unsigned long long)c->refreshes);
+}
+
+int main(int argc, char** argv) {
+    uint32_t minutes = argc > 1 ? (uint32_t)atoi(argv[1]) : 60;
+    widgets_init();
+
+    static const struct {
+        const char* name;
+        refresh_fn full, widgets;
+    } screens[] = {
+        {"status", full_status_fn, widget_status},
+        {"telemetry", full_telemetry_fn, widget_telemetry},
+    };
+    printf("%u minutes, one refresh every %d ms, I2C at %d kHz\n", (unsigned)minutes, REFRESH_MS, SSD1306_I2C_CLK);
+    for (size_t k = 0; k < sizeof(screens) / sizeof(screens[0]); k++) {
+        cost_t full = replay(screens[k].full, minutes);
+        cost_t widgets = replay(screens[k].widgets, minutes);
+        printf("%s screen:\n", screens[k].name);
+        print_cost("full frame", &full);
+        print_cost("widgets", &widgets);
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Builds the SD card emulator with the driver sources: tools/sd_emu/build.sh [out]
+# The driver includes some headers as "lib\FatFs_SPI\...", and the Pico SDK
+# headers it needs all map to pico_host.h; both kinds of stub are generated.
+# char is unsigned on the RP2040, and sd_card.c relies on it.
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$HERE/../..
+LIB=$ROOT/lib/FatFs_SPI
+OUT=${1:-$HERE/sd_emu}
+INC=$(mktemp -d)
+trap 'rm -rf "$INC"' EXIT
+
+mkdir -p "$INC/hardware" "$INC/pico"
+for h in hardware/dma.h hardware/gpio.h hardware/irq.h hardware/spi.h \
+         pico/mutex.h pico/sem.h pico/stdlib.h pico/time.h pico/types.h; do
+    echo '#include "pico_host.h"' > "$INC/$h"
+done
+for h in ff15/source/ff.h include/my_debug.h sd_driver/sd_card.h sd_driver/spi.h; do
+    printf '#include "%s"\n' "$(basename "$h")" > "$INC/lib\\FatFs_SPI\\$(echo "$h" | tr / '\\')"
+done
+
+${CC:-cc} -O2 -g -funsigned-char -Wall -Wno-format -Wno-unused-function $CFLAGS \
+    -I"$INC" -I"$HERE" -I"$LIB/sd_driver" -I"$LIB/include" -I"$LIB/ff15/source" \
+    -o "$OUT" "$HERE/sd_emu.c" "$LIB/sd_driver/sd_card.c" "$LIB/sd_driver/sd_spi.c" \
+    "$LIB/sd_driver/crc.c"
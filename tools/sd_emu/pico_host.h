@@ -0,0 +1,90 @@
+/* pico_host.h
+Just enough of the Pico SDK to build sd_card.c and sd_spi.c on a host (see
+sd_emu.c). Time is virtual: it only moves when SPI bytes are clocked or the
+test program calls emu_advance_us().
+*/
+#pragma once
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+typedef volatile uint32_t io_rw_32;
+typedef void (*irq_handler_t)(void);
+
+#define __not_in_flash_func(f) f
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+enum gpio_drive_strength {
+    GPIO_DRIVE_STRENGTH_2MA = 0,
+    GPIO_DRIVE_STRENGTH_4MA = 1,
+    GPIO_DRIVE_STRENGTH_8MA = 2,
+    GPIO_DRIVE_STRENGTH_12MA = 3
+};
+#define GPIO_OUT 1
+#define GPIO_IN 0
+#define GPIO_FUNC_SPI 1
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, int fn);
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive);
+
+typedef struct spi_inst spi_inst_t;
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+
+typedef struct { uint32_t ctrl; } dma_channel_config;
+typedef struct { int16_t permits; } semaphore_t;
+
+// One thread: a mutex that is already owned would never be released
+typedef struct {
+    bool initialized;
+    bool owned;
+} mutex_t;
+#define auto_init_mutex(name) static mutex_t name = {true, false}
+static inline void mutex_init(mutex_t *mtx) {
+    mtx->initialized = true;
+    mtx->owned = false;
+}
+static inline bool mutex_is_initialized(mutex_t *mtx) { return mtx->initialized; }
+static inline bool mutex_try_enter(mutex_t *mtx, uint32_t *owner_out) {
+    (void)owner_out;
+    if (mtx->owned) return false;
+    mtx->owned = true;
+    return true;
+}
+static inline void mutex_enter_blocking(mutex_t *mtx) {
+    assert(!mtx->owned);
+    mtx->owned = true;
+}
+static inline void mutex_exit(mutex_t *mtx) {
+    assert(mtx->owned);
+    mtx->owned = false;
+}
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback,
+                        void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+absolute_time_t get_absolute_time(void);
+void busy_wait_us(uint64_t delay_us);
+void sleep_until(absolute_time_t target);
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return t + us;
+}
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return get_absolute_time() + 1000ull * ms;
+}
+static inline int64_t absolute_time_diff_us(absolute_time_t from,
+                                            absolute_time_t to) {
+    return (int64_t)(to - from);
+}
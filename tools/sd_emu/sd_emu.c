@@ -0,0 +1,562 @@
+/*******************************************************************************
+ sd_emu - Host emulator of an SD card in SPI mode, for the SD driver
+ Build: tools/sd_emu/build.sh   (compiles sd_card.c, sd_spi.c and crc.c with it)
+ Usage: sd_emu [seed]
+
+ The card answers the commands the driver uses after initialization (CMD12,
+ CMD13, CMD16, CMD17, CMD18, CMD24, CMD25, CMD55, ACMD23, CMD59) and keeps DO
+ low while it programs, for times drawn from what SDHC cards show: a few
+ hundred microseconds to a few milliseconds per block, with an occasional
+ 100-250 ms stall. Time is virtual and advances by the SPI byte time at
+ 12.5 MHz plus a fixed cost per spi_transfer() call (or per chain, plus a
+ little per segment, for spi_transfer_chain()). That cost, and reading
+ the timer or setting an alarm, count as CPU time; waiting for a DMA transfer
+ to finish does not (the core sleeps on the semaphore).
+
+ First a random mix of asynchronous and synchronous reads and writes is
+ checked against a copy of the card. Then a producer that spends a fixed CPU
+ time per block is run with sd_write_blocks() and with sd_async_submit(), and
+ the elapsed time, the time spent on SPI transfers and the CPU time are
+ printed.
+ Exit: 0 all data matched, 1 otherwise
+*******************************************************************************/
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc.h"
+#include "hw_config.h"
+#include "sd_card.h"
+#include "spi.h"
+
+#define SECTORS 8192
+#define SS_GPIO 17
+#define BYTE_NS 640        // 8 bits at 12.5 MHz
+#define CALL_NS 3000       // spi_transfer(): DMA setup, IRQ, semaphore
+#define SEG_NS 200         // spi_transfer_chain(): filling a control block
+#define TIMER_NS 50        // get_absolute_time()
+#define ALARM_NS 2000      // add_alarm_at(), cancel_alarm(), the alarm IRQ
+#define CPU_MHZ 125
+#define SDCARD_V2HC 3      // sd_card.c: v2.x High capacity SD card
+
+/* Virtual time */
+
+static uint64_t emu_ns;
+static uint64_t spi_ns;  // Time spent in SPI transfers
+static uint64_t cpu_ns;  // Time the core was busy in the driver
+
+static struct {
+    alarm_id_t id;  // 0: free
+    uint64_t at_ns;
+    alarm_callback_t callback;
+    void *user_data;
+} alarms[4];
+static alarm_id_t last_alarm_id;
+
+static void emu_run_alarms(void) {
+    for (size_t i = 0; i < count_of(alarms); i++) {
+        if (alarms[i].id && emu_ns >= alarms[i].at_ns) {
+            alarms[i].id = 0;
+            cpu_ns += ALARM_NS;
+            alarms[i].callback(alarms[i].id, alarms[i].user_data);
+        }
+    }
+}
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback,
+                        void *user_data, bool fire_if_past) {
+    cpu_ns += ALARM_NS;
+    if (time * 1000 <= emu_ns) {
+        if (fire_if_past) callback(0, user_data);
+        return 0;
+    }
+    for (size_t i = 0; i < count_of(alarms); i++) {
+        if (!alarms[i].id) {
+            alarms[i].id = ++last_alarm_id;
+            alarms[i].at_ns = time * 1000;
+            alarms[i].callback = callback;
+            alarms[i].user_data = user_data;
+            return alarms[i].id;
+        }
+    }
+    return -1;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    cpu_ns += ALARM_NS;
+    for (size_t i = 0; i < count_of(alarms); i++) {
+        if (alarm_id > 0 && alarms[i].id == alarm_id) {
+            alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+absolute_time_t get_absolute_time(void) {
+    emu_ns += TIMER_NS;
+    cpu_ns += TIMER_NS;
+    return emu_ns / 1000;
+}
+void busy_wait_us(uint64_t delay_us) {
+    emu_ns += delay_us * 1000;
+    cpu_ns += delay_us * 1000;
+    emu_run_alarms();
+}
+void sleep_until(absolute_time_t target) {
+    cpu_ns += ALARM_NS;  // The core waits for an alarm
+    if (emu_ns < target * 1000) emu_ns = target * 1000;
+    emu_run_alarms();
+}
+static void emu_advance_us(uint64_t us) {
+    emu_ns += us * 1000;
+    emu_run_alarms();
+}
+
+static uint64_t rng = 88172645463325252ull;
+static uint32_t rnd(uint32_t lo, uint32_t hi) {  // Uniform in [lo, hi]
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return lo + (uint32_t)(rng % (hi - lo + 1));
+}
+
+/* Card */
+
+enum { MODE_NONE, MODE_WRITE1, MODE_WRITEN, MODE_READ1, MODE_READN };
+
+static struct {
+    uint8_t mem[SECTORS][512];
+    bool selected;
+    int mode;
+    bool app;               // Last command was CMD55
+    uint8_t cmd[6];
+    int cmd_len;
+    uint8_t out[520];       // Bytes queued for DO
+    int out_len, out_pos;
+    uint64_t busy_ns;       // DO low until then
+    uint64_t busy_after;    // Busy time that starts once out[] is sent
+    uint64_t data_ns;       // Read data available from then
+    uint32_t addr;          // Current block
+    uint8_t blk[514];       // Block being received, with its CRC
+    int blk_len;            // -1: waiting for the start token
+    uint32_t stalls;        // 100+ ms program times
+} card;
+
+static uint64_t program_ns(bool multi) {
+    if (rnd(1, 1000) <= 3) {
+        card.stalls++;
+        return rnd(100000, 250000) * 1000ull;
+    }
+    return (multi ? rnd(200, 1000) : rnd(500, 3000)) * 1000ull;
+}
+
+static void queue_out(const uint8_t *p, int n) {
+    memcpy(card.out + card.out_len, p, n);
+    card.out_len += n;
+}
+
+static void queue_block(void) {
+    uint8_t tok = 0xFE;
+    uint16_t crc = crc16((const char *)card.mem[card.addr], 512);
+    uint8_t crcb[2] = {crc >> 8, crc};
+    card.out_len = card.out_pos = 0;
+    queue_out(&tok, 1);
+    queue_out(card.mem[card.addr], 512);
+    queue_out(crcb, 2);
+}
+
+static void do_cmd(void) {
+    uint8_t idx = card.cmd[0] & 0x3F;
+    uint32_t arg = (uint32_t)card.cmd[1] << 24 | card.cmd[2] << 16 |
+                   card.cmd[3] << 8 | card.cmd[4];
+    uint8_t r[3] = {0xFF, 0x00, 0x00};  // Ncr, R1, 2nd byte of R2
+    int n = 2;
+    bool app = card.app;
+    card.app = false;
+    card.out_len = card.out_pos = 0;
+    switch (idx) {
+        case 55:
+            card.app = true;
+            break;
+        case 12:
+            card.mode = MODE_NONE;
+            r[0] = 0xFF;  // Stuff byte
+            r[1] = 0xFF;
+            r[2] = 0x00;
+            n = 3;
+            card.busy_after = 10000;
+            break;
+        case 13:
+            n = 3;
+            break;
+        case 16:
+        case 59:
+            break;
+        case 23:
+            if (!app) r[1] = 0x04;
+            break;
+        case 17:
+        case 18:
+        case 24:
+        case 25:
+            if (arg >= SECTORS) {
+                r[1] = 0x40;  // Parameter error
+                break;
+            }
+            card.addr = arg;
+            card.mode = idx == 17 ? MODE_READ1 : idx == 18 ? MODE_READN
+                      : idx == 24 ? MODE_WRITE1 : MODE_WRITEN;
+            card.blk_len = -1;
+            card.data_ns = emu_ns + rnd(100, 500) * 1000ull;
+            break;
+        default:
+            r[1] = 0x04;  // Illegal command
+    }
+    queue_out(r, n);
+}
+
+// One byte clocked with the card selected: DI in, DO out
+static uint8_t card_byte(uint8_t di) {
+    if (card.blk_len >= 0) {  // Receiving a data block
+        card.blk[card.blk_len++] = di;
+        if (card.blk_len == 514) {
+            uint16_t crc = crc16((const char *)card.blk, 512);
+            bool ok = crc == (card.blk[512] << 8 | card.blk[513]);
+            uint8_t resp = ok ? 0xE5 : 0xEB;
+            if (ok) memcpy(card.mem[card.addr++], card.blk, 512);
+            if (card.addr >= SECTORS) card.mode = MODE_NONE;
+            if (card.mode == MODE_WRITE1) card.mode = MODE_NONE;
+            card.blk_len = -1;
+            card.out_len = card.out_pos = 0;
+            queue_out(&resp, 1);
+            card.busy_after = program_ns(card.mode == MODE_WRITEN);
+        }
+        return 0xFF;
+    }
+    if (card.cmd_len || ((di & 0xC0) == 0x40 && card.out_pos == card.out_len &&
+                         (card.mode != MODE_WRITEN && card.mode != MODE_WRITE1))) {
+        card.cmd[card.cmd_len++] = di;
+        if (card.cmd_len == 6) {
+            card.cmd_len = 0;
+            do_cmd();
+        }
+        return 0xFF;
+    }
+    if (card.out_pos < card.out_len) {
+        uint8_t b = card.out[card.out_pos++];
+        if (card.out_pos == card.out_len && card.busy_after) {
+            card.busy_ns = emu_ns + card.busy_after;
+            card.busy_after = 0;
+        }
+        if (card.out_pos == card.out_len &&
+            (card.mode == MODE_READ1 || card.mode == MODE_READN) &&
+            card.out_len > 3) {
+            // Last byte of a data block
+            card.addr++;
+            if (card.mode == MODE_READ1 || card.addr >= SECTORS)
+                card.mode = MODE_NONE;
+            card.data_ns = emu_ns + rnd(20, 100) * 1000ull;
+        }
+        return b;
+    }
+    if (emu_ns < card.busy_ns) return 0x00;
+    switch (card.mode) {
+        case MODE_WRITE1:
+        case MODE_WRITEN:
+            if (di == (card.mode == MODE_WRITE1 ? 0xFE : 0xFC)) {
+                card.blk_len = 0;
+            } else if (di == 0xFD && card.mode == MODE_WRITEN) {
+                card.mode = MODE_NONE;
+                card.busy_ns = emu_ns + BYTE_NS + program_ns(false);
+            }
+            break;
+        case MODE_READ1:
+        case MODE_READN:
+            if (emu_ns >= card.data_ns) queue_block();
+            break;
+    }
+    return 0xFF;
+}
+
+static uint8_t bus_byte(uint8_t di) {
+    emu_ns += BYTE_NS;
+    uint8_t r = card.selected ? card_byte(di) : 0xFF;
+    emu_run_alarms();
+    return r;
+}
+
+/* Pico SDK and hardware configuration for the driver */
+
+struct spi_inst { int unused; };
+static struct spi_inst spi_hw;
+
+static spi_t spis[] = {{.hw_inst = &spi_hw, .baud_rate = 12500 * 1000}};
+static sd_card_t sd_cards[] = {{.pcName = "0:", .spi = &spis[0], .ss_gpio = SS_GPIO}};
+
+size_t sd_get_num() { return count_of(sd_cards); }
+sd_card_t *sd_get_by_num(size_t num) { return num < sd_get_num() ? &sd_cards[num] : NULL; }
+size_t spi_get_num() { return count_of(spis); }
+spi_t *spi_get_by_num(size_t num) { return num < spi_get_num() ? &spis[num] : NULL; }
+
+void gpio_init(uint gpio) { (void)gpio; }
+void gpio_set_dir(uint gpio, bool out) { (void)gpio, (void)out; }
+void gpio_put(uint gpio, bool value) {
+    if (SS_GPIO == gpio) card.selected = !value;
+}
+bool gpio_get(uint gpio) { return SS_GPIO == gpio ? !card.selected : true; }
+void gpio_pull_up(uint gpio) { (void)gpio; }
+void gpio_set_function(uint gpio, int fn) { (void)gpio, (void)fn; }
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive) { (void)gpio, (void)drive; }
+
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) { (void)spi; return baudrate; }
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    (void)spi;
+    spi_ns += len * BYTE_NS;
+    cpu_ns += len * BYTE_NS;  // The core waits on the FIFO
+    for (size_t i = 0; i < len; i++) bus_byte(src[i]);
+    return (int)len;
+}
+
+static uint64_t n_transfers;
+bool spi_transfer(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length) {
+    (void)pSPI;
+    emu_ns += CALL_NS;
+    spi_ns += CALL_NS + length * BYTE_NS;
+    cpu_ns += CALL_NS;
+    n_transfers++;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t b = bus_byte(tx ? tx[i] : 0xFF);
+        if (rx) rx[i] = b;
+    }
+    return true;
+}
+bool spi_transfer_chain(spi_t *pSPI, const spi_seg_t *segs, size_t count) {
+    (void)pSPI;
+    // One DMA program: the call cost is paid once
+    emu_ns += CALL_NS + count * SEG_NS;
+    spi_ns += CALL_NS + count * SEG_NS;
+    cpu_ns += CALL_NS + count * SEG_NS;
+    n_transfers++;
+    for (size_t s = 0; s < count; s++) {
+        spi_ns += segs[s].length * BYTE_NS;
+        for (size_t i = 0; i < segs[s].length; i++) {
+            uint8_t b = bus_byte(segs[s].tx ? segs[s].tx[i] : 0xFF);
+            if (segs[s].rx) segs[s].rx[i] = b;
+        }
+    }
+    return true;
+}
+void spi_lock(spi_t *pSPI) { mutex_enter_blocking(&pSPI->mutex); }
+void spi_unlock(spi_t *pSPI) { mutex_exit(&pSPI->mutex); }
+bool my_spi_init(spi_t *pSPI) {
+    mutex_init(&pSPI->mutex);
+    pSPI->initialized = true;
+    return true;
+}
+
+void my_printf(const char *pcFormat, ...) {
+    va_list ap;
+    va_start(ap, pcFormat);
+    vprintf(pcFormat, ap);
+    va_end(ap);
+}
+void my_assert_func(const char *file, int line, const char *func, const char *pred) {
+    printf("assertion \"%s\" failed: file \"%s\", line %d, function: %s\n", pred, file, line, func);
+    abort();
+}
+
+/* Tests */
+
+static uint8_t ref[SECTORS][512];
+static int fails;
+
+static void fill(uint8_t *p, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) p[i] = (uint8_t)rnd(0, 255);
+}
+
+static void on_done(sd_async_req_t *req) { ++*(int *)req->ctx; }
+
+// Checks a finished request against ref[], or records what it wrote
+static void check_done(const sd_async_req_t *r) {
+    if (r->status) {
+        printf("request failed: %d\n", r->status);
+        fails++;
+    } else if (r->write) {
+        memcpy(ref[r->sector], r->buffer, r->count * 512);
+    } else if (memcmp(ref[r->sector], r->buffer, r->count * 512)) {
+        printf("read mismatch at %" PRIu64 "\n", r->sector);
+        fails++;
+    }
+}
+
+// Random asynchronous and synchronous transfers, checked against ref[]
+static void check_mix(sd_card_t *pSD) {
+    static uint8_t bufs[SD_ASYNC_QUEUE_LEN][8 * 512];
+    static uint8_t rd[8 * 512];
+    sd_async_req_t reqs[SD_ASYNC_QUEUE_LEN] = {0};
+    int done = 0, submitted = 0;
+    for (int round = 0; round < 4000; round++) {
+        for (int i = 0; i < SD_ASYNC_QUEUE_LEN; i++) {
+            sd_async_req_t *r = &reqs[i];
+            if (r->buffer) {
+                if (r->status == SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK) continue;
+                check_done(r);
+            }
+            // Keep queued requests on disjoint sectors: i-th quarter of the card
+            r->write = rnd(0, 2) != 0;
+            r->count = rnd(1, 8);
+            r->sector = i * (SECTORS / SD_ASYNC_QUEUE_LEN) +
+                        rnd(0, SECTORS / SD_ASYNC_QUEUE_LEN - 16);
+            r->buffer = bufs[i];
+            r->callback = on_done;
+            r->ctx = &done;
+            if (r->write) fill(r->buffer, r->count * 512);
+            if (sd_async_submit(pSD, r)) {
+                printf("submit failed\n");
+                fails++;
+            }
+            submitted++;
+        }
+        sd_async_poll(pSD);
+        emu_advance_us(rnd(0, 300));
+        if (rnd(0, 9) == 0) {
+            // Synchronous transfer at the end of the card, around the queue
+            uint32_t n = rnd(1, 8);
+            uint64_t s = SECTORS - 8 + rnd(0, 8 - n);
+            if (rnd(0, 1)) {
+                fill(rd, n * 512);
+                if (pSD->write_blocks(pSD, rd, s, n)) fails++;
+                memcpy(ref[s], rd, n * 512);
+            } else if (pSD->read_blocks(pSD, rd, s, n) ||
+                       memcmp(rd, ref[s], n * 512)) {
+                printf("sync read mismatch at %" PRIu64 "\n", s);
+                fails++;
+            }
+        }
+    }
+    for (int i = 0; i < SD_ASYNC_QUEUE_LEN; i++) {
+        if (reqs[i].buffer) {
+            sd_async_wait(pSD, &reqs[i]);
+            check_done(&reqs[i]);
+        }
+    }
+    if (done != submitted) {
+        printf("%d callbacks for %d requests\n", done, submitted);
+        fails++;
+    }
+    if (memcmp(ref, card.mem, sizeof ref)) {
+        printf("card contents differ from the reference\n");
+        fails++;
+    }
+    printf("mixed: %d requests, %" PRIu32 " stalls, %s\n", submitted, card.stalls,
+           fails ? "FAILED" : "ok");
+}
+
+#define BENCH_CHUNKS 1000
+#define CHUNK_BLOCKS 8
+#define COMPUTE_US 600  // Per block
+#define SLICE_US 50     // The producer polls between slices of its work
+
+typedef struct {
+    uint64_t elapsed_ns;
+    uint64_t spi_ns;
+    uint64_t cpu_ns;
+    uint64_t transfers;
+    uint32_t stalls;
+} bench_t;
+
+static void bench_sync(sd_card_t *pSD) {
+    static uint8_t buf[CHUNK_BLOCKS * 512];
+    for (uint32_t c = 0; c < BENCH_CHUNKS; c++) {
+        emu_advance_us(COMPUTE_US * CHUNK_BLOCKS);
+        memset(buf, (uint8_t)c, sizeof buf);
+        if (pSD->write_blocks(pSD, buf, (uint64_t)c * CHUNK_BLOCKS, CHUNK_BLOCKS)) fails++;
+    }
+}
+
+static void bench_async(sd_card_t *pSD) {
+    enum { NBUF = 3 };
+    static uint8_t bufs[NBUF][CHUNK_BLOCKS * 512];
+    sd_async_req_t reqs[NBUF] = {0};
+    for (uint32_t c = 0; c < BENCH_CHUNKS; c++) {
+        sd_async_req_t *r = &reqs[c % NBUF];
+        // Produce the chunk, polling the card between slices of the work
+        for (uint32_t us = 0; us < COMPUTE_US * CHUNK_BLOCKS; us += SLICE_US) {
+            emu_advance_us(SLICE_US);
+            sd_async_poll(pSD);
+        }
+        if (r->buffer && sd_async_wait(pSD, r)) fails++;  // Still in flight
+        memset(bufs[c % NBUF], (uint8_t)c, sizeof bufs[0]);
+        r->write = true;
+        r->buffer = bufs[c % NBUF];
+        r->sector = (uint64_t)c * CHUNK_BLOCKS;
+        r->count = CHUNK_BLOCKS;
+        if (sd_async_submit(pSD, r)) fails++;
+    }
+    for (int i = 0; i < NBUF; i++) {
+        if (reqs[i].buffer && sd_async_wait(pSD, &reqs[i])) fails++;
+    }
+}
+
+static void run_bench(sd_card_t *pSD, void (*fn)(sd_card_t *), bench_t *b) {
+    memset(card.mem, 0xA5, sizeof card.mem);
+    card.stalls = 0;
+    uint64_t t0 = emu_ns, s0 = spi_ns, c0 = cpu_ns, n0 = n_transfers;
+    fn(pSD);
+    b->elapsed_ns = emu_ns - t0;
+    b->spi_ns = spi_ns - s0;
+    b->cpu_ns = cpu_ns - c0;
+    b->transfers = n_transfers - n0;
+    b->stalls = card.stalls;
+    for (uint32_t c = 0; c < BENCH_CHUNKS; c++) {
+        const uint8_t *p = card.mem[c * CHUNK_BLOCKS];
+        for (uint32_t i = 0; i < CHUNK_BLOCKS * 512; i++) {
+            if (p[i] != (uint8_t)c) {
+                printf("benchmark data wrong in chunk %" PRIu32 "\n", c);
+                fails++;
+                return;
+            }
+        }
+    }
+}
+
+static void print_bench(const char *name, const bench_t *b) {
+    uint32_t blocks = BENCH_CHUNKS * CHUNK_BLOCKS;
+    double elapsed = b->elapsed_ns / 1e6;
+    printf("%-6s elapsed %8.1f ms, on SPI %8.1f ms, CPU %8.1f ms, %5.0f KB/s, "
+           "%" PRIu32 " stalls\n",
+           name, elapsed, b->spi_ns / 1e6, b->cpu_ns / 1e6,
+           blocks / 2.0 / (elapsed / 1e3), b->stalls);
+    printf("       per block: %6.1f DMA programs, %7.0f CPU cycles\n",
+           (double)b->transfers / blocks, b->cpu_ns / 1e3 * CPU_MHZ / blocks);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) rng = strtoull(argv[1], NULL, 0) | 1;
+    card.blk_len = -1;
+    if (!sd_init_driver()) return 1;
+    sd_card_t *pSD = sd_get_by_num(0);
+    // Skip the power-up handshake: start with an initialized SDHC card
+    mutex_init(&pSD->mutex);
+    pSD->m_Status = 0;
+    pSD->card_type = SDCARD_V2HC;
+    pSD->sectors = SECTORS;
+
+    check_mix(pSD);
+
+    bench_t bs = {0}, ba = {0};
+    uint64_t seed = rng;
+    run_bench(pSD, bench_sync, &bs);
+    rng = seed;  // Same card latencies for both runs
+    run_bench(pSD, bench_async, &ba);
+    printf("%d chunks of %d blocks, %d us of work per block (%.1f ms in all)\n",
+           BENCH_CHUNKS, CHUNK_BLOCKS, COMPUTE_US,
+           BENCH_CHUNKS * CHUNK_BLOCKS * COMPUTE_US / 1e3);
+    print_bench("sync", &bs);
+    print_bench("async", &ba);
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ uid_frame_test - Host test and micro-benchmark of the RFID sketches' UID frame
+ Build: cc -O2 -I arduino/libraries/UidFrame -o uid_frame_test tools/uid_frame_test.c
+ Usage: uid_frame_test [iterations]
+
+ Checks encodeUidFrame() (arduino/libraries/UidFrame/UidFrame.h) against the
+ frame the sketches used to print, rebuilt here the same way: "RFID_UID:",
+ then each byte as String(b, HEX) with a "0" in front of values below 0x10,
+ then println's CRLF. Every byte value is tried at every position of 4-, 7-
+ and 10-byte UIDs, and UIDs over 10 bytes must be cut to 10.
+ Then both are timed per frame on the host. The String version is modelled
+ with a heap buffer grown per append, as Arduino's String concat does. The
+ times are host times and only indicate the ratio between the two.
+ Exit: 0 all frames matched, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "UidFrame.h"
+
+// String content = ""; content += "0"; content += String(b, HEX); ...
+typedef struct {
+    char *buf;
+    size_t len;
+} str_t;
+
+static void str_cat(str_t *s, const char *add) {
+    size_t n = strlen(add);
+    char *grown = realloc(s->buf, s->len + n + 1); // String::concat reserves len + n
+    if (!grown) exit(2);
+    s->buf = grown;
+    memcpy(s->buf + s->len, add, n + 1);
+    s->len += n;
+}
+
+static size_t string_frame(char *out, const uint8_t *uid, uint8_t size) {
+    str_t content = {NULL, 0};
+    str_cat(&content, "");
+    for (uint8_t i = 0; i < size; i++) {
+        char hex[3];
+        if (uid[i] < 0x10) str_cat(&content, "0");
+        snprintf(hex, sizeof(hex), "%x", uid[i]);
+        str_cat(&content, hex);
+    }
+    size_t n = (size_t)sprintf(out, "RFID_UID:%s\r\n", content.buf); // print + println
+    free(content.buf);
+    return n;
+}
+
+static double ns_per_frame(clock_t start, long iterations) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / iterations;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+    static const uint8_t sizes[] = {4, 7, 10};
+    char frame[UID_FRAME_SIZE], expected[64];
+    uint8_t uid[12];
+    int bad = 0;
+
+    for (size_t s = 0; s < sizeof(sizes); s++) {
+        for (uint8_t pos = 0; pos < sizes[s]; pos++) {
+            for (int v = 0; v < 256; v++) {
+                for (uint8_t i = 0; i < sizes[s]; i++) uid[i] = (uint8_t)(0x11 * (i + 1));
+                uid[pos] = (uint8_t)v;
+                uint8_t n = encodeUidFrame(frame, uid, sizes[s]);
+                size_t m = string_frame(expected, uid, sizes[s]);
+                if (n != m || memcmp(frame, expected, m) != 0) {
+                    if (bad++ < 5) printf("size %u byte %u = %02x: %.*s", sizes[s], pos, v, (int)m, expected);
+                }
+            }
+        }
+    }
+    memset(uid, 0xAB, sizeof(uid));
+    if (encodeUidFrame(frame, uid, 12) != UID_FRAME_SIZE || frame[UID_FRAME_SIZE - 3] != 'b') {
+        printf("12-byte UID not cut to 10 bytes\n");
+        bad++;
+    }
+    printf("%s: %d mismatches\n", bad ? "FAIL" : "ok", bad);
+
+    volatile uint8_t sink = 0;
+    for (size_t s = 0; s < sizeof(sizes); s++) {
+        for (uint8_t i = 0; i < sizes[s]; i++) uid[i] = (uint8_t)(i * 37 + 5);
+        clock_t start = clock();
+        for (long i = 0; i < iterations; i++) {
+            uid[0] = (uint8_t)i;
+            sink += encodeUidFrame(frame, uid, sizes[s]);
+        }
+        double fixed = ns_per_frame(start, iterations);
+        start = clock();
+        for (long i = 0; i < iterations; i++) {
+            uid[0] = (uint8_t)i;
+            sink += (uint8_t)string_frame(expected, uid, sizes[s]);
+        }
+        double string = ns_per_frame(start, iterations);
+        printf("%2u-byte UID: encodeUidFrame %6.1f ns, String concat %7.1f ns\n", sizes[s], fixed, string);
+    }
+    return bad ? 1 : 0;
+}